@@ -97,6 +97,16 @@ class DevSPI : public SPI
         frequency(frequency_hz);
     }
 
+    /*
+     * Change the number of bits per SPI frame, keeping the clock mode.
+     *
+     * @param bits         Number of bits per SPI frame (4 - 16)
+     */
+    void set_frame_bits(int bits)
+    {
+        format(bits, _mode);
+    }
+
     /**
      * @brief      Writes a buffer to the SPI peripheral device in 8-bit data mode 
      *             using synchronous SPI communication.
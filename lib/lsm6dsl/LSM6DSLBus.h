@@ -0,0 +1,169 @@
+/**
+ ******************************************************************************
+ * @file    LSM6DSLBus.h
+ * @brief   Compile-time bus policies for the LSM6DSLSensorT template.
+ ******************************************************************************
+ * A bus policy provides the register transport used by LSM6DSLSensorT:
+ *
+ *   uint8_t read(uint8_t reg, uint8_t *pBuffer, uint16_t NumByteToRead);
+ *   uint8_t write(uint8_t reg, const uint8_t *pBuffer, uint16_t NumByteToWrite);
+ *   void delay_us(uint32_t us);
+ *   uint32_t now_us(void);
+ *   static const bool spi_3wire;
+ *
+ * read() and write() return 0 if ok, an error code otherwise. now_us() is a
+ * free-running microsecond clock, allowed to wrap. Since the
+ * policy is a template argument, the transport is resolved and inlined at
+ * compile time instead of going through the void* handle of the C driver and
+ * the SPI/I2C branching of LSM6DSLSensor::io_read().
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+
+#ifndef __LSM6DSLBus_H__
+#define __LSM6DSLBus_H__
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "mbed.h"
+#include "DevI2C.h"
+#include "LSM6DSL_acc_gyro_driver.h"
+
+/* Class Declaration ---------------------------------------------------------*/
+
+/**
+ * 4-wire SPI transport: the register address is sent with the read bit set,
+ * then the data is clocked in on MISO.
+ */
+class LSM6DSLSpi4W
+{
+  public:
+    static const bool spi_3wire = false;
+
+    LSM6DSLSpi4W(SPI *spi, PinName cs_pin) : _dev_spi(spi), _cs_pin(cs_pin, 1) {}
+
+    uint8_t read(uint8_t reg, uint8_t *pBuffer, uint16_t NumByteToRead)
+    {
+        _dev_spi->lock();
+        _cs_pin = 0;
+        _dev_spi->write(reg | 0x80);
+        for (uint16_t i = 0; i < NumByteToRead; i++) {
+            pBuffer[i] = _dev_spi->write(0x00);
+        }
+        _cs_pin = 1;
+        _dev_spi->unlock();
+        return 0;
+    }
+
+    uint8_t write(uint8_t reg, const uint8_t *pBuffer, uint16_t NumByteToWrite)
+    {
+        _dev_spi->lock();
+        _cs_pin = 0;
+        _dev_spi->write(reg);
+        _dev_spi->write((const char *)pBuffer, (int) NumByteToWrite, NULL, 0);
+        _cs_pin = 1;
+        _dev_spi->unlock();
+        return 0;
+    }
+
+    void delay_us(uint32_t us)
+    {
+        wait_us((int) us);
+    }
+
+    uint32_t now_us(void)
+    {
+        return us_ticker_read();
+    }
+
+  private:
+    SPI *_dev_spi;
+    DigitalOut _cs_pin;
+};
+
+/**
+ * 3-wire SPI transport: address and data share the SDI/SDO line, the whole
+ * read is issued as a single transfer.
+ */
+class LSM6DSLSpi3W
+{
+  public:
+    static const bool spi_3wire = true;
+
+    LSM6DSLSpi3W(SPI *spi, PinName cs_pin) : _dev_spi(spi), _cs_pin(cs_pin, 1) {}
+
+    uint8_t read(uint8_t reg, uint8_t *pBuffer, uint16_t NumByteToRead)
+    {
+        const char TxByte = (char)(reg | 0x80);
+
+        _dev_spi->lock();
+        _cs_pin = 0;
+        _dev_spi->write(&TxByte, 1, (char *)pBuffer, (int) NumByteToRead);
+        _cs_pin = 1;
+        _dev_spi->unlock();
+        return 0;
+    }
+
+    uint8_t write(uint8_t reg, const uint8_t *pBuffer, uint16_t NumByteToWrite)
+    {
+        _dev_spi->lock();
+        _cs_pin = 0;
+        _dev_spi->write(reg);
+        _dev_spi->write((const char *)pBuffer, (int) NumByteToWrite, NULL, 0);
+        _cs_pin = 1;
+        _dev_spi->unlock();
+        return 0;
+    }
+
+    void delay_us(uint32_t us)
+    {
+        wait_us((int) us);
+    }
+
+    uint32_t now_us(void)
+    {
+        return us_ticker_read();
+    }
+
+  private:
+    SPI *_dev_spi;
+    DigitalOut _cs_pin;
+};
+
+/**
+ * I2C transport through the DevI2C multi-register helpers.
+ */
+class LSM6DSLI2C
+{
+  public:
+    static const bool spi_3wire = false;
+
+    LSM6DSLI2C(DevI2C *i2c, uint8_t address = LSM6DSL_ACC_GYRO_I2C_ADDRESS_HIGH) : _dev_i2c(i2c), _address(address) {}
+
+    uint8_t read(uint8_t reg, uint8_t *pBuffer, uint16_t NumByteToRead)
+    {
+        return (uint8_t) _dev_i2c->i2c_read(pBuffer, _address, reg, NumByteToRead);
+    }
+
+    uint8_t write(uint8_t reg, const uint8_t *pBuffer, uint16_t NumByteToWrite)
+    {
+        return (uint8_t) _dev_i2c->i2c_write((uint8_t *)pBuffer, _address, reg, NumByteToWrite);
+    }
+
+    void delay_us(uint32_t us)
+    {
+        wait_us((int) us);
+    }
+
+    uint32_t now_us(void)
+    {
+        return us_ticker_read();
+    }
+
+  private:
+    DevI2C *_dev_i2c;
+    uint8_t _address;
+};
+
+#endif
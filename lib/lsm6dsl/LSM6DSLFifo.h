@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * @file    LSM6DSLFifo.h
+ * @brief   FIFO definitions shared by LSM6DSLSensor and LSM6DSLSensorT.
+ ******************************************************************************
+ * The FIFO holds 2048 16-bit words. With the accelerometer data set alone the
+ * pattern is X, Y, Z: FIFO_PATTERN gives the position of the next word to be
+ * read in it, 0 on a sample boundary.
+ *
+ * An overrun in continuous mode overwrites the oldest words, and a read may
+ * then start in the middle of a sample. The drain skips the words up to the
+ * next sample boundary and counts the losses in LSM6DSL_Fifo_Stats_t.
+ *
+ * The sensor does not count the overwritten samples: an overrun is costed as
+ * the samples produced since the previous drain beyond the FIFO capacity,
+ * assuming that drain emptied the FIFO, and one sample at least.
+ *
+ * @note   This header does not depend on mbed.
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+
+#ifndef __LSM6DSLFifo_H__
+#define __LSM6DSLFifo_H__
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+#define LSM6DSL_FIFO_WORDS          2048
+#define LSM6DSL_FIFO_PATTERN_WORDS  3     /* X, Y, Z of one data set */
+#define LSM6DSL_FIFO_SAMPLES        ( LSM6DSL_FIFO_WORDS / LSM6DSL_FIFO_PATTERN_WORDS )
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef struct
+{
+  uint32_t overruns;       /* Drains finding the FIFO overrun flag set */
+  uint32_t resyncs;        /* Drains starting off a sample boundary */
+  uint32_t dropped_words;  /* Words skipped to get back on a boundary */
+  uint32_t lost_samples;   /* Estimated: overwritten samples of the overruns,
+                              plus the partial sample of each resync */
+} LSM6DSL_Fifo_Stats_t;
+
+/* Functions -----------------------------------------------------------------*/
+
+/**
+ * @brief  Estimate the samples overwritten by an overrun
+ * @param  elapsed_us time since the previous drain, 0 if unknown
+ * @param  odr the FIFO output data rate in Hz
+ * @retval the samples produced beyond the FIFO capacity, 1 at least
+ */
+static inline uint32_t LSM6DSL_Fifo_Overrun_Loss(uint32_t elapsed_us, float odr)
+{
+  float excess = (float)elapsed_us * odr / 1000000.0f - (float)LSM6DSL_FIFO_SAMPLES;
+
+  return ( excess > 1.0f ) ? (uint32_t)excess : 1;
+}
+
+#endif
@@ -41,23 +41,44 @@
 
 #include "LSM6DSLSensor.h"
 
-Serial ser(USBTX, USBRX);
-
 /* Class Implementation ------------------------------------------------------*/
 
 LSM6DSLSensor::LSM6DSLSensor(SPI *spi, PinName cs_pin, PinName int1_pin, PinName int2_pin, SPI_type_t spi_type ) : 
-                             _dev_spi(spi), _cs_pin(cs_pin), _int1_irq(int1_pin), _int2_irq(int2_pin), _spi_type(spi_type)
+                             _dev_spi(spi), _dev_spi16(NULL), _cs_pin(cs_pin), _int1_irq(int1_pin), _int2_irq(int2_pin), _spi_type(spi_type),
+                             _fifo_data(FIFO_NONE), _fifo_odr(0.0f), _fifo_drain_us(0), _fifo_word_frames(0), _bus_depth(0), _log(NULL)
+{
+    assert (spi);
+    init_spi(cs_pin);
+}
+
+/** Constructor
+ * @param spi object of the helper class which handles the SPI peripheral,
+ *        allowing 16-bit frame transfers of the FIFO content
+ * @param cs_pin the chip select pin
+ */
+LSM6DSLSensor::LSM6DSLSensor(DevSPI *spi, PinName cs_pin, PinName int1_pin, PinName int2_pin, SPI_type_t spi_type ) : 
+                             _dev_spi(spi), _dev_spi16(spi), _cs_pin(cs_pin), _int1_irq(int1_pin), _int2_irq(int2_pin), _spi_type(spi_type),
+                             _fifo_data(FIFO_NONE), _fifo_odr(0.0f), _fifo_drain_us(0), _fifo_word_frames(0), _bus_depth(0), _log(NULL)
 {
     assert (spi);
+    init_spi(cs_pin);
+}
+
+/** Set up the SPI interface, common to the SPI constructors
+ * @param cs_pin the chip select pin
+ */
+void LSM6DSLSensor::init_spi(PinName cs_pin)
+{
+    reset_fifo_stats();
+    _dev_i2c = NULL;
     if (cs_pin == NC) 
     {
-        printf ("ERROR LPS22HBSensor CS MUST NOT BE NC\n\r");       
+        printf ("ERROR LSM6DSLSensor CS MUST NOT BE NC\n\r");       
         _dev_spi = NULL;
-        _dev_i2c=NULL;
+        _dev_spi16 = NULL;
         return;
     }       
     _cs_pin = 1;    
-    _dev_i2c=NULL;
     
     if (_spi_type == SPI3W) LSM6DSL_ACC_GYRO_W_SPI_Mode((void *)this, LSM6DSL_ACC_GYRO_SIM_3_WIRE);
     else LSM6DSL_ACC_GYRO_W_SPI_Mode((void *)this, LSM6DSL_ACC_GYRO_SIM_4_WIRE);
@@ -70,10 +91,13 @@ LSM6DSLSensor::LSM6DSLSensor(SPI *spi, PinName cs_pin, PinName int1_pin, PinName
  * @param address the address of the component's instance
  */
 LSM6DSLSensor::LSM6DSLSensor(DevI2C *i2c, uint8_t address, PinName int1_pin, PinName int2_pin) :
-                             _dev_i2c(i2c), _address(address), _cs_pin(NC), _int1_irq(int1_pin), _int2_irq(int2_pin)
+                             _dev_i2c(i2c), _address(address), _cs_pin(NC), _int1_irq(int1_pin), _int2_irq(int2_pin),
+                             _fifo_data(FIFO_NONE), _fifo_odr(0.0f), _fifo_drain_us(0), _fifo_word_frames(0), _bus_depth(0), _log(NULL)
 {
+    reset_fifo_stats();
     assert (i2c);
     _dev_spi = NULL;
+    _dev_spi16 = NULL;
 }
 
 /**
@@ -83,6 +107,8 @@ LSM6DSLSensor::LSM6DSLSensor(DevI2C *i2c, uint8_t address, PinName int1_pin, Pin
  */
 int LSM6DSLSensor::init(void *init)
 {
+  BusSession session( this );
+
   /* Enable register address automatically incremented during a multiple byte
      access with a serial interface. */
   if ( LSM6DSL_ACC_GYRO_W_IF_Addr_Incr( (void *)this, LSM6DSL_ACC_GYRO_IF_INC_ENABLED ) == MEMS_ERROR )
@@ -146,17 +172,17 @@ int LSM6DSLSensor::enable_x(void)
   /* Check if the component is already enabled */
   if ( _x_is_enabled == 1 )
   {
-    ser.printf("Component already enabled.\n");
+    if ( _log ) _log->printf("Component already enabled.\n");
     return 0;
   }
   
   /* Output data rate selection. */
   if ( set_x_odr_when_enabled( _x_last_odr ) == 1 )
   {
-    ser.printf("Output data rate selection.\n");
+    if ( _log ) _log->printf("Output data rate selection.\n");
     return 1;
   }
-  ser.printf("x_is_enabled = 1.\n");
+  if ( _log ) _log->printf("x_is_enabled = 1.\n");
   _x_is_enabled = 1;
   
   return 0;
@@ -171,19 +197,19 @@ int LSM6DSLSensor::enable_g(void)
   /* Check if the component is already enabled */
   if ( _g_is_enabled == 1 )
   {
-    ser.printf("Component already enabled.\n");
+    if ( _log ) _log->printf("Component already enabled.\n");
     return 0;
   }
   
   /* Output data rate selection. */
   if ( set_g_odr_when_enabled( _g_last_odr ) == 1 )
   {
-    ser.printf("Output data rate selection.\n");
+    if ( _log ) _log->printf("Output data rate selection.\n");
     return 1;
   }
   
   _g_is_enabled = 1;
-  ser.printf("g_is_enabled = 1.\n");
+  if ( _log ) _log->printf("g_is_enabled = 1.\n");
   return 0;
 }
 
@@ -246,225 +272,1361 @@ int LSM6DSLSensor::disable_g(void)
 }
 
 /**
- * @brief  Read ID of LSM6DSL Accelerometer and Gyroscope
- * @param  p_id the pointer where the ID of the device is stored
+ * @brief  Route the LSM6DSL Accelerometer data to the FIFO in continuous mode
+ * @note   The gyroscope data set is removed from the FIFO, so that the FIFO
+ *         pattern is made of X/Y/Z accelerometer words only.
  * @retval 0 in case of success, an error code otherwise
  */
-int LSM6DSLSensor::read_id(uint8_t *id)
+int LSM6DSLSensor::enable_x_fifo(void)
 {
+  float odr = _x_last_odr;
+  BusSession session( this );
 
-  ser.printf("Read_id function.\n");
-  if(!id)
-  { 
-    ser.printf("!id\n");
+  /* Accelerometer data set in FIFO, without decimation. */
+  if ( LSM6DSL_ACC_GYRO_W_DEC_FIFO_XL( (void *)this, LSM6DSL_ACC_GYRO_DEC_FIFO_XL_NO_DECIMATION ) == MEMS_ERROR )
+  {
     return 1;
   }
 
-  /* Read WHO AM I register */
-  if ( LSM6DSL_ACC_GYRO_R_WHO_AM_I( (void *)this, id ) == MEMS_ERROR )
+  /* Gyroscope data set not in FIFO. */
+  if ( LSM6DSL_ACC_GYRO_W_DEC_FIFO_G( (void *)this, LSM6DSL_ACC_GYRO_DEC_FIFO_G_DATA_NOT_IN_FIFO ) == MEMS_ERROR )
   {
-    ser.printf("MEMS ERROR, id: 0x%X.\n", id);
     return 1;
   }
-  ser.printf("Return 0.\n");
-  return 0;
+
+  /* FIFO output data rate follows the accelerometer one. */
+  if ( _x_is_enabled == 1 )
+  {
+    if ( get_x_odr( &odr ) == 1 )
+    {
+      return 1;
+    }
+  }
+
+  if ( set_fifo_odr( odr ) == 1 )
+  {
+    return 1;
+  }
+
+  _fifo_data = FIFO_X;
+
+  return reset_fifo();
 }
 
 /**
- * @brief  Read data from LSM6DSL Accelerometer
- * @param  pData the pointer where the accelerometer data are stored
+ * @brief  Route the LSM6DSL Gyroscope data to the FIFO in continuous mode
+ * @note   The accelerometer data set is removed from the FIFO, so that the FIFO
+ *         pattern is made of X/Y/Z gyroscope words only.
  * @retval 0 in case of success, an error code otherwise
  */
-int LSM6DSLSensor::get_x_axes(int32_t *pData)
+int LSM6DSLSensor::enable_g_fifo(void)
 {
-  int16_t dataRaw[3];
-  float sensitivity = 0;
-  
-  /* Read raw data from LSM6DSL output register. */
-  if ( get_x_axes_raw( dataRaw ) == 1 )
+  float odr = _g_last_odr;
+  BusSession session( this );
+
+  /* Gyroscope data set in FIFO, without decimation. */
+  if ( LSM6DSL_ACC_GYRO_W_DEC_FIFO_G( (void *)this, LSM6DSL_ACC_GYRO_DEC_FIFO_G_NO_DECIMATION ) == MEMS_ERROR )
   {
     return 1;
   }
-  
-  /* Get LSM6DSL actual sensitivity. */
-  if ( get_x_sensitivity( &sensitivity ) == 1 )
+
+  /* Accelerometer data set not in FIFO. */
+  if ( LSM6DSL_ACC_GYRO_W_DEC_FIFO_XL( (void *)this, LSM6DSL_ACC_GYRO_DEC_FIFO_XL_DATA_NOT_IN_FIFO ) == MEMS_ERROR )
   {
     return 1;
   }
-  
-  /* Calculate the data. */
-  pData[0] = ( int32_t )( dataRaw[0] * sensitivity );
-  pData[1] = ( int32_t )( dataRaw[1] * sensitivity );
-  pData[2] = ( int32_t )( dataRaw[2] * sensitivity );
-  
+
+  /* FIFO output data rate follows the gyroscope one. */
+  if ( _g_is_enabled == 1 )
+  {
+    if ( get_g_odr( &odr ) == 1 )
+    {
+      return 1;
+    }
+  }
+
+  if ( set_fifo_odr( odr ) == 1 )
+  {
+    return 1;
+  }
+
+  _fifo_data = FIFO_G;
+
+  return reset_fifo();
+}
+
+/**
+ * @brief  Put the LSM6DSL FIFO back in bypass mode
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::disable_fifo(void)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_MODE( (void *)this, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_DEC_FIFO_XL( (void *)this, LSM6DSL_ACC_GYRO_DEC_FIFO_XL_DATA_NOT_IN_FIFO ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_DEC_FIFO_G( (void *)this, LSM6DSL_ACC_GYRO_DEC_FIFO_G_DATA_NOT_IN_FIFO ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  _fifo_data = FIFO_NONE;
+
   return 0;
 }
 
 /**
- * @brief  Read data from LSM6DSL Gyroscope
- * @param  pData the pointer where the gyroscope data are stored
+ * @brief  Discard the LSM6DSL FIFO content and restart the continuous acquisition
  * @retval 0 in case of success, an error code otherwise
  */
-int LSM6DSLSensor::get_g_axes(int32_t *pData)
+int LSM6DSLSensor::reset_fifo(void)
 {
-  int16_t dataRaw[3];
-  float sensitivity = 0;
-  
-  /* Read raw data from LSM6DSL output register. */
-  if ( get_g_axes_raw( dataRaw ) == 1 )
+  BusSession session( this );
+
+  if ( _fifo_data == FIFO_NONE )
   {
     return 1;
   }
-  
-  /* Get LSM6DSL actual sensitivity. */
-  if ( get_g_sensitivity( &sensitivity ) == 1 )
+
+  /* Going through bypass mode empties the FIFO. */
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_MODE( (void *)this, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS ) == MEMS_ERROR )
   {
     return 1;
   }
-  
-  /* Calculate the data. */
-  pData[0] = ( int32_t )( dataRaw[0] * sensitivity );
-  pData[1] = ( int32_t )( dataRaw[1] * sensitivity );
-  pData[2] = ( int32_t )( dataRaw[2] * sensitivity );
-  
+
+  /* Continuous mode is FIFO_MODE = 110b on LSM6DSL, i.e. DYN_STREAM_2. */
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_MODE( (void *)this, LSM6DSL_ACC_GYRO_FIFO_MODE_DYN_STREAM_2 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  _fifo_drain_us = us_ticker_read();
+
   return 0;
 }
 
 /**
- * @brief  Read Accelerometer Sensitivity
- * @param  pfData the pointer where the accelerometer sensitivity is stored
+ * @brief  Freeze the LSM6DSL FIFO on a wake-up event: the FIFO runs in
+ *         continuous-to-FIFO mode and stops being overwritten when the
+ *         acceleration slope exceeds the threshold, holding the history
+ *         that led to the event
+ * @param  thr the wake-up threshold, in FS/64 units
+ * @param  pin the interrupt pin signaling the event
  * @retval 0 in case of success, an error code otherwise
+ * @note   The data set is the one selected by enable_x_fifo(). Output data
+ *         rate and full scale are left unchanged.
  */
-int LSM6DSLSensor::get_x_sensitivity(float *pfData)
+int LSM6DSLSensor::enable_fifo_trigger(uint8_t thr, LSM6DSL_Interrupt_Pin_t pin)
 {
-  LSM6DSL_ACC_GYRO_FS_XL_t fullScale;
-  
-  /* Read actual full scale selection from sensor. */
-  if ( LSM6DSL_ACC_GYRO_R_FS_XL( (void *)this, &fullScale ) == MEMS_ERROR )
+  BusSession session( this );
+
+  if ( _fifo_data == FIFO_NONE )
   {
     return 1;
   }
-  
-  /* Store the sensitivity based on actual full scale. */
-  switch( fullScale )
+
+  /* Event as soon as one sample exceeds the threshold. */
+  if ( LSM6DSL_ACC_GYRO_W_WAKE_DUR( (void *)this, 0x00 ) == MEMS_ERROR )
   {
-    case LSM6DSL_ACC_GYRO_FS_XL_2g:
-      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_2G;
-      break;
-    case LSM6DSL_ACC_GYRO_FS_XL_4g:
-      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_4G;
-      break;
-    case LSM6DSL_ACC_GYRO_FS_XL_8g:
-      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_8G;
-      break;
-    case LSM6DSL_ACC_GYRO_FS_XL_16g:
-      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_16G;
-      break;
-    default:
-      *pfData = -1.0f;
+    return 1;
+  }
+
+  if ( set_wake_up_threshold( thr ) == 1 )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_BASIC_INT( (void *)this, LSM6DSL_ACC_GYRO_BASIC_INT_ENABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( enable_fifo_trigger_irq( pin ) == 1 )
+  {
+    return 1;
+  }
+
+  return arm_fifo_trigger();
+}
+
+/**
+ * @brief  Signal the wake-up event that freezes the LSM6DSL FIFO on a pin
+ * @param  pin the interrupt pin to be used
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::enable_fifo_trigger_irq(LSM6DSL_Interrupt_Pin_t pin)
+{
+  BusSession session( this );
+
+  switch (pin)
+  {
+  case LSM6DSL_INT1_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_WUEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_WU_ENABLED ) == MEMS_ERROR )
+    {
       return 1;
+    }
+    break;
+
+  case LSM6DSL_INT2_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_WUEvOnInt2( (void *)this, LSM6DSL_ACC_GYRO_INT2_WU_ENABLED ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    break;
+
+  default:
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Stop signaling the wake-up event on both pins, the trigger being
+ *         left configured
+ * @retval 0 in case of success, an error code otherwise
+ * @note   The core is no longer woken by strums, see enable_fifo_trigger_irq()
+ *         to route the event back.
+ */
+int LSM6DSLSensor::disable_fifo_trigger_irq(void)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_WUEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_WU_DISABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_WUEvOnInt2( (void *)this, LSM6DSL_ACC_GYRO_INT2_WU_DISABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Stop freezing the LSM6DSL FIFO on events, back to continuous mode
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::disable_fifo_trigger(void)
+{
+  BusSession session( this );
+
+  if ( disable_wake_up_detection() == 1 )
+  {
+    return 1;
+  }
+
+  return reset_fifo();
+}
+
+/**
+ * @brief  Empty the LSM6DSL FIFO and wait for the next event
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::arm_fifo_trigger(void)
+{
+  BusSession session( this );
+
+  if ( _fifo_data == FIFO_NONE )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_MODE( (void *)this, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_MODE( (void *)this, LSM6DSL_ACC_GYRO_FIFO_MODE_STF ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  _fifo_drain_us = us_ticker_read();
+
+  return 0;
+}
+
+/**
+ * @brief  Resume the acquisition after an event, keeping the frozen history
+ *         in the LSM6DSL FIFO
+ * @retval 0 in case of success, an error code otherwise
+ * @note   New samples overwrite the oldest ones of the full FIFO until it
+ *         is read.
+ */
+int LSM6DSLSensor::release_fifo_trigger(void)
+{
+  if ( _fifo_data == FIFO_NONE )
+  {
+    return 1;
+  }
+
+  /* Continuous mode is FIFO_MODE = 110b on LSM6DSL, i.e. DYN_STREAM_2. */
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_MODE( (void *)this, LSM6DSL_ACC_GYRO_FIFO_MODE_DYN_STREAM_2 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Get the number of complete X/Y/Z samples waiting in the LSM6DSL FIFO
+ * @param  samples the pointer where the number of samples is stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_fifo_samples(size_t *samples)
+{
+  u16_t words = 0;
+
+  if ( LSM6DSL_ACC_GYRO_R_FIFONumOfEntries( (void *)this, &words ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  *samples = words / 3;
+
+  return 0;
+}
+
+/**
+ * @brief  Get the LSM6DSL FIFO losses counted since the last reset
+ * @param  stats the pointer where the counters are stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_fifo_stats(LSM6DSL_Fifo_Stats_t *stats)
+{
+  *stats = _fifo_stats;
+
+  return 0;
+}
+
+/**
+ * @brief  Clear the LSM6DSL FIFO loss counters
+ * @retval None
+ */
+void LSM6DSLSensor::reset_fifo_stats(void)
+{
+  memset( (void *)&_fifo_stats, 0, sizeof( _fifo_stats ) );
+}
+
+/**
+ * @brief  Read the LSM6DSL FIFO status, counting overruns, and realign the
+ *         FIFO output on a sample boundary
+ * @param  samples the pointer where the number of complete samples is stored
+ * @retval 0 in case of success, an error code otherwise
+ * @note   The FIFO keeps running: a misaligned read drops the words of the
+ *         partial sample only, the FIFO is not reset.
+ * @note   The samples lost to an overrun are estimated from the time since
+ *         the previous call, see LSM6DSL_Fifo_Overrun_Loss().
+ */
+int LSM6DSLSensor::read_fifo_status(size_t *samples)
+{
+  uint8_t status[4] = {0, 0, 0, 0};
+  uint8_t discard[2 * LSM6DSL_FIFO_PATTERN_WORDS];
+  uint16_t words, pattern, skip;
+  uint32_t now;
+
+  /* FIFO_STATUS1 to FIFO_STATUS4 in one burst. */
+  if ( LSM6DSL_ACC_GYRO_read_reg( (void *)this, LSM6DSL_ACC_GYRO_FIFO_STATUS1, status, 4 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  now = us_ticker_read();
+
+  words = ( uint16_t )( ( ( status[1] & LSM6DSL_ACC_GYRO_DIFF_FIFO_STATUS2_MASK ) << 8 ) | status[0] );
+  pattern = ( uint16_t )( ( ( status[3] & 0x03 ) << 8 ) | status[2] );
+
+  if ( status[1] & LSM6DSL_ACC_GYRO_OVERRUN_MASK )
+  {
+    _fifo_stats.overruns++;
+    _fifo_stats.lost_samples += LSM6DSL_Fifo_Overrun_Loss( _fifo_drain_us ? now - _fifo_drain_us : 0, _fifo_odr );
+  }
+
+  if ( pattern != 0 && words > 0 )
+  {
+    skip = ( uint16_t )( LSM6DSL_FIFO_PATTERN_WORDS - pattern );
+    skip = ( skip < words ) ? skip : words;
+
+    if ( LSM6DSL_ACC_GYRO_read_reg( (void *)this, LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L, discard, ( u16_t )( 2 * skip ) ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+
+    _fifo_stats.resyncs++;
+    _fifo_stats.dropped_words += skip;
+    _fifo_stats.lost_samples++;  /* The partial sample */
+    words -= skip;
+  }
+
+  _fifo_drain_us = now;
+  *samples = words / LSM6DSL_FIFO_PATTERN_WORDS;
+
+  return 0;
+}
+
+/**
+ * @brief  Select 16-bit SPI frames for the FIFO payload
+ * @param  enable true to read the FIFO with one frame per word, false for
+ *         one frame per byte
+ * @retval 0 in case of success, an error code otherwise
+ * @note   Needs the sensor to be built on a DevSPI in 4-wire mode.
+ */
+int LSM6DSLSensor::set_fifo_word_frames(bool enable)
+{
+  if ( enable && ( !_dev_spi16 || _spi_type != SPI4W ) )
+  {
+    return 1;
+  }
+
+  _fifo_word_frames = enable ? 1 : 0;
+
+  return 0;
+}
+
+/**
+ * @brief  Set the LSM6DSL FIFO threshold
+ * @param  samples the number of X/Y/Z samples raising the watermark flag
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::set_fifo_watermark(size_t samples)
+{
+  if ( samples == 0 || samples > 682 )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_Watermark( (void *)this, (u16_t)( samples * 3 ) ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Enable the FIFO threshold interrupt
+ * @param  pin the interrupt pin to be used
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::enable_fifo_watermark_irq(LSM6DSL_Interrupt_Pin_t pin)
+{
+  BusSession session( this );
+
+  switch (pin)
+  {
+  case LSM6DSL_INT1_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_FIFO_TSHLD_on_INT1( (void *)this, LSM6DSL_ACC_GYRO_INT1_FTH_ENABLED ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    break;
+
+  case LSM6DSL_INT2_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_FIFO_TSHLD_on_INT2( (void *)this, LSM6DSL_ACC_GYRO_INT2_FTH_ENABLED ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    break;
+
+  default:
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Disable the FIFO threshold interrupt on both pins
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::disable_fifo_watermark_irq(void)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_TSHLD_on_INT1( (void *)this, LSM6DSL_ACC_GYRO_INT1_FTH_DISABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_FIFO_TSHLD_on_INT2( (void *)this, LSM6DSL_ACC_GYRO_INT2_FTH_DISABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Enable the FIFO overrun interrupt
+ * @param  pin the interrupt pin to be used
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::enable_fifo_overrun_irq(LSM6DSL_Interrupt_Pin_t pin)
+{
+  BusSession session( this );
+
+  switch (pin)
+  {
+  case LSM6DSL_INT1_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_OVERRUN_on_INT1( (void *)this, LSM6DSL_ACC_GYRO_INT1_OVR_ENABLED ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    break;
+
+  case LSM6DSL_INT2_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_OVERRUN_on_INT2( (void *)this, LSM6DSL_ACC_GYRO_INT2_OVR_ENABLED ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    break;
+
+  default:
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Disable the FIFO overrun interrupt on both pins
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::disable_fifo_overrun_irq(void)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_OVERRUN_on_INT1( (void *)this, LSM6DSL_ACC_GYRO_INT1_OVR_DISABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_OVERRUN_on_INT2( (void *)this, LSM6DSL_ACC_GYRO_INT2_OVR_DISABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Latch the embedded function interrupts (free-fall, wake-up, tap,
+ *         6D), the pins staying active until get_event_status() reads the
+ *         event sources
+ * @retval 0 in case of success, an error code otherwise
+ * @note   FIFO interrupts follow the FIFO level and are not latched.
+ */
+int LSM6DSLSensor::enable_latched_irq(void)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_LIR( (void *)this, LSM6DSL_ACC_GYRO_LIR_ENABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Back to pulsed embedded function interrupts
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::disable_latched_irq(void)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_LIR( (void *)this, LSM6DSL_ACC_GYRO_LIR_DISABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Set LSM6DSL Accelerometer output data rate and full scale with a
+ *         single CTRL1_XL write, so that no sample is produced with only
+ *         one of them changed
+ * @param  odr the output data rate to be set
+ * @param  fullScale the full scale to be set
+ * @retval 0 in case of success, an error code otherwise
+ * @note   The FIFO output data rate follows, as with set_x_odr().
+ */
+int LSM6DSLSensor::set_x_odr_fs(float odr, float fullScale)
+{
+  uint8_t ctrl1_xl = 0, odr_bits, fs_bits;
+  BusSession session( this );
+
+  if ( _x_is_enabled == 0 )
+  {
+    if ( set_x_odr_when_disabled( odr ) == 1 )
+    {
+      return 1;
+    }
+
+    return set_x_fs( fullScale );
+  }
+
+  odr_bits = ( odr <=   13.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_13Hz
+           : ( odr <=   26.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_26Hz
+           : ( odr <=   52.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_52Hz
+           : ( odr <=  104.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_104Hz
+           : ( odr <=  208.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_208Hz
+           : ( odr <=  416.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_416Hz
+           : ( odr <=  833.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_833Hz
+           : ( odr <= 1660.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_1660Hz
+           : ( odr <= 3330.0f ) ? LSM6DSL_ACC_GYRO_ODR_XL_3330Hz
+           :                      LSM6DSL_ACC_GYRO_ODR_XL_6660Hz;
+
+  fs_bits = ( fullScale <= 2.0f ) ? LSM6DSL_ACC_GYRO_FS_XL_2g
+          : ( fullScale <= 4.0f ) ? LSM6DSL_ACC_GYRO_FS_XL_4g
+          : ( fullScale <= 8.0f ) ? LSM6DSL_ACC_GYRO_FS_XL_8g
+          :                         LSM6DSL_ACC_GYRO_FS_XL_16g;
+
+  if ( read_reg( LSM6DSL_ACC_GYRO_CTRL1_XL, &ctrl1_xl ) != 0 )
+  {
+    return 1;
+  }
+
+  ctrl1_xl &= ( uint8_t )~( LSM6DSL_ACC_GYRO_ODR_XL_MASK | LSM6DSL_ACC_GYRO_FS_XL_MASK );
+  ctrl1_xl |= ( uint8_t )( odr_bits | fs_bits );
+
+  if ( write_reg( LSM6DSL_ACC_GYRO_CTRL1_XL, ctrl1_xl ) != 0 )
+  {
+    return 1;
+  }
+
+  if ( _fifo_data == FIFO_X )
+  {
+    if ( set_fifo_odr( odr ) == 1 )
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Set the LSM6DSL FIFO output data rate
+ * @param  odr the output data rate of the data set stored in FIFO
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::set_fifo_odr(float odr)
+{
+  LSM6DSL_ACC_GYRO_ODR_FIFO_t new_odr;
+
+  new_odr = ( odr <=   13.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_10Hz
+          : ( odr <=   26.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_25Hz
+          : ( odr <=   52.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_50Hz
+          : ( odr <=  104.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_100Hz
+          : ( odr <=  208.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_200Hz
+          : ( odr <=  416.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_400Hz
+          : ( odr <=  833.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_800Hz
+          : ( odr <= 1660.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_1600Hz
+          : ( odr <= 3330.0f ) ? LSM6DSL_ACC_GYRO_ODR_FIFO_3300Hz
+          :                      LSM6DSL_ACC_GYRO_ODR_FIFO_6600Hz;
+
+  if ( LSM6DSL_ACC_GYRO_W_ODR_FIFO( (void *)this, new_odr ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  _fifo_odr = odr;
+
+  return 0;
+}
+
+/**
+ * @brief  Read ID of LSM6DSL Accelerometer and Gyroscope
+ * @param  p_id the pointer where the ID of the device is stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::read_id(uint8_t *id)
+{
+
+  if ( _log ) _log->printf("Read_id function.\n");
+  if(!id)
+  { 
+    if ( _log ) _log->printf("!id\n");
+    return 1;
+  }
+
+  /* Read WHO AM I register */
+  if ( LSM6DSL_ACC_GYRO_R_WHO_AM_I( (void *)this, id ) == MEMS_ERROR )
+  {
+    if ( _log ) _log->printf("MEMS ERROR, id: 0x%X.\n", *id);
+    return 1;
+  }
+  if ( _log ) _log->printf("Return 0.\n");
+  return 0;
+}
+
+/**
+ * @brief  Read data from LSM6DSL Accelerometer
+ * @param  pData the pointer where the accelerometer data are stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_x_axes(int32_t *pData)
+{
+  int16_t dataRaw[3];
+  float sensitivity = 0;
+  
+  /* Read raw data from LSM6DSL output register. */
+  if ( get_x_axes_raw( dataRaw ) == 1 )
+  {
+    return 1;
+  }
+  
+  /* Get LSM6DSL actual sensitivity. */
+  if ( get_x_sensitivity( &sensitivity ) == 1 )
+  {
+    return 1;
+  }
+  
+  /* Calculate the data. */
+  pData[0] = ( int32_t )( dataRaw[0] * sensitivity );
+  pData[1] = ( int32_t )( dataRaw[1] * sensitivity );
+  pData[2] = ( int32_t )( dataRaw[2] * sensitivity );
+  
+  return 0;
+}
+
+/**
+ * @brief  Read data from LSM6DSL Gyroscope
+ * @param  pData the pointer where the gyroscope data are stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_g_axes(int32_t *pData)
+{
+  int16_t dataRaw[3];
+  float sensitivity = 0;
+  
+  /* Read raw data from LSM6DSL output register. */
+  if ( get_g_axes_raw( dataRaw ) == 1 )
+  {
+    return 1;
+  }
+  
+  /* Get LSM6DSL actual sensitivity. */
+  if ( get_g_sensitivity( &sensitivity ) == 1 )
+  {
+    return 1;
+  }
+  
+  /* Calculate the data. */
+  pData[0] = ( int32_t )( dataRaw[0] * sensitivity );
+  pData[1] = ( int32_t )( dataRaw[1] * sensitivity );
+  pData[2] = ( int32_t )( dataRaw[2] * sensitivity );
+  
+  return 0;
+}
+
+/**
+ * @brief  Read Accelerometer Sensitivity
+ * @param  pfData the pointer where the accelerometer sensitivity is stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_x_sensitivity(float *pfData)
+{
+  LSM6DSL_ACC_GYRO_FS_XL_t fullScale;
+  
+  /* Read actual full scale selection from sensor. */
+  if ( LSM6DSL_ACC_GYRO_R_FS_XL( (void *)this, &fullScale ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+  
+  /* Store the sensitivity based on actual full scale. */
+  switch( fullScale )
+  {
+    case LSM6DSL_ACC_GYRO_FS_XL_2g:
+      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_2G;
+      break;
+    case LSM6DSL_ACC_GYRO_FS_XL_4g:
+      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_4G;
+      break;
+    case LSM6DSL_ACC_GYRO_FS_XL_8g:
+      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_8G;
+      break;
+    case LSM6DSL_ACC_GYRO_FS_XL_16g:
+      *pfData = ( float )LSM6DSL_ACC_SENSITIVITY_FOR_FS_16G;
+      break;
+    default:
+      *pfData = -1.0f;
+      return 1;
+  }
+  
+  return 0;
+}
+
+/**
+ * @brief  Read Gyroscope Sensitivity
+ * @param  pfData the pointer where the gyroscope sensitivity is stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_g_sensitivity(float *pfData)
+{
+  LSM6DSL_ACC_GYRO_FS_125_t fullScale125;
+  LSM6DSL_ACC_GYRO_FS_G_t   fullScale;
+  
+  /* Read full scale 125 selection from sensor. */
+  if ( LSM6DSL_ACC_GYRO_R_FS_125( (void *)this, &fullScale125 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+  
+  if ( fullScale125 == LSM6DSL_ACC_GYRO_FS_125_ENABLED )
+  {
+    *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_125DPS;
+  }
+  
+  else
+  {
+  
+    /* Read actual full scale selection from sensor. */
+    if ( LSM6DSL_ACC_GYRO_R_FS_G( (void *)this, &fullScale ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    
+    /* Store the sensitivity based on actual full scale. */
+    switch( fullScale )
+    {
+      case LSM6DSL_ACC_GYRO_FS_G_245dps:
+        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_245DPS;
+        break;
+      case LSM6DSL_ACC_GYRO_FS_G_500dps:
+        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_500DPS;
+        break;
+      case LSM6DSL_ACC_GYRO_FS_G_1000dps:
+        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_1000DPS;
+        break;
+      case LSM6DSL_ACC_GYRO_FS_G_2000dps:
+        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_2000DPS;
+        break;
+      default:
+        *pfData = -1.0f;
+        return 1;
+    }
+  }
+  
+  return 0;
+}
+
+/**
+ * @brief  Read raw data from LSM6DSL Accelerometer
+ * @param  pData the pointer where the accelerometer raw data are stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_x_axes_raw(int16_t *pData)
+{
+  uint8_t regValue[6] = {0, 0, 0, 0, 0, 0};
+  
+  /* Read output registers from LSM6DSL_ACC_GYRO_OUTX_L_XL to LSM6DSL_ACC_GYRO_OUTZ_H_XL. */
+  if ( LSM6DSL_ACC_GYRO_GetRawAccData( (void *)this, regValue ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+  
+  /* Format the data. */
+  pData[0] = ( ( ( ( int16_t )regValue[1] ) << 8 ) + ( int16_t )regValue[0] );
+  pData[1] = ( ( ( ( int16_t )regValue[3] ) << 8 ) + ( int16_t )regValue[2] );
+  pData[2] = ( ( ( ( int16_t )regValue[5] ) << 8 ) + ( int16_t )regValue[4] );
+  
+  return 0;
+}
+
+/**
+ * @brief  Read the LSM6DSL temperature sensor
+ * @param  pf_data the pointer where the temperature in degrees Celsius is stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_temperature(float *pf_data)
+{
+  uint8_t regValue[2] = {0, 0};
+  int16_t raw;
+
+  if ( LSM6DSL_ACC_GYRO_read_reg( (void *)this, LSM6DSL_ACC_GYRO_OUT_TEMP_L, regValue, 2 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  /* 256 LSB/degC, 0 at 25 degC */
+  raw = ( ( ( ( int16_t )regValue[1] ) << 8 ) + ( int16_t )regValue[0] );
+  *pf_data = 25.0f + ( float )raw / 256.0f;
+
+  return 0;
+}
+
+/**
+ * @brief  Set the LSM6DSL accelerometer user offset, removed by the sensor
+ *         from the output registers and the FIFO data
+ * @param  offset the offset on x, y and z in mg
+ * @retval 0 in case of success, an error code otherwise
+ * @note   The weight is 2^-10 g/LSB up to 124 mg, 2^-6 g/LSB above. Values
+ *         are limited to the +/-127 LSB of the offset registers.
+ */
+int LSM6DSLSensor::set_x_user_offset(const float *offset)
+{
+  LSM6DSL_ACC_GYRO_USR_OFF_W_t weight = LSM6DSL_ACC_GYRO_2Emin10;
+  float lsb = 1000.0f / 1024.0f;
+  float value;
+  uint8_t regValue[3];
+  int i;
+  BusSession session( this );
+
+  for ( i = 0; i < 3; i++ )
+  {
+    if ( offset[i] > 127 * lsb || offset[i] < -127 * lsb )
+    {
+      weight = LSM6DSL_ACC_GYRO_2Emin6;
+      lsb = 1000.0f / 64.0f;
+    }
+  }
+
+  for ( i = 0; i < 3; i++ )
+  {
+    value = offset[i] / lsb;
+    value = ( value > 127.0f ) ? 127.0f : ( value < -127.0f ) ? -127.0f : value;
+    regValue[i] = ( uint8_t )( int8_t )( value < 0.0f ? value - 0.5f : value + 0.5f );
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_UserOffsetWeight( (void *)this, weight ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_write_reg( (void *)this, LSM6DSL_ACC_GYRO_X_OFS_USR, regValue, 3 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Read raw data from LSM6DSL Gyroscope
+ * @param  pData the pointer where the gyroscope raw data are stored
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_g_axes_raw(int16_t *pData)
+{
+  uint8_t regValue[6] = {0, 0, 0, 0, 0, 0};
+  
+  /* Read output registers from LSM6DSL_ACC_GYRO_OUTX_L_G to LSM6DSL_ACC_GYRO_OUTZ_H_G. */
+  if ( LSM6DSL_ACC_GYRO_GetRawGyroData( (void *)this, regValue ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+  
+  /* Format the data. */
+  pData[0] = ( ( ( ( int16_t )regValue[1] ) << 8 ) + ( int16_t )regValue[0] );
+  pData[1] = ( ( ( ( int16_t )regValue[3] ) << 8 ) + ( int16_t )regValue[2] );
+  pData[2] = ( ( ( ( int16_t )regValue[5] ) << 8 ) + ( int16_t )regValue[4] );
+  
+  return 0;
+}
+
+/**
+ * @brief  Read a block of raw data from LSM6DSL Accelerometer
+ * @param  pData the pointer where the accelerometer raw X/Y/Z triplets are stored
+ * @param  n the number of samples to read
+ * @param  got the pointer where the number of samples actually read is stored
+ * @note   When the accelerometer data set is routed to the FIFO the block is
+ *         drained in bursts, otherwise one sample is read per transaction.
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::read_x_block(int16_t *pData, size_t n, size_t *got)
+{
+  if ( _fifo_data != FIFO_X )
+  {
+    return MotionSensor::read_x_block( pData, n, got );
+  }
+
+  return read_fifo_block( pData, n, got );
+}
+
+/**
+ * @brief  Read a block of raw data from LSM6DSL Gyroscope
+ * @param  pData the pointer where the gyroscope raw X/Y/Z triplets are stored
+ * @param  n the number of samples to read
+ * @param  got the pointer where the number of samples actually read is stored
+ * @note   When the gyroscope data set is routed to the FIFO the block is
+ *         drained in bursts, otherwise one sample is read per transaction.
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::read_g_block(int16_t *pData, size_t n, size_t *got)
+{
+  if ( _fifo_data != FIFO_G )
+  {
+    return GyroSensor::read_g_block( pData, n, got );
+  }
+
+  return read_fifo_block( pData, n, got );
+}
+
+/**
+ * @brief  Drain X/Y/Z samples from the LSM6DSL FIFO
+ * @param  pData the pointer where the raw X/Y/Z triplets are stored
+ * @param  n the number of samples to read
+ * @param  got the pointer where the number of samples actually read is stored
+ * @note   Blocks until n samples have been read. Each available chunk is read
+ *         with a single burst, FIFO_DATA_OUT being rolled back automatically.
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::read_fifo_block(int16_t *pData, size_t n, size_t *got)
+{
+  size_t available, chunk, remaining, i;
+  uint8_t *bytes;
+  int16_t *words;
+
+  *got = 0;
+
+  while ( *got < n )
+  {
+    if ( read_fifo_status( &available ) == 1 )
+    {
+      return 1;
+    }
+
+    remaining = n - *got;
+
+    if ( available == 0 )
+    {
+      /* Give the sensor time to produce data instead of polling the bus,
+         without letting the FIFO (682 samples deep) fill up. */
+      chunk = ( remaining < 256 ) ? remaining : 256;
+      wait_us( (int)( chunk * 1000000.0f / _fifo_odr ) );
+      continue;
+    }
+
+    chunk = ( available < remaining ) ? available : remaining;
+    words = pData + ( 3 * *got );
+    bytes = (uint8_t *)words;
+
+    if ( _fifo_word_frames )
+    {
+      if ( io_read_words( (uint16_t *)words, LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L, (uint16_t)( chunk * 3 ) ) != 0 )
+      {
+        return 1;
+      }
+
+      *got += chunk;
+      continue;
+    }
+
+    if ( LSM6DSL_ACC_GYRO_read_reg( (void *)this, LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L, bytes, (u16_t)( chunk * 6 ) ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+
+    /* Format the data in place, each word being sent LSB first. */
+    for ( i = 0; i < chunk * 3; i++ )
+    {
+      words[i] = ( ( ( ( int16_t )bytes[2 * i + 1] ) << 8 ) + ( int16_t )bytes[2 * i] );
+    }
+
+    *got += chunk;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Read consecutive samples from the LSM6DSL Accelerometer output
+ *         registers, without the FIFO
+ * @param  pData the pointer where the raw X/Y/Z triplets are stored
+ * @param  n the number of samples to read
+ * @param  got the pointer where the number of samples actually read is stored
+ * @param  stats the pointer where the bus usage is added, NULL if not needed
+ * @note   Blocks for n samples at the accelerometer output data rate. With
+ *         SPI 4-wire, circular burst (rounding on the accelerometer block of
+ *         CTRL5_C) wraps the address from OUTZ_H_XL back to OUTX_L_XL, so that
+ *         up to LSM6DSL_STREAM_CHUNK samples are read within one chip select
+ *         assertion after a single address byte. Each chunk starts on a fresh
+ *         sample found by polling XLDA, the next ones are clocked half an ODR
+ *         period after their update is due. The period is that of the sensor
+ *         oscillator, measured on the MCU timer between the XLDA edges that
+ *         start the chunks: the first chunk, on the nominal ODR, is kept to
+ *         LSM6DSL_STREAM_FIRST samples so that an ODR off by up to 1/16 still
+ *         reads each sample once. A chunk whose span is off the period by half
+ *         of it was read off the sensor clock and is counted as slipped, the
+ *         measure starting over. The chip select and the bus stay held while
+ *         the core busy-waits through a chunk, LSM6DSL_STREAM_CHUNK periods:
+ *         10 ms at 3.33 kHz but 2.5 s at 12.5 Hz, other devices on the bus
+ *         waiting meanwhile. The bus is released between chunks. Otherwise
+ *         one sample is read per transaction, also paced by XLDA.
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::read_x_stream(int16_t *pData, size_t n, size_t *got, LSM6DSL_Stream_Stats_t *stats)
+{
+  LSM6DSL_Stream_Stats_t counted = {0, 0, 0, 0};
+  LSM6DSL_ACC_GYRO_ROUNDING_t rounding;
+  uint32_t period_us, start, due, previous = 0, span = 0;
+  uint8_t bytes[6];
+  int16_t stale[3];
+  size_t chunk = 0, spanned = 0, i;
+  float odr, period, error;
+  int ret = 0;
+
+  *got = 0;
+
+  if ( n == 0 )
+  {
+    return 0;
+  }
+  if ( get_x_odr( &odr ) == 1 || odr <= 0.0f )
+  {
+    return 1;
+  }
+  period = 1000000.0f / odr;
+  period_us = (uint32_t)period;
+
+  /* XLDA may hold for a sample of unknown age, read it to wait for the next one. */
+  if ( get_x_axes_raw( stale ) == 1 )
+  {
+    return 1;
+  }
+  counted.transactions++;
+  counted.bytes += 7;
+
+  if ( !_dev_spi || _spi_type != SPI4W )
+  {
+    while ( *got < n && ret == 0 )
+    {
+      if ( wait_x_data( period_us, &counted ) == 1 || get_x_axes_raw( pData + 3 * *got ) == 1 )
+      {
+        ret = 1;
+        break;
+      }
+      counted.transactions++;
+      counted.bytes += 7;
+      (*got)++;
+    }
+  }
+  else
+  {
+    if ( LSM6DSL_ACC_GYRO_R_CircularBurstMode( (void *)this, &rounding ) == MEMS_ERROR
+      || LSM6DSL_ACC_GYRO_W_CircularBurstMode( (void *)this, LSM6DSL_ACC_GYRO_ACC_ONLY ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+
+    while ( *got < n )
+    {
+      if ( wait_x_data( period_us, &counted ) == 1 )
+      {
+        ret = 1;
+        break;
+      }
+      start = us_ticker_read();
+
+      /* The previous chunk, read in full, spans as many periods as samples. */
+      if ( chunk > 0 )
+      {
+        error = (float)(uint32_t)( start - previous ) - chunk * period;
+        if ( error > period / 2 || error < -period / 2 )
+        {
+          counted.slipped++;
+          span = 0;
+          spanned = 0;
+        }
+        else
+        {
+          span += start - previous;
+          spanned += chunk;
+          period = (float)span / spanned;
+        }
+      }
+      previous = start;
+
+      chunk = spanned ? LSM6DSL_STREAM_CHUNK : LSM6DSL_STREAM_FIRST;
+      chunk = ( n - *got < chunk ) ? n - *got : chunk;
+
+      bus_lock();
+      _cs_pin = 0;
+      _dev_spi->write( LSM6DSL_ACC_GYRO_OUTX_L_XL | 0x80 );
+      for ( i = 0; i < chunk; i++ )
+      {
+        if ( i > 0 )
+        {
+          due = (uint32_t)( period * i + period / 2 );
+          /* Preempted past the next update, sample i is lost: resynchronize. */
+          if ( (uint32_t)( us_ticker_read() - start ) > due + (uint32_t)( period / 2 ) )
+          {
+            counted.late++;
+            break;
+          }
+          while ( (uint32_t)( us_ticker_read() - start ) < due )
+          {
+          }
+        }
+        for ( uint8_t b = 0; b < 6; b++ )
+        {
+          bytes[b] = (uint8_t)_dev_spi->write( 0x00 );
+        }
+        pData[3 * *got + 0] = ( ( ( ( int16_t )bytes[1] ) << 8 ) + ( int16_t )bytes[0] );
+        pData[3 * *got + 1] = ( ( ( ( int16_t )bytes[3] ) << 8 ) + ( int16_t )bytes[2] );
+        pData[3 * *got + 2] = ( ( ( ( int16_t )bytes[5] ) << 8 ) + ( int16_t )bytes[4] );
+        (*got)++;
+      }
+      _cs_pin = 1;
+      bus_unlock();
+      counted.transactions++;
+      counted.bytes += 1 + 6 * i;
+      /* Cut short, the next edge is no longer a chunk away. */
+      if ( i < chunk )
+      {
+        chunk = 0;
+        span = 0;
+        spanned = 0;
+      }
+    }
+
+    if ( LSM6DSL_ACC_GYRO_W_CircularBurstMode( (void *)this, rounding ) == MEMS_ERROR )
+    {
+      ret = 1;
+    }
   }
-  
-  return 0;
+
+  if ( stats )
+  {
+    stats->transactions += counted.transactions;
+    stats->bytes += counted.bytes;
+    stats->late += counted.late;
+    stats->slipped += counted.slipped;
+  }
+
+  return ret;
 }
 
 /**
- * @brief  Read Gyroscope Sensitivity
- * @param  pfData the pointer where the gyroscope sensitivity is stored
- * @retval 0 in case of success, an error code otherwise
+ * @brief  Poll XLDA until the LSM6DSL Accelerometer produces a sample
+ * @param  period_us the output data period, the polling step being a
+ *         sixteenth of it
+ * @param  stats the pointer where the polls are counted
+ * @retval 0 when a sample is available, 1 on error or after two periods
  */
-int LSM6DSLSensor::get_g_sensitivity(float *pfData)
+int LSM6DSLSensor::wait_x_data(uint32_t period_us, LSM6DSL_Stream_Stats_t *stats)
 {
-  LSM6DSL_ACC_GYRO_FS_125_t fullScale125;
-  LSM6DSL_ACC_GYRO_FS_G_t   fullScale;
-  
-  /* Read full scale 125 selection from sensor. */
-  if ( LSM6DSL_ACC_GYRO_R_FS_125( (void *)this, &fullScale125 ) == MEMS_ERROR )
-  {
-    return 1;
-  }
-  
-  if ( fullScale125 == LSM6DSL_ACC_GYRO_FS_125_ENABLED )
-  {
-    *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_125DPS;
-  }
-  
-  else
+  LSM6DSL_ACC_GYRO_XLDA_t xlda;
+  uint32_t start = us_ticker_read();
+
+  do
   {
-  
-    /* Read actual full scale selection from sensor. */
-    if ( LSM6DSL_ACC_GYRO_R_FS_G( (void *)this, &fullScale ) == MEMS_ERROR )
+    if ( LSM6DSL_ACC_GYRO_R_XLDA( (void *)this, &xlda ) == MEMS_ERROR )
     {
       return 1;
     }
-    
-    /* Store the sensitivity based on actual full scale. */
-    switch( fullScale )
+    stats->transactions++;
+    stats->bytes += 2;
+    if ( xlda == LSM6DSL_ACC_GYRO_XLDA_DATA_AVAIL )
     {
-      case LSM6DSL_ACC_GYRO_FS_G_245dps:
-        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_245DPS;
-        break;
-      case LSM6DSL_ACC_GYRO_FS_G_500dps:
-        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_500DPS;
-        break;
-      case LSM6DSL_ACC_GYRO_FS_G_1000dps:
-        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_1000DPS;
-        break;
-      case LSM6DSL_ACC_GYRO_FS_G_2000dps:
-        *pfData = ( float )LSM6DSL_GYRO_SENSITIVITY_FOR_FS_2000DPS;
-        break;
-      default:
-        *pfData = -1.0f;
-        return 1;
+      return 0;
     }
+    wait_us( (int)( period_us / 16 ) );
+  } while ( (uint32_t)( us_ticker_read() - start ) < 2 * period_us );
+
+  return 1;
+}
+
+/**
+ * @brief  Stamp the level of the DEN input into the LSB of accelerometer axes
+ * @param  axes the axes whose LSB carries the DEN level
+ * @param  active the DEN level read as 1 in the stamp
+ * @note   DEN is the INT2 pin, which then only serves as an input. In
+ *         level-sensitive mode the samples keep being produced at the ODR,
+ *         in the output registers and in the FIFO alike, so a marker costs
+ *         no bus access; the stamped axes lose their LSB.
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::enable_den_stamping(LSM6DSL_ACC_GYRO_DEN_AXES_t axes, LSM6DSL_ACC_GYRO_DEN_LH_t active)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_ExternalTrigger( (void *)this, LSM6DSL_ACC_GYRO_DEN_EDGE_EN_DISABLED ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_DEN_LVL2_EN( (void *)this, LSM6DSL_ACC_GYRO_DEN_LVL2_EN_DISABLED ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_DEN_Polarity( (void *)this, active ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_DEN_Axes( (void *)this, axes ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_DEN_XL_G( (void *)this, LSM6DSL_ACC_GYRO_DEN_XL ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_DEN_XL_EN( (void *)this, LSM6DSL_ACC_GYRO_DEN_XL_EN_ENABLED ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_DEN_LVL_EN( (void *)this, LSM6DSL_ACC_GYRO_DEN_LVL_EN_ENABLED ) == MEMS_ERROR )
+  {
+    return 1;
   }
-  
+
   return 0;
 }
 
 /**
- * @brief  Read raw data from LSM6DSL Accelerometer
- * @param  pData the pointer where the accelerometer raw data are stored
+ * @brief  Stop stamping the DEN level, see enable_den_stamping()
  * @retval 0 in case of success, an error code otherwise
  */
-int LSM6DSLSensor::get_x_axes_raw(int16_t *pData)
+int LSM6DSLSensor::disable_den_stamping(void)
 {
-  uint8_t regValue[6] = {0, 0, 0, 0, 0, 0};
-  
-  /* Read output registers from LSM6DSL_ACC_GYRO_OUTX_L_XL to LSM6DSL_ACC_GYRO_OUTZ_H_XL. */
-  if ( LSM6DSL_ACC_GYRO_GetRawAccData( (void *)this, regValue ) == MEMS_ERROR )
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_DEN_LVL_EN( (void *)this, LSM6DSL_ACC_GYRO_DEN_LVL_EN_DISABLED ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_DEN_XL_EN( (void *)this, LSM6DSL_ACC_GYRO_DEN_XL_EN_DISABLED ) == MEMS_ERROR )
   {
     return 1;
   }
-  
-  /* Format the data. */
-  pData[0] = ( ( ( ( int16_t )regValue[1] ) << 8 ) + ( int16_t )regValue[0] );
-  pData[1] = ( ( ( ( int16_t )regValue[3] ) << 8 ) + ( int16_t )regValue[2] );
-  pData[2] = ( ( ( ( int16_t )regValue[5] ) << 8 ) + ( int16_t )regValue[4] );
-  
+
   return 0;
 }
 
 /**
- * @brief  Read raw data from LSM6DSL Gyroscope
- * @param  pData the pointer where the gyroscope raw data are stored
+ * @brief  Start the timestamp counter from zero, at its 25 us resolution
+ * @note   The counter runs on the oscillator of the sensor, the one that
+ *         also paces the output data rates: samples are evenly spaced in
+ *         its ticks whatever the drift of the sensor against other clocks.
  * @retval 0 in case of success, an error code otherwise
  */
-int LSM6DSLSensor::get_g_axes_raw(int16_t *pData)
+int LSM6DSLSensor::enable_timestamp(void)
 {
-  uint8_t regValue[6] = {0, 0, 0, 0, 0, 0};
-  
-  /* Read output registers from LSM6DSL_ACC_GYRO_OUTX_L_G to LSM6DSL_ACC_GYRO_OUTZ_H_G. */
-  if ( LSM6DSL_ACC_GYRO_GetRawGyroData( (void *)this, regValue ) == MEMS_ERROR )
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_TIMER_HR( (void *)this, LSM6DSL_ACC_GYRO_TIMER_HR_25us ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_TIMER( (void *)this, LSM6DSL_ACC_GYRO_TIMER_ENABLED ) == MEMS_ERROR )
   {
     return 1;
   }
-  
-  /* Format the data. */
-  pData[0] = ( ( ( ( int16_t )regValue[1] ) << 8 ) + ( int16_t )regValue[0] );
-  pData[1] = ( ( ( ( int16_t )regValue[3] ) << 8 ) + ( int16_t )regValue[2] );
-  pData[2] = ( ( ( ( int16_t )regValue[5] ) << 8 ) + ( int16_t )regValue[4] );
-  
+
+  /* 0xAA in TIMESTAMP2 resets the counter */
+  return write_reg( LSM6DSL_ACC_GYRO_TIMESTAMP2_REG, 0xAA );
+}
+
+/**
+ * @brief  Read the timestamp counter, see enable_timestamp()
+ * @param  ticks the 24-bit counter, in 25 us ticks, wrapping every 419 s
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_timestamp(uint32_t *ticks)
+{
+  uint8_t bytes[3];
+
+  /* One burst, shorter than a tick, rather than three transactions */
+  if ( io_read( bytes, LSM6DSL_ACC_GYRO_TIMESTAMP0_REG, 3 ) != 0 )
+  {
+    return 1;
+  }
+
+  *ticks = ( uint32_t )bytes[0] | ( ( uint32_t )bytes[1] << 8 ) | ( ( uint32_t )bytes[2] << 16 );
+
   return 0;
 }
 
@@ -632,6 +1794,15 @@ int LSM6DSLSensor::set_x_odr_when_enabled(float odr)
     return 1;
   }
   
+  /* Keep the FIFO output data rate in line with the accelerometer one. */
+  if ( _fifo_data == FIFO_X )
+  {
+    if ( set_fifo_odr( odr ) == 1 )
+    {
+      return 1;
+    }
+  }
+  
   return 0;
 }
 
@@ -706,6 +1877,15 @@ int LSM6DSLSensor::set_g_odr_when_enabled(float odr)
     return 1;
   }
   
+  /* Keep the FIFO output data rate in line with the gyroscope one. */
+  if ( _fifo_data == FIFO_G )
+  {
+    if ( set_fifo_odr( odr ) == 1 )
+    {
+      return 1;
+    }
+  }
+  
   return 0;
 }
 
@@ -881,6 +2061,8 @@ int LSM6DSLSensor::set_g_fs(float fullScale)
 */
 int LSM6DSLSensor::enable_free_fall_detection(LSM6DSL_Interrupt_Pin_t pin)
 {
+  BusSession session( this );
+
   /* Output Data Rate selection */
   if(set_x_odr(416.0f) == 1)
   {
@@ -960,6 +2142,8 @@ int LSM6DSLSensor::enable_free_fall_detection(LSM6DSL_Interrupt_Pin_t pin)
 */
 int LSM6DSLSensor::disable_free_fall_detection(void)
 {
+  BusSession session( this );
+
   /* Disable free fall event on INT1 pin */
   if ( LSM6DSL_ACC_GYRO_W_FFEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_FF_DISABLED ) == MEMS_ERROR )
   {
@@ -1016,6 +2200,8 @@ int LSM6DSLSensor::set_free_fall_threshold(uint8_t thr)
  */
 int LSM6DSLSensor::enable_pedometer(void)
 {
+  BusSession session( this );
+
   /* Output Data Rate selection */
   if( set_x_odr(26.0f) == 1 )
   {
@@ -1061,6 +2247,8 @@ int LSM6DSLSensor::enable_pedometer(void)
  */
 int LSM6DSLSensor::disable_pedometer(void)
 {
+  BusSession session( this );
+
   /* Disable pedometer on INT1. */
   if ( LSM6DSL_ACC_GYRO_W_STEP_DET_on_INT1( (void *)this, LSM6DSL_ACC_GYRO_INT1_PEDO_DISABLED ) == MEMS_ERROR )
   {
@@ -1147,6 +2335,8 @@ int LSM6DSLSensor::set_pedometer_threshold(uint8_t thr)
  */
 int LSM6DSLSensor::enable_tilt_detection(LSM6DSL_Interrupt_Pin_t pin)
 {
+  BusSession session( this );
+
   /* Output Data Rate selection */
   if( set_x_odr(26.0f) == 1 )
   {
@@ -1201,6 +2391,8 @@ int LSM6DSLSensor::enable_tilt_detection(LSM6DSL_Interrupt_Pin_t pin)
  */
 int LSM6DSLSensor::disable_tilt_detection(void)
 {
+  BusSession session( this );
+
   /* Disable tilt event on INT1. */
   if ( LSM6DSL_ACC_GYRO_W_TiltEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_TILT_DISABLED ) == MEMS_ERROR )
   {
@@ -1236,6 +2428,8 @@ int LSM6DSLSensor::disable_tilt_detection(void)
  */
 int LSM6DSLSensor::enable_wake_up_detection(LSM6DSL_Interrupt_Pin_t pin)
 {
+  BusSession session( this );
+
   /* Output Data Rate selection */
   if( set_x_odr(416.0f) == 1 )
   {
@@ -1296,6 +2490,8 @@ int LSM6DSLSensor::enable_wake_up_detection(LSM6DSL_Interrupt_Pin_t pin)
  */
 int LSM6DSLSensor::disable_wake_up_detection(void)
 {
+  BusSession session( this );
+
   /* Disable wake up event on INT1 */
   if ( LSM6DSL_ACC_GYRO_W_WUEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_WU_DISABLED ) == MEMS_ERROR )
   {
@@ -1352,6 +2548,8 @@ int LSM6DSLSensor::set_wake_up_threshold(uint8_t thr)
  */
 int LSM6DSLSensor::enable_single_tap_detection(LSM6DSL_Interrupt_Pin_t pin)
 {
+  BusSession session( this );
+
   /* Output Data Rate selection */
   if( set_x_odr(416.0f) == 1 )
   {
@@ -1440,6 +2638,8 @@ int LSM6DSLSensor::enable_single_tap_detection(LSM6DSL_Interrupt_Pin_t pin)
  */
 int LSM6DSLSensor::disable_single_tap_detection(void)
 {
+  BusSession session( this );
+
   /* Disable single tap interrupt on INT1 pin. */
   if ( LSM6DSL_ACC_GYRO_W_SingleTapOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_SINGLE_TAP_DISABLED ) == MEMS_ERROR )
   {
@@ -1509,6 +2709,8 @@ int LSM6DSLSensor::disable_single_tap_detection(void)
  */
 int LSM6DSLSensor::enable_double_tap_detection(LSM6DSL_Interrupt_Pin_t pin)
 {
+  BusSession session( this );
+
   /* Output Data Rate selection */
   if( set_x_odr(416.0f) == 1 )
   {
@@ -1605,6 +2807,8 @@ int LSM6DSLSensor::enable_double_tap_detection(LSM6DSL_Interrupt_Pin_t pin)
  */
 int LSM6DSLSensor::disable_double_tap_detection(void)
 {
+  BusSession session( this );
+
   /* Disable double tap interrupt on INT1 pin. */
   if ( LSM6DSL_ACC_GYRO_W_TapEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_TAP_DISABLED ) == MEMS_ERROR )
   {
@@ -1742,6 +2946,8 @@ int LSM6DSLSensor::set_tap_duration_time(uint8_t time)
  */
 int LSM6DSLSensor::enable_6d_orientation(LSM6DSL_Interrupt_Pin_t pin)
 {
+  BusSession session( this );
+
   /* Output Data Rate selection */
   if( set_x_odr(416.0f) == 1 )
   {
@@ -1796,6 +3002,8 @@ int LSM6DSLSensor::enable_6d_orientation(LSM6DSL_Interrupt_Pin_t pin)
  */
 int LSM6DSLSensor::disable_6d_orientation(void)
 {
+  BusSession session( this );
+
   /* Disable 6D orientation interrupt on INT1 pin. */
   if ( LSM6DSL_ACC_GYRO_W_6DEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_6D_DISABLED ) == MEMS_ERROR )
   {
@@ -1820,6 +3028,13 @@ int LSM6DSLSensor::disable_6d_orientation(void)
     return 1;
   }
   
+  /* Back to 6D on unfiltered data, see enable_6d_orientation_irq(). */
+  if ( LSM6DSL_ACC_GYRO_W_D4D( (void *)this, LSM6DSL_ACC_GYRO_D4D_DIS ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_LOW_PASS_ON_6D( (void *)this, LSM6DSL_ACC_GYRO_LOW_PASS_ON_6D_OFF ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
   return 0;
 }
 
@@ -1997,6 +3212,84 @@ int LSM6DSLSensor::get_6d_orientation_zh(uint8_t *zh)
   return 0;
 }
 
+/**
+ * @brief  Raise an interrupt when the LSM6DSL changes position, keeping the
+ *         output data rate and full scale of the acquisition
+ * @param  threshold the angle from vertical within which an axis points up
+ *         or down
+ * @param  d4d true to ignore the Z axis, 4D detection
+ * @param  pin the interrupt pin to be used
+ * @note   The detection runs on the LPF2 output at ODR/400, so that the
+ *         strings do not move the position. The output data does not go
+ *         through LPF2, LPF2_XL_EN being left cleared.
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::enable_6d_orientation_irq(LSM6DSL_ACC_GYRO_SIXD_THS_t threshold, bool d4d, LSM6DSL_Interrupt_Pin_t pin)
+{
+  BusSession session( this );
+
+  if ( LSM6DSL_ACC_GYRO_W_SIXD_THS( (void *)this, threshold ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_D4D( (void *)this, d4d ? LSM6DSL_ACC_GYRO_D4D_EN : LSM6DSL_ACC_GYRO_D4D_DIS ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_HPCF_XL( (void *)this, LSM6DSL_ACC_GYRO_HPCF_XL_DIV400 ) == MEMS_ERROR
+    || LSM6DSL_ACC_GYRO_W_LOW_PASS_ON_6D( (void *)this, LSM6DSL_ACC_GYRO_LOW_PASS_ON_6D_ON ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  if ( LSM6DSL_ACC_GYRO_W_BASIC_INT( (void *)this, LSM6DSL_ACC_GYRO_BASIC_INT_ENABLED ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  switch (pin)
+  {
+  case LSM6DSL_INT1_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_6DEvOnInt1( (void *)this, LSM6DSL_ACC_GYRO_INT1_6D_ENABLED ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    break;
+
+  case LSM6DSL_INT2_PIN:
+    if ( LSM6DSL_ACC_GYRO_W_6DEvOnInt2( (void *)this, LSM6DSL_ACC_GYRO_INT2_6D_ENABLED ) == MEMS_ERROR )
+    {
+      return 1;
+    }
+    break;
+
+  default:
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Get the position of the LSM6DSL in a single read
+ * @param  position the pointer where the XL to ZH bits of D6D_SRC are
+ *         stored, LSM6DSL_ACC_GYRO_DSD_XL_MASK to LSM6DSL_ACC_GYRO_DSD_ZH_MASK,
+ *         0 between two positions
+ * @retval 0 in case of success, an error code otherwise
+ */
+int LSM6DSLSensor::get_6d_position(uint8_t *position)
+{
+  uint8_t d6d_src;
+
+  if ( read_reg( LSM6DSL_ACC_GYRO_D6D_SRC, &d6d_src ) != 0 )
+  {
+    return 1;
+  }
+
+  *position = d6d_src & ( LSM6DSL_ACC_GYRO_DSD_XL_MASK | LSM6DSL_ACC_GYRO_DSD_XH_MASK | LSM6DSL_ACC_GYRO_DSD_YL_MASK
+                        | LSM6DSL_ACC_GYRO_DSD_YH_MASK | LSM6DSL_ACC_GYRO_DSD_ZL_MASK | LSM6DSL_ACC_GYRO_DSD_ZH_MASK );
+
+  return 0;
+}
+
 /**
  * @brief Get the status of all hardware events for LSM6DSL accelerometer sensor
  * @param status the pointer to the status of all hardware events
@@ -2005,6 +3298,8 @@ int LSM6DSLSensor::get_6d_orientation_zh(uint8_t *zh)
 int LSM6DSLSensor::get_event_status(LSM6DSL_Event_Status_t *status)
 {
   uint8_t Wake_Up_Src = 0, Tap_Src = 0, D6D_Src = 0, Func_Src = 0, Md1_Cfg = 0, Md2_Cfg = 0, Int1_Ctrl = 0;
+  uint8_t Int2_Ctrl = 0, Fifo_Status2 = 0;
+  BusSession session( this );
 
   memset((void *)status, 0x0, sizeof(LSM6DSL_Event_Status_t));
 
@@ -2043,6 +3338,16 @@ int LSM6DSLSensor::get_event_status(LSM6DSL_Event_Status_t *status)
     return 1;
   }
 
+  if(read_reg(LSM6DSL_ACC_GYRO_INT2_CTRL, &Int2_Ctrl ) != 0)
+  {
+    return 1;
+  }
+
+  if(read_reg(LSM6DSL_ACC_GYRO_FIFO_STATUS2, &Fifo_Status2 ) != 0)
+  {
+    return 1;
+  }
+
   if((Md1_Cfg & LSM6DSL_ACC_GYRO_INT1_FF_MASK) || (Md2_Cfg & LSM6DSL_ACC_GYRO_INT2_FF_MASK))
   {
     if((Wake_Up_Src & LSM6DSL_ACC_GYRO_FF_EV_STATUS_MASK))
@@ -2099,6 +3404,22 @@ int LSM6DSLSensor::get_event_status(LSM6DSL_Event_Status_t *status)
     }
   }
 
+  if((Int1_Ctrl & LSM6DSL_ACC_GYRO_INT1_FTH_MASK) || (Int2_Ctrl & LSM6DSL_ACC_GYRO_INT2_FTH_MASK))
+  {
+    if((Fifo_Status2 & LSM6DSL_ACC_GYRO_WTM_MASK))
+    {
+      status->FifoWatermarkStatus = 1;
+    }
+  }
+
+  if((Int1_Ctrl & LSM6DSL_ACC_GYRO_INT1_OVR_MASK) || (Int2_Ctrl & LSM6DSL_ACC_GYRO_INT2_OVR_MASK))
+  {
+    if((Fifo_Status2 & LSM6DSL_ACC_GYRO_OVERRUN_MASK))
+    {
+      status->FifoOverrunStatus = 1;
+    }
+  }
+
   return 0;
 }
 
@@ -2137,6 +3458,104 @@ int LSM6DSLSensor::write_reg( uint8_t reg, uint8_t data )
 }
 
 
+/**
+ * @brief  Find the fastest reliable SPI clock for this sensor
+ * @param  max_hz the highest clock to try, 10 MHz at most for the LSM6DSL
+ * @param  selected_hz the pointer where the selected clock is stored
+ * @retval 0 in case of success, an error code otherwise
+ * @note   The clock is stepped up through 1, 2, 4, 5, 8 and 10 MHz, up to
+ *         max_hz, each step being checked with verify_spi_link(). The clock
+ *         is then set one step below the highest one that passed, as margin,
+ *         and left at 1 MHz when only 1 MHz passed. The user offset registers
+ *         used as scratch are saved at 1 MHz and restored at the selected
+ *         clock.
+ */
+int LSM6DSLSensor::tune_spi_frequency(int max_hz, int *selected_hz)
+{
+  static const int steps[] = { 1000000, 2000000, 4000000, 5000000, 8000000, 10000000 };
+  uint8_t saved[3];
+  int passed = -1;
+
+  if ( !_dev_spi )
+  {
+    return 1;
+  }
+
+  _dev_spi->frequency( steps[0] );
+  if ( LSM6DSL_ACC_GYRO_read_reg( (void *)this, LSM6DSL_ACC_GYRO_X_OFS_USR, saved, 3 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  for ( int i = 0; i < (int)( sizeof( steps ) / sizeof( steps[0] ) ) && steps[i] <= max_hz; i++ )
+  {
+    _dev_spi->frequency( steps[i] );
+    if ( verify_spi_link() != 0 )
+    {
+      break;
+    }
+    passed = i;
+  }
+
+  if ( passed < 0 )
+  {
+    /* Not even 1 MHz works, leave the link at the slowest step. */
+    _dev_spi->frequency( steps[0] );
+    LSM6DSL_ACC_GYRO_write_reg( (void *)this, LSM6DSL_ACC_GYRO_X_OFS_USR, saved, 3 );
+    *selected_hz = steps[0];
+    return 1;
+  }
+
+  /* Keep one step of margin below the highest clock verified. */
+  if ( passed > 0 )
+  {
+    passed--;
+  }
+
+  _dev_spi->frequency( steps[passed] );
+  *selected_hz = steps[passed];
+
+  if ( LSM6DSL_ACC_GYRO_write_reg( (void *)this, LSM6DSL_ACC_GYRO_X_OFS_USR, saved, 3 ) == MEMS_ERROR )
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief  Check the SPI link at the current clock
+ * @retval 0 if WHO_AM_I and the write/read back of test patterns in the user
+ *         offset registers are consistent, an error code otherwise
+ * @note   The user offset registers are left with a test pattern.
+ */
+int LSM6DSLSensor::verify_spi_link(void)
+{
+  static const uint8_t patterns[][3] = { { 0x55, 0xAA, 0x00 }, { 0xAA, 0x00, 0xFF }, { 0xFF, 0x55, 0xAA }, { 0x0F, 0xF0, 0x3C } };
+  uint8_t readback[3], id;
+  BusSession session( this );
+
+  for ( int i = 0; i < 8; i++ )
+  {
+    if ( io_read( &id, LSM6DSL_ACC_GYRO_WHO_AM_I_REG, 1 ) != 0 || id != LSM6DSL_ACC_GYRO_WHO_AM_I )
+    {
+      return 1;
+    }
+  }
+
+  for ( int i = 0; i < (int)( sizeof( patterns ) / sizeof( patterns[0] ) ); i++ )
+  {
+    if ( io_write( (uint8_t *)patterns[i], LSM6DSL_ACC_GYRO_X_OFS_USR, 3 ) != 0
+      || io_read( readback, LSM6DSL_ACC_GYRO_X_OFS_USR, 3 ) != 0
+      || memcmp( readback, patterns[i], 3 ) != 0 )
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
 uint8_t LSM6DSL_io_write( void *handle, uint8_t WriteAddr, uint8_t *pBuffer, uint16_t nBytesToWrite )
 {
   return ((LSM6DSLSensor *)handle)->io_write(pBuffer, WriteAddr, nBytesToWrite);
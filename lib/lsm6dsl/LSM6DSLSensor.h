@@ -46,9 +46,12 @@
 /* Includes ------------------------------------------------------------------*/
 
 #include "DevI2C.h"
+#include "DevSPI.h"
 #include "LSM6DSL_acc_gyro_driver.h"
+#include "LSM6DSLFifo.h"
 #include "MotionSensor.h"
 #include "GyroSensor.h"
+#include "TempSensor.h"
 #include <assert.h>
 
 /* Defines -------------------------------------------------------------------*/
@@ -98,6 +101,9 @@
 #define LSM6DSL_TAP_DURATION_TIME_MID_HIGH  0x0C
 #define LSM6DSL_TAP_DURATION_TIME_HIGH      0x0F  /**< Highest value of wake up threshold */
 
+#define LSM6DSL_STREAM_CHUNK    32  /**< Samples read per chip select assertion by read_x_stream() */
+#define LSM6DSL_STREAM_FIRST    8   /**< Samples of the first chunk, read before the ODR period is measured */
+
 /* Typedefs ------------------------------------------------------------------*/
 
 typedef enum
@@ -115,19 +121,58 @@ typedef struct
   unsigned int StepStatus : 1;
   unsigned int TiltStatus : 1;
   unsigned int D6DOrientationStatus : 1;
+  unsigned int FifoWatermarkStatus : 1;
+  unsigned int FifoOverrunStatus : 1;
 } LSM6DSL_Event_Status_t;
 
+typedef struct
+{
+  uint32_t transactions;  /* Chip select assertions, status polls included */
+  uint32_t bytes;         /* Bytes clocked, address bytes included */
+  uint32_t late;          /* Chunks cut short, a sample being overwritten before it was read */
+  uint32_t slipped;       /* Chunks off the sensor clock by half a period, samples read twice or skipped */
+} LSM6DSL_Stream_Stats_t;
+
 /* Class Declaration ---------------------------------------------------------*/
    
 /**
  * Abstract class of an LSM6DSL Inertial Measurement Unit (IMU) 6 axes
  * sensor.
  */
-class LSM6DSLSensor : public MotionSensor, public GyroSensor
+class LSM6DSLSensor : public MotionSensor, public GyroSensor, public TempSensor
 {
   public:
     enum SPI_type_t {SPI3W, SPI4W};      
+
+    /**
+     * Holds the bus of a sensor for the lifetime of the object, so that a
+     * sequence of register accesses takes the bus mutex once. Sessions may be
+     * nested. A sensor instance, and therefore its sessions, must be used
+     * from a single thread; other devices on the same bus keep locking it
+     * as usual and wait for the session to end.
+     */
+    class BusSession
+    {
+      public:
+        explicit BusSession(LSM6DSLSensor *sensor) : _sensor(sensor)
+        {
+            _sensor->bus_lock();
+        }
+
+        ~BusSession()
+        {
+            _sensor->bus_unlock();
+        }
+
+      private:
+        BusSession(const BusSession &);
+        BusSession &operator=(const BusSession &);
+
+        LSM6DSLSensor *_sensor;
+    };
+
     LSM6DSLSensor(SPI *spi, PinName cs_pin, PinName INT1_pin=NC, PinName INT2_pin=NC, SPI_type_t spi_type=SPI4W);
+    LSM6DSLSensor(DevSPI *spi, PinName cs_pin, PinName INT1_pin=NC, PinName INT2_pin=NC, SPI_type_t spi_type=SPI4W);
     LSM6DSLSensor(DevI2C *i2c, uint8_t address=LSM6DSL_ACC_GYRO_I2C_ADDRESS_HIGH, PinName INT1_pin=NC, PinName INT2_pin=NC);
     virtual int init(void *init);
     virtual int read_id(uint8_t *id);
@@ -136,6 +181,7 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     virtual int get_x_sensitivity(float *pfData);
     virtual int get_g_sensitivity(float *pfData);
     virtual int get_x_axes_raw(int16_t *pData);
+    virtual int get_temperature(float *pf_data);
     virtual int get_g_axes_raw(int16_t *pData);
     virtual int get_x_odr(float *odr);
     virtual int get_g_odr(float *odr);
@@ -145,10 +191,41 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     virtual int get_g_fs(float *fullScale);
     virtual int set_x_fs(float fullScale);
     virtual int set_g_fs(float fullScale);
+    virtual int read_x_block(int16_t *pData, size_t n, size_t *got);
+    virtual int read_g_block(int16_t *pData, size_t n, size_t *got);
+    int read_x_stream(int16_t *pData, size_t n, size_t *got, LSM6DSL_Stream_Stats_t *stats = NULL);
+    int enable_den_stamping(LSM6DSL_ACC_GYRO_DEN_AXES_t axes = LSM6DSL_ACC_GYRO_DEN_X,
+                            LSM6DSL_ACC_GYRO_DEN_LH_t active = LSM6DSL_ACC_GYRO_DEN_LOW);
+    int disable_den_stamping(void);
+    int enable_timestamp(void);
+    int get_timestamp(uint32_t *ticks);
     int enable_x(void);
     int enable_g(void);
     int disable_x(void);
     int disable_g(void);
+    int enable_x_fifo(void);
+    int enable_g_fifo(void);
+    int disable_fifo(void);
+    int reset_fifo(void);
+    int get_fifo_samples(size_t *samples);
+    int set_fifo_word_frames(bool enable);
+    int get_fifo_stats(LSM6DSL_Fifo_Stats_t *stats);
+    void reset_fifo_stats(void);
+    int set_x_user_offset(const float *offset);
+    int set_x_odr_fs(float odr, float fullScale);
+    int set_fifo_watermark(size_t samples);
+    int enable_fifo_watermark_irq(LSM6DSL_Interrupt_Pin_t pin = LSM6DSL_INT1_PIN);
+    int disable_fifo_watermark_irq(void);
+    int enable_fifo_overrun_irq(LSM6DSL_Interrupt_Pin_t pin = LSM6DSL_INT1_PIN);
+    int disable_fifo_overrun_irq(void);
+    int enable_latched_irq(void);
+    int enable_fifo_trigger(uint8_t thr, LSM6DSL_Interrupt_Pin_t pin = LSM6DSL_INT1_PIN);
+    int disable_fifo_trigger(void);
+    int enable_fifo_trigger_irq(LSM6DSL_Interrupt_Pin_t pin = LSM6DSL_INT1_PIN);
+    int disable_fifo_trigger_irq(void);
+    int arm_fifo_trigger(void);
+    int release_fifo_trigger(void);
+    int disable_latched_irq(void);
     int enable_free_fall_detection(LSM6DSL_Interrupt_Pin_t pin = LSM6DSL_INT1_PIN);
     int disable_free_fall_detection(void);
     int set_free_fall_threshold(uint8_t thr);
@@ -178,18 +255,68 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     int get_6d_orientation_yh(uint8_t *yh);
     int get_6d_orientation_zl(uint8_t *zl);
     int get_6d_orientation_zh(uint8_t *zh);
+    int enable_6d_orientation_irq(LSM6DSL_ACC_GYRO_SIXD_THS_t threshold = LSM6DSL_ACC_GYRO_SIXD_THS_60_degree,
+                                  bool d4d = false, LSM6DSL_Interrupt_Pin_t pin = LSM6DSL_INT1_PIN);
+    int get_6d_position(uint8_t *position);
     int get_event_status(LSM6DSL_Event_Status_t *status);
     int read_reg(uint8_t reg, uint8_t *data);
     int write_reg(uint8_t reg, uint8_t data);
+    int tune_spi_frequency(int max_hz, int *selected_hz);
+
+    /**
+     * @brief  Sending the driver traces to the serial port of the application.
+     * @param  log the serial port, NULL (default) for no traces.
+     * @retval None.
+     */
+    void set_log(RawSerial *log)
+    {
+        _log = log;
+    }
+
+    /**
+     * @brief  Taking the bus for a sequence of accesses, see BusSession.
+     * @param  None.
+     * @retval None.
+     */
+    void bus_lock(void)
+    {
+        if (_bus_depth++ == 0) {
+            if (_dev_spi) _dev_spi->lock();
+            if (_dev_i2c) _dev_i2c->lock();
+        }
+    }
+
+    /**
+     * @brief  Releasing the bus taken by bus_lock().
+     * @param  None.
+     * @retval None.
+     */
+    void bus_unlock(void)
+    {
+        if (--_bus_depth == 0) {
+            if (_dev_spi) _dev_spi->unlock();
+            if (_dev_i2c) _dev_i2c->unlock();
+        }
+    }
     
     /**
      * @brief  Attaching an interrupt handler to the INT1 interrupt.
-     * @param  fptr An interrupt handler.
+     * @param  func An interrupt handler, a function or an object and its method.
      * @retval None.
      */
-    void attach_int1_irq(void (*fptr)(void))
+    void attach_int1_irq(Callback<void()> func)
     {
-        _int1_irq.rise(fptr);
+        _int1_irq.rise(func);
+    }
+
+    /**
+     * @brief  Reading the level of the INT1 pin.
+     * @param  None.
+     * @retval 1 while an interrupt source is active, 0 otherwise.
+     */
+    int get_int1_level(void)
+    {
+        return _int1_irq.read();
     }
 
     /**
@@ -214,12 +341,22 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     
     /**
      * @brief  Attaching an interrupt handler to the INT2 interrupt.
-     * @param  fptr An interrupt handler.
+     * @param  func An interrupt handler, a function or an object and its method.
      * @retval None.
      */
-    void attach_int2_irq(void (*fptr)(void))
+    void attach_int2_irq(Callback<void()> func)
+    {
+        _int2_irq.rise(func);
+    }
+
+    /**
+     * @brief  Reading the level of the INT2 pin.
+     * @param  None.
+     * @retval 1 while an interrupt source is active, 0 otherwise.
+     */
+    int get_int2_level(void)
     {
-        _int2_irq.rise(fptr);
+        return _int2_irq.read();
     }
 
     /**
@@ -253,7 +390,7 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     {        
         if (_dev_spi) {
         /* Write Reg Address */
-            _dev_spi->lock();
+            if (_bus_depth == 0) _dev_spi->lock();
             _cs_pin = 0;           
             if (_spi_type == SPI4W) {            
                 _dev_spi->write(RegisterAddr | 0x80);
@@ -266,13 +403,38 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
                 _dev_spi->write((char *)&TxByte, 1, (char *)pBuffer, (int) NumByteToRead);
             }            
             _cs_pin = 1;
-            _dev_spi->unlock(); 
+            if (_bus_depth == 0) _dev_spi->unlock(); 
             return 0;
         }                       
         if (_dev_i2c) return (uint8_t) _dev_i2c->i2c_read(pBuffer, _address, RegisterAddr, NumByteToRead);
         return 1;
     }
     
+    /**
+     * @brief Utility function to read 16-bit words LSB first, such as the FIFO
+     *        output, with the payload clocked in 16-bit SPI frames.
+     * @param  pBuffer: pointer to the words to be read.
+     * @param  RegisterAddr: specifies internal address register to be read.
+     * @param  NumWordsToRead: number of words to be read.
+     * @retval 0 if ok, an error code otherwise.
+     */
+    uint8_t io_read_words(uint16_t* pBuffer, uint8_t RegisterAddr, uint16_t NumWordsToRead)
+    {
+        if (!_dev_spi16 || _spi_type != SPI4W) return 1;
+        if (_bus_depth == 0) _dev_spi16->lock();
+        _cs_pin = 0;
+        /* Address phase in 8 bits, then one frame per word. LSB first on
+           the wire ends up in the upper half of each frame, DevSPI swaps it
+           back. spi_read() releases the chip select. */
+        _dev_spi16->write(RegisterAddr | 0x80);
+        _dev_spi16->set_frame_bits(16);
+        int ret = _dev_spi16->spi_read(pBuffer, _cs_pin, NumWordsToRead);
+        _dev_spi16->set_frame_bits(8);
+        _cs_pin = 1;
+        if (_bus_depth == 0) _dev_spi16->unlock();
+        return ret == 0 ? 0 : 1;
+    }
+
     /**
      * @brief Utility function to write data.
      * @param  pBuffer: pointer to data to be written.
@@ -283,12 +445,12 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     uint8_t io_write(uint8_t* pBuffer, uint8_t RegisterAddr, uint16_t NumByteToWrite)
     {
         if (_dev_spi) { 
-            _dev_spi->lock();
+            if (_bus_depth == 0) _dev_spi->lock();
             _cs_pin = 0;
             _dev_spi->write(RegisterAddr);                    
             _dev_spi->write((char *)pBuffer, (int) NumByteToWrite, NULL, 0);                     
             _cs_pin = 1;                    
-            _dev_spi->unlock();
+            if (_bus_depth == 0) _dev_spi->unlock();
             return 0;                    
         }        
         if (_dev_i2c) return (uint8_t) _dev_i2c->i2c_write(pBuffer, _address, RegisterAddr, NumByteToWrite);    
@@ -296,14 +458,24 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     }
 
   private:
+    void init_spi(PinName cs_pin);
+    int verify_spi_link(void);
     int set_x_odr_when_enabled(float odr);
     int set_g_odr_when_enabled(float odr);
     int set_x_odr_when_disabled(float odr);
     int set_g_odr_when_disabled(float odr);
+    int set_fifo_odr(float odr);
+    int read_fifo_block(int16_t *pData, size_t n, size_t *got);
+    int read_fifo_status(size_t *samples);
+    int wait_x_data(uint32_t period_us, LSM6DSL_Stream_Stats_t *stats);
+
+    /* Data set currently routed to the FIFO. */
+    enum FIFO_data_t {FIFO_NONE, FIFO_X, FIFO_G};
 
     /* Helper classes. */
     DevI2C *_dev_i2c;
     SPI    *_dev_spi;
+    DevSPI *_dev_spi16;
 
     /* Configuration */
     uint8_t _address;
@@ -316,6 +488,14 @@ class LSM6DSLSensor : public MotionSensor, public GyroSensor
     float _x_last_odr;
     uint8_t _g_is_enabled;
     float _g_last_odr;
+    FIFO_data_t _fifo_data;
+    float _fifo_odr;
+    uint32_t _fifo_drain_us;
+    uint8_t _fifo_word_frames;
+    LSM6DSL_Fifo_Stats_t _fifo_stats;
+    uint8_t _bus_depth;
+
+    RawSerial *_log;
 };
 
 #ifdef __cplusplus
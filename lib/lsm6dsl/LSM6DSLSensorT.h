@@ -0,0 +1,732 @@
+/**
+ ******************************************************************************
+ * @file    LSM6DSLSensorT.h
+ * @brief   LSM6DSL accelerometer/gyroscope bound to its bus at compile time.
+ ******************************************************************************
+ * LSM6DSLSensorT<Bus> provides the acquisition subset of LSM6DSLSensor
+ * (configuration, output registers and FIFO block reads) on top of a bus
+ * policy from LSM6DSLBus.h, or LSM6DSLSimBus from Sim/LSM6DSLSimulator.h on
+ * host. Registers are accessed directly through the policy, so a sample read
+ * is one inlined burst transfer with no handle cast and no bus selection.
+ *
+ * LSM6DSLSensor remains the runtime selected implementation of the
+ * MotionSensor/GyroSensor interfaces.
+ *
+ * @note   This header does not depend on mbed.
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+
+#ifndef __LSM6DSLSensorT_H__
+#define __LSM6DSLSensorT_H__
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "LSM6DSL_acc_gyro_driver.h"
+#include "LSM6DSLFifo.h"
+
+/* Class Declaration ---------------------------------------------------------*/
+
+template <class Bus>
+class LSM6DSLSensorT
+{
+  public:
+    explicit LSM6DSLSensorT(Bus &bus) :
+        _bus(bus), _x_is_enabled(0), _x_last_odr(1666.0f), _g_is_enabled(0), _g_last_odr(1666.0f),
+        _x_sensitivity(0.0f), _g_sensitivity(0.0f), _fifo_x(0), _fifo_odr(0.0f), _fifo_drain_us(0)
+    {
+        reset_fifo_stats();
+    }
+
+    /**
+     * @brief  Initializing the component, same configuration as LSM6DSLSensor::init().
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int init(void)
+    {
+        /* SPI mode and register address auto increment. */
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL3_C, LSM6DSL_ACC_GYRO_SIM_MASK | LSM6DSL_ACC_GYRO_IF_INC_MASK | LSM6DSL_ACC_GYRO_BDU_MASK,
+                         ( Bus::spi_3wire ? LSM6DSL_ACC_GYRO_SIM_MASK : 0 ) | LSM6DSL_ACC_GYRO_IF_INC_MASK | LSM6DSL_ACC_GYRO_BDU_MASK ) )
+        {
+            return 1;
+        }
+
+        /* FIFO in bypass mode. */
+        if ( update_reg( LSM6DSL_ACC_GYRO_FIFO_CTRL5, LSM6DSL_ACC_GYRO_FIFO_MODE_MASK, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS ) )
+        {
+            return 1;
+        }
+
+        /* Both sensors powered down. */
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL1_XL, LSM6DSL_ACC_GYRO_ODR_XL_MASK, LSM6DSL_ACC_GYRO_ODR_XL_POWER_DOWN )
+          || update_reg( LSM6DSL_ACC_GYRO_CTRL2_G, LSM6DSL_ACC_GYRO_ODR_G_MASK, LSM6DSL_ACC_GYRO_ODR_G_POWER_DOWN ) )
+        {
+            return 1;
+        }
+
+        if ( set_x_fs( 16.0f ) || set_g_fs( 2000.0f ) )
+        {
+            return 1;
+        }
+
+        _x_last_odr = 1666.0f;
+        _x_is_enabled = 0;
+        _g_last_odr = 1666.0f;
+        _g_is_enabled = 0;
+        _fifo_x = 0;
+
+        return 0;
+    }
+
+    /**
+     * @brief  Read ID of LSM6DSL Accelerometer and Gyroscope
+     * @param  id the pointer where the ID of the device is stored
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int read_id(uint8_t *id)
+    {
+        return read_reg( LSM6DSL_ACC_GYRO_WHO_AM_I_REG, id );
+    }
+
+    int enable_x(void)
+    {
+        if ( _x_is_enabled == 1 )
+        {
+            return 0;
+        }
+        if ( write_x_odr( _x_last_odr ) )
+        {
+            return 1;
+        }
+        _x_is_enabled = 1;
+        return 0;
+    }
+
+    int disable_x(void)
+    {
+        if ( _x_is_enabled == 0 )
+        {
+            return 0;
+        }
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL1_XL, LSM6DSL_ACC_GYRO_ODR_XL_MASK, LSM6DSL_ACC_GYRO_ODR_XL_POWER_DOWN ) )
+        {
+            return 1;
+        }
+        _x_is_enabled = 0;
+        return 0;
+    }
+
+    int enable_g(void)
+    {
+        if ( _g_is_enabled == 1 )
+        {
+            return 0;
+        }
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL2_G, LSM6DSL_ACC_GYRO_ODR_G_MASK, odr_bits( _g_last_odr ) ) )
+        {
+            return 1;
+        }
+        _g_is_enabled = 1;
+        return 0;
+    }
+
+    int disable_g(void)
+    {
+        if ( _g_is_enabled == 0 )
+        {
+            return 0;
+        }
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL2_G, LSM6DSL_ACC_GYRO_ODR_G_MASK, LSM6DSL_ACC_GYRO_ODR_G_POWER_DOWN ) )
+        {
+            return 1;
+        }
+        _g_is_enabled = 0;
+        return 0;
+    }
+
+    /**
+     * @brief  Set LSM6DSL Accelerometer output data rate, applied at once if enabled
+     * @param  odr the output data rate to be set
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int set_x_odr(float odr)
+    {
+        if ( _x_is_enabled == 1 )
+        {
+            if ( write_x_odr( odr ) )
+            {
+                return 1;
+            }
+        }
+        _x_last_odr = odr_hz( odr_bits( odr ) );
+        return 0;
+    }
+
+    int set_g_odr(float odr)
+    {
+        if ( _g_is_enabled == 1 )
+        {
+            if ( update_reg( LSM6DSL_ACC_GYRO_CTRL2_G, LSM6DSL_ACC_GYRO_ODR_G_MASK, odr_bits( odr ) ) )
+            {
+                return 1;
+            }
+        }
+        _g_last_odr = odr_hz( odr_bits( odr ) );
+        return 0;
+    }
+
+    /**
+     * @brief  Set LSM6DSL Accelerometer output data rate and full scale with a
+     *         single CTRL1_XL write, see LSM6DSLSensor::set_x_odr_fs()
+     * @param  odr the output data rate to be set
+     * @param  fullScale the full scale to be set in g
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int set_x_odr_fs(float odr, float fullScale)
+    {
+        if ( _x_is_enabled == 0 )
+        {
+            _x_last_odr = odr_hz( odr_bits( odr ) );
+            return set_x_fs( fullScale );
+        }
+
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL1_XL, LSM6DSL_ACC_GYRO_ODR_XL_MASK | LSM6DSL_ACC_GYRO_FS_XL_MASK,
+                         ( uint8_t )( odr_bits( odr ) | fs_bits( fullScale ) ) ) )
+        {
+            return 1;
+        }
+
+        _x_last_odr = odr_hz( odr_bits( odr ) );
+        _x_sensitivity = sensitivity( fs_bits( fullScale ) );
+
+        if ( _fifo_x == 1 )
+        {
+            return write_fifo_odr( odr );
+        }
+        return 0;
+    }
+
+    /**
+     * @brief  Set LSM6DSL Accelerometer full scale and cache its sensitivity
+     * @param  fullScale the full scale to be set in g
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int set_x_fs(float fullScale)
+    {
+        uint8_t fs = fs_bits( fullScale );
+
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL1_XL, LSM6DSL_ACC_GYRO_FS_XL_MASK, fs ) )
+        {
+            return 1;
+        }
+
+        _x_sensitivity = sensitivity( fs );
+        return 0;
+    }
+
+    /**
+     * @brief  Set LSM6DSL Gyroscope full scale and cache its sensitivity
+     * @param  fullScale the full scale to be set in dps
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int set_g_fs(float fullScale)
+    {
+        uint8_t fs;
+
+        if ( fullScale <= 125.0f )
+        {
+            if ( update_reg( LSM6DSL_ACC_GYRO_CTRL2_G, LSM6DSL_ACC_GYRO_FS_125_MASK, LSM6DSL_ACC_GYRO_FS_125_MASK ) )
+            {
+                return 1;
+            }
+            _g_sensitivity = 4.375f;
+            return 0;
+        }
+
+        fs = ( fullScale <=  245.0f ) ? LSM6DSL_ACC_GYRO_FS_G_245dps
+           : ( fullScale <=  500.0f ) ? LSM6DSL_ACC_GYRO_FS_G_500dps
+           : ( fullScale <= 1000.0f ) ? LSM6DSL_ACC_GYRO_FS_G_1000dps
+           :                            LSM6DSL_ACC_GYRO_FS_G_2000dps;
+
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL2_G, LSM6DSL_ACC_GYRO_FS_125_MASK | LSM6DSL_ACC_GYRO_FS_G_MASK, fs ) )
+        {
+            return 1;
+        }
+
+        _g_sensitivity = ( fs == LSM6DSL_ACC_GYRO_FS_G_245dps )  ?  8.75f
+                       : ( fs == LSM6DSL_ACC_GYRO_FS_G_500dps )  ? 17.50f
+                       : ( fs == LSM6DSL_ACC_GYRO_FS_G_1000dps ) ? 35.00f
+                       :                                           70.00f;
+        return 0;
+    }
+
+    /**
+     * @brief  Accelerometer sensitivity for the current full scale, without bus access
+     * @param  pfData the pointer where the sensitivity [mg/LSB] is stored
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int get_x_sensitivity(float *pfData)
+    {
+        *pfData = _x_sensitivity;
+        return 0;
+    }
+
+    int get_g_sensitivity(float *pfData)
+    {
+        *pfData = _g_sensitivity;
+        return 0;
+    }
+
+    /**
+     * @brief  Read raw data from LSM6DSL Accelerometer in a single 6 bytes burst
+     * @param  pData the pointer where the accelerometer raw data are stored
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int get_x_axes_raw(int16_t *pData)
+    {
+        return read_axes_raw( LSM6DSL_ACC_GYRO_OUTX_L_XL, pData );
+    }
+
+    int get_g_axes_raw(int16_t *pData)
+    {
+        return read_axes_raw( LSM6DSL_ACC_GYRO_OUTX_L_G, pData );
+    }
+
+    /**
+     * @brief  Read data from LSM6DSL Accelerometer
+     * @param  pData the pointer where the accelerometer data [mg] are stored
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int get_x_axes(int32_t *pData)
+    {
+        int16_t dataRaw[3];
+
+        if ( get_x_axes_raw( dataRaw ) )
+        {
+            return 1;
+        }
+
+        pData[0] = ( int32_t )( dataRaw[0] * _x_sensitivity );
+        pData[1] = ( int32_t )( dataRaw[1] * _x_sensitivity );
+        pData[2] = ( int32_t )( dataRaw[2] * _x_sensitivity );
+        return 0;
+    }
+
+    int get_g_axes(int32_t *pData)
+    {
+        int16_t dataRaw[3];
+
+        if ( get_g_axes_raw( dataRaw ) )
+        {
+            return 1;
+        }
+
+        pData[0] = ( int32_t )( dataRaw[0] * _g_sensitivity );
+        pData[1] = ( int32_t )( dataRaw[1] * _g_sensitivity );
+        pData[2] = ( int32_t )( dataRaw[2] * _g_sensitivity );
+        return 0;
+    }
+
+    /**
+     * @brief  Route the accelerometer data set to the FIFO in continuous mode
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int enable_x_fifo(void)
+    {
+        /* XL without decimation, gyroscope not stored. */
+        if ( update_reg( LSM6DSL_ACC_GYRO_FIFO_CTRL3, LSM6DSL_ACC_GYRO_DEC_FIFO_XL_MASK | LSM6DSL_ACC_GYRO_DEC_FIFO_G_MASK,
+                         LSM6DSL_ACC_GYRO_DEC_FIFO_XL_NO_DECIMATION | LSM6DSL_ACC_GYRO_DEC_FIFO_G_DATA_NOT_IN_FIFO ) )
+        {
+            return 1;
+        }
+
+        _fifo_x = 1;
+
+        if ( write_fifo_odr( _x_is_enabled ? _x_last_odr : 0.0f ) )
+        {
+            return 1;
+        }
+
+        return reset_fifo();
+    }
+
+    int disable_fifo(void)
+    {
+        if ( update_reg( LSM6DSL_ACC_GYRO_FIFO_CTRL5, LSM6DSL_ACC_GYRO_FIFO_MODE_MASK, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS )
+          || update_reg( LSM6DSL_ACC_GYRO_FIFO_CTRL3, LSM6DSL_ACC_GYRO_DEC_FIFO_XL_MASK | LSM6DSL_ACC_GYRO_DEC_FIFO_G_MASK, 0 ) )
+        {
+            return 1;
+        }
+        _fifo_x = 0;
+        return 0;
+    }
+
+    /**
+     * @brief  Discard the FIFO content and restart the continuous acquisition
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int reset_fifo(void)
+    {
+        if ( _fifo_x == 0 )
+        {
+            return 1;
+        }
+        if ( update_reg( LSM6DSL_ACC_GYRO_FIFO_CTRL5, LSM6DSL_ACC_GYRO_FIFO_MODE_MASK, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS ) )
+        {
+            return 1;
+        }
+        if ( update_reg( LSM6DSL_ACC_GYRO_FIFO_CTRL5, LSM6DSL_ACC_GYRO_FIFO_MODE_MASK, LSM6DSL_ACC_GYRO_FIFO_MODE_DYN_STREAM_2 ) )
+        {
+            return 1;
+        }
+        _fifo_drain_us = _bus.now_us();
+        return 0;
+    }
+
+    /**
+     * @brief  Get the number of complete X/Y/Z samples waiting in the FIFO
+     * @param  samples the pointer where the number of samples is stored
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int get_fifo_samples(size_t *samples)
+    {
+        uint8_t status[2];
+
+        if ( _bus.read( LSM6DSL_ACC_GYRO_FIFO_STATUS1, status, 2 ) )
+        {
+            return 1;
+        }
+
+        *samples = ( ( ( size_t )( status[1] & LSM6DSL_ACC_GYRO_DIFF_FIFO_STATUS2_MASK ) << 8 ) | status[0] ) / 3;
+        return 0;
+    }
+
+    /**
+     * @brief  Get the FIFO losses counted since the last reset, see LSM6DSLFifo.h
+     * @param  stats the pointer where the counters are stored
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int get_fifo_stats(LSM6DSL_Fifo_Stats_t *stats)
+    {
+        *stats = _fifo_stats;
+        return 0;
+    }
+
+    void reset_fifo_stats(void)
+    {
+        _fifo_stats.overruns = 0;
+        _fifo_stats.resyncs = 0;
+        _fifo_stats.dropped_words = 0;
+        _fifo_stats.lost_samples = 0;
+    }
+
+    /**
+     * @brief  Read n accelerometer samples from the FIFO, waiting for them if needed
+     * @param  pData the pointer where the X/Y/Z raw samples are stored
+     * @param  n the number of samples to read
+     * @param  got the pointer where the number of samples read is stored
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int read_x_block(int16_t *pData, size_t n, size_t *got)
+    {
+        size_t available, chunk, remaining, i;
+        uint8_t *bytes;
+        int16_t *words;
+
+        *got = 0;
+
+        if ( _fifo_x == 0 )
+        {
+            /* No FIFO: one burst per sample. */
+            while ( *got < n )
+            {
+                if ( get_x_axes_raw( pData + 3 * *got ) )
+                {
+                    return 1;
+                }
+                (*got)++;
+            }
+            return 0;
+        }
+
+        while ( *got < n )
+        {
+            if ( read_fifo_status( &available ) )
+            {
+                return 1;
+            }
+
+            remaining = n - *got;
+
+            if ( available == 0 )
+            {
+                chunk = ( remaining < 256 ) ? remaining : 256;
+                _bus.delay_us( ( uint32_t )( chunk * 1000000.0f / _fifo_odr ) );
+                continue;
+            }
+
+            chunk = ( available < remaining ) ? available : remaining;
+            words = pData + ( 3 * *got );
+            bytes = ( uint8_t * )words;
+
+            if ( _bus.read( LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L, bytes, ( uint16_t )( chunk * 6 ) ) )
+            {
+                return 1;
+            }
+
+            for ( i = 0; i < chunk * 3; i++ )
+            {
+                words[i] = ( int16_t )( ( ( uint16_t )bytes[2 * i + 1] << 8 ) | bytes[2 * i] );
+            }
+
+            *got += chunk;
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief  Stamp the level of the DEN input into the LSB of accelerometer
+     *         axes, same as LSM6DSLSensor::enable_den_stamping()
+     * @param  axes the axes whose LSB carries the DEN level
+     * @param  active the DEN level read as 1 in the stamp
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int enable_den_stamping(LSM6DSL_ACC_GYRO_DEN_AXES_t axes = LSM6DSL_ACC_GYRO_DEN_X,
+                            LSM6DSL_ACC_GYRO_DEN_LH_t active = LSM6DSL_ACC_GYRO_DEN_LOW)
+    {
+        /* Level-sensitive mode only, no edge trigger nor latch. */
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL6_G, LSM6DSL_ACC_GYRO_DEN_EDGE_EN_MASK | LSM6DSL_ACC_GYRO_DEN_LVL2_EN_MASK
+                         | LSM6DSL_ACC_GYRO_DEN_LVL_EN_MASK, LSM6DSL_ACC_GYRO_DEN_LVL_EN_ENABLED )
+          || update_reg( LSM6DSL_ACC_GYRO_CTRL5_C, LSM6DSL_ACC_GYRO_DEN_LH_MASK, active )
+          || update_reg( LSM6DSL_ACC_GYRO_CTRL9_XL, LSM6DSL_ACC_GYRO_DEN_AXES_MASK | LSM6DSL_ACC_GYRO_DEN_XL_G_MASK,
+                         axes | LSM6DSL_ACC_GYRO_DEN_XL )
+          || update_reg( LSM6DSL_ACC_GYRO_CTRL4_C, LSM6DSL_ACC_GYRO_DEN_XL_EN_MASK, LSM6DSL_ACC_GYRO_DEN_XL_EN_ENABLED ) )
+        {
+            return 1;
+        }
+        return 0;
+    }
+
+    int disable_den_stamping(void)
+    {
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL6_G, LSM6DSL_ACC_GYRO_DEN_LVL_EN_MASK, LSM6DSL_ACC_GYRO_DEN_LVL_EN_DISABLED )
+          || update_reg( LSM6DSL_ACC_GYRO_CTRL4_C, LSM6DSL_ACC_GYRO_DEN_XL_EN_MASK, LSM6DSL_ACC_GYRO_DEN_XL_EN_DISABLED ) )
+        {
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief  Start the timestamp counter from zero, at its 25 us resolution,
+     *         same as LSM6DSLSensor::enable_timestamp()
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int enable_timestamp(void)
+    {
+        if ( update_reg( LSM6DSL_ACC_GYRO_WAKE_UP_DUR, LSM6DSL_ACC_GYRO_TIMER_HR_MASK, LSM6DSL_ACC_GYRO_TIMER_HR_25us )
+          || update_reg( LSM6DSL_ACC_GYRO_CTRL10_C, LSM6DSL_ACC_GYRO_TIMER_MASK, LSM6DSL_ACC_GYRO_TIMER_ENABLED )
+          || write_reg( LSM6DSL_ACC_GYRO_TIMESTAMP2_REG, 0xAA ) )
+        {
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief  Read the 24-bit timestamp counter in 25 us ticks, in one burst
+     * @param  ticks the counter
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int get_timestamp(uint32_t *ticks)
+    {
+        uint8_t bytes[3];
+
+        if ( _bus.read( LSM6DSL_ACC_GYRO_TIMESTAMP0_REG, bytes, 3 ) )
+        {
+            return 1;
+        }
+        *ticks = ( uint32_t )bytes[0] | ( ( uint32_t )bytes[1] << 8 ) | ( ( uint32_t )bytes[2] << 16 );
+        return 0;
+    }
+
+    int read_reg(uint8_t reg, uint8_t *data)
+    {
+        return _bus.read( reg, data, 1 ) ? 1 : 0;
+    }
+
+    int write_reg(uint8_t reg, uint8_t data)
+    {
+        return _bus.write( reg, &data, 1 ) ? 1 : 0;
+    }
+
+    /**
+     * @brief  Read-modify-write of a register field
+     * @param  reg the register address
+     * @param  mask the bits of the field
+     * @param  value the new value of the field, already shifted
+     * @retval 0 in case of success, an error code otherwise
+     */
+    int update_reg(uint8_t reg, uint8_t mask, uint8_t value)
+    {
+        uint8_t data;
+
+        if ( read_reg( reg, &data ) )
+        {
+            return 1;
+        }
+        data = ( uint8_t )( ( data & ~mask ) | ( value & mask ) );
+        return write_reg( reg, data );
+    }
+
+    Bus &bus(void)
+    {
+        return _bus;
+    }
+
+  private:
+    int read_axes_raw(uint8_t reg, int16_t *pData)
+    {
+        uint8_t regValue[6];
+
+        if ( _bus.read( reg, regValue, 6 ) )
+        {
+            return 1;
+        }
+
+        pData[0] = ( int16_t )( ( ( uint16_t )regValue[1] << 8 ) | regValue[0] );
+        pData[1] = ( int16_t )( ( ( uint16_t )regValue[3] << 8 ) | regValue[2] );
+        pData[2] = ( int16_t )( ( ( uint16_t )regValue[5] << 8 ) | regValue[4] );
+        return 0;
+    }
+
+    int write_x_odr(float odr)
+    {
+        if ( update_reg( LSM6DSL_ACC_GYRO_CTRL1_XL, LSM6DSL_ACC_GYRO_ODR_XL_MASK, odr_bits( odr ) ) )
+        {
+            return 1;
+        }
+
+        /* Keep the FIFO output data rate in line with the accelerometer one. */
+        if ( _fifo_x == 1 )
+        {
+            return write_fifo_odr( odr );
+        }
+        return 0;
+    }
+
+    int write_fifo_odr(float odr)
+    {
+        /* ODR_FIFO uses the ODR_XL codes shifted into bits 6:3. */
+        if ( update_reg( LSM6DSL_ACC_GYRO_FIFO_CTRL5, LSM6DSL_ACC_GYRO_ODR_FIFO_MASK, ( uint8_t )( odr_bits( odr ) >> 1 ) ) )
+        {
+            return 1;
+        }
+        _fifo_odr = odr_hz( odr_bits( odr ) );
+        return 0;
+    }
+
+    /* Same as LSM6DSLSensor::read_fifo_status(): counts overruns and
+       realigns the FIFO output on a sample boundary. */
+    int read_fifo_status(size_t *samples)
+    {
+        uint8_t status[4];
+        uint8_t discard[2 * LSM6DSL_FIFO_PATTERN_WORDS];
+        uint16_t words, pattern, skip;
+        uint32_t now;
+
+        if ( _bus.read( LSM6DSL_ACC_GYRO_FIFO_STATUS1, status, 4 ) )
+        {
+            return 1;
+        }
+        now = _bus.now_us();
+
+        words = ( uint16_t )( ( ( status[1] & LSM6DSL_ACC_GYRO_DIFF_FIFO_STATUS2_MASK ) << 8 ) | status[0] );
+        pattern = ( uint16_t )( ( ( status[3] & 0x03 ) << 8 ) | status[2] );
+
+        if ( status[1] & LSM6DSL_ACC_GYRO_OVERRUN_MASK )
+        {
+            _fifo_stats.overruns++;
+            _fifo_stats.lost_samples += LSM6DSL_Fifo_Overrun_Loss( _fifo_drain_us ? now - _fifo_drain_us : 0, _fifo_odr );
+        }
+
+        if ( pattern != 0 && words > 0 )
+        {
+            skip = ( uint16_t )( LSM6DSL_FIFO_PATTERN_WORDS - pattern );
+            skip = ( skip < words ) ? skip : words;
+
+            if ( _bus.read( LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L, discard, ( uint16_t )( 2 * skip ) ) )
+            {
+                return 1;
+            }
+
+            _fifo_stats.resyncs++;
+            _fifo_stats.dropped_words += skip;
+            _fifo_stats.lost_samples++;  /* The partial sample */
+            words -= skip;
+        }
+
+        _fifo_drain_us = now;
+        *samples = words / LSM6DSL_FIFO_PATTERN_WORDS;
+        return 0;
+    }
+
+    /* FS_XL field value for a requested range. */
+    static uint8_t fs_bits(float fullScale)
+    {
+        return ( fullScale <= 2.0f ) ? LSM6DSL_ACC_GYRO_FS_XL_2g
+             : ( fullScale <= 4.0f ) ? LSM6DSL_ACC_GYRO_FS_XL_4g
+             : ( fullScale <= 8.0f ) ? LSM6DSL_ACC_GYRO_FS_XL_8g
+             :                         LSM6DSL_ACC_GYRO_FS_XL_16g;
+    }
+
+    /* 0.061 mg/LSB at 2 g, doubling with each range. */
+    static float sensitivity(uint8_t fs)
+    {
+        return ( fs == LSM6DSL_ACC_GYRO_FS_XL_2g ) ? 0.061f
+             : ( fs == LSM6DSL_ACC_GYRO_FS_XL_4g ) ? 0.122f
+             : ( fs == LSM6DSL_ACC_GYRO_FS_XL_8g ) ? 0.244f
+             :                                       0.488f;
+    }
+
+    /* ODR_XL/ODR_G field value (bits 7:4) for a requested rate. */
+    static uint8_t odr_bits(float odr)
+    {
+        return ( odr <=    0.0f ) ? 0x00
+             : ( odr <=   13.0f ) ? 0x10
+             : ( odr <=   26.0f ) ? 0x20
+             : ( odr <=   52.0f ) ? 0x30
+             : ( odr <=  104.0f ) ? 0x40
+             : ( odr <=  208.0f ) ? 0x50
+             : ( odr <=  416.0f ) ? 0x60
+             : ( odr <=  833.0f ) ? 0x70
+             : ( odr <= 1660.0f ) ? 0x80
+             : ( odr <= 3330.0f ) ? 0x90
+             :                      0xA0;
+    }
+
+    static float odr_hz(uint8_t bits)
+    {
+        static const float table[11] = { 0.0f, 13.0f, 26.0f, 52.0f, 104.0f, 208.0f, 416.0f, 833.0f, 1660.0f, 3330.0f, 6660.0f };
+        return table[( bits >> 4 ) % 11];
+    }
+
+    Bus &_bus;
+
+    uint8_t _x_is_enabled;
+    float _x_last_odr;
+    uint8_t _g_is_enabled;
+    float _g_last_odr;
+    float _x_sensitivity;
+    float _g_sensitivity;
+    uint8_t _fifo_x;
+    float _fifo_odr;
+    uint32_t _fifo_drain_us;
+    LSM6DSL_Fifo_Stats_t _fifo_stats;
+};
+
+#endif
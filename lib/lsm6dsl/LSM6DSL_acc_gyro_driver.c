@@ -2588,6 +2588,46 @@ mems_status_t LSM6DSL_ACC_GYRO_R_SleepMode_G(void *handle, LSM6DSL_ACC_GYRO_SLEE
   return MEMS_SUCCESS;
 }
 
+/*******************************************************************************
+* Function Name  : LSM6DSL_ACC_GYRO_W_DEN_XL_EN
+* Description    : Write DEN_XL_EN
+* Input          : LSM6DSL_ACC_GYRO_DEN_XL_EN_t
+* Output         : None
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+mems_status_t LSM6DSL_ACC_GYRO_W_DEN_XL_EN(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_EN_t newValue)
+{
+  u8_t value;
+
+  if( !LSM6DSL_ACC_GYRO_read_reg(handle, LSM6DSL_ACC_GYRO_CTRL4_C, &value, 1) )
+    return MEMS_ERROR;
+
+  value &= ~LSM6DSL_ACC_GYRO_DEN_XL_EN_MASK; 
+  value |= newValue;
+  
+  if( !LSM6DSL_ACC_GYRO_write_reg(handle, LSM6DSL_ACC_GYRO_CTRL4_C, &value, 1) )
+    return MEMS_ERROR;
+
+  return MEMS_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name  : LSM6DSL_ACC_GYRO_R_DEN_XL_EN
+* Description    : Read DEN_XL_EN
+* Input          : Pointer to LSM6DSL_ACC_GYRO_DEN_XL_EN_t
+* Output         : Status of DEN_XL_EN see LSM6DSL_ACC_GYRO_DEN_XL_EN_t
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+mems_status_t LSM6DSL_ACC_GYRO_R_DEN_XL_EN(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_EN_t *value)
+{
+ if( !LSM6DSL_ACC_GYRO_read_reg(handle, LSM6DSL_ACC_GYRO_CTRL4_C, (u8_t *)value, 1) )
+    return MEMS_ERROR;
+
+  *value &= LSM6DSL_ACC_GYRO_DEN_XL_EN_MASK; //mask
+
+  return MEMS_SUCCESS;
+}
+
 /*******************************************************************************
 * Function Name  : LSM6DSL_ACC_GYRO_W_SelfTest_XL
 * Description    : Write ST_XL
@@ -3464,6 +3504,86 @@ mems_status_t LSM6DSL_ACC_GYRO_R_HP_SLOPE_XL(void *handle, LSM6DSL_ACC_GYRO_HP_S
   return MEMS_SUCCESS;
 }
 
+/*******************************************************************************
+* Function Name  : LSM6DSL_ACC_GYRO_W_DEN_XL_G
+* Description    : Write DEN_XL_G
+* Input          : LSM6DSL_ACC_GYRO_DEN_XL_G_t
+* Output         : None
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+mems_status_t LSM6DSL_ACC_GYRO_W_DEN_XL_G(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_G_t newValue)
+{
+  u8_t value;
+
+  if( !LSM6DSL_ACC_GYRO_read_reg(handle, LSM6DSL_ACC_GYRO_CTRL9_XL, &value, 1) )
+    return MEMS_ERROR;
+
+  value &= ~LSM6DSL_ACC_GYRO_DEN_XL_G_MASK; 
+  value |= newValue;
+  
+  if( !LSM6DSL_ACC_GYRO_write_reg(handle, LSM6DSL_ACC_GYRO_CTRL9_XL, &value, 1) )
+    return MEMS_ERROR;
+
+  return MEMS_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name  : LSM6DSL_ACC_GYRO_R_DEN_XL_G
+* Description    : Read DEN_XL_G
+* Input          : Pointer to LSM6DSL_ACC_GYRO_DEN_XL_G_t
+* Output         : Status of DEN_XL_G see LSM6DSL_ACC_GYRO_DEN_XL_G_t
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+mems_status_t LSM6DSL_ACC_GYRO_R_DEN_XL_G(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_G_t *value)
+{
+ if( !LSM6DSL_ACC_GYRO_read_reg(handle, LSM6DSL_ACC_GYRO_CTRL9_XL, (u8_t *)value, 1) )
+    return MEMS_ERROR;
+
+  *value &= LSM6DSL_ACC_GYRO_DEN_XL_G_MASK; //mask
+
+  return MEMS_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name  : LSM6DSL_ACC_GYRO_W_DEN_Axes
+* Description    : Write DEN_X, DEN_Y, DEN_Z
+* Input          : LSM6DSL_ACC_GYRO_DEN_AXES_t
+* Output         : None
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+mems_status_t LSM6DSL_ACC_GYRO_W_DEN_Axes(void *handle, LSM6DSL_ACC_GYRO_DEN_AXES_t newValue)
+{
+  u8_t value;
+
+  if( !LSM6DSL_ACC_GYRO_read_reg(handle, LSM6DSL_ACC_GYRO_CTRL9_XL, &value, 1) )
+    return MEMS_ERROR;
+
+  value &= ~LSM6DSL_ACC_GYRO_DEN_AXES_MASK; 
+  value |= newValue;
+  
+  if( !LSM6DSL_ACC_GYRO_write_reg(handle, LSM6DSL_ACC_GYRO_CTRL9_XL, &value, 1) )
+    return MEMS_ERROR;
+
+  return MEMS_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name  : LSM6DSL_ACC_GYRO_R_DEN_Axes
+* Description    : Read DEN_X, DEN_Y, DEN_Z
+* Input          : Pointer to LSM6DSL_ACC_GYRO_DEN_AXES_t
+* Output         : Status of DEN_X, DEN_Y, DEN_Z see LSM6DSL_ACC_GYRO_DEN_AXES_t
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+mems_status_t LSM6DSL_ACC_GYRO_R_DEN_Axes(void *handle, LSM6DSL_ACC_GYRO_DEN_AXES_t *value)
+{
+ if( !LSM6DSL_ACC_GYRO_read_reg(handle, LSM6DSL_ACC_GYRO_CTRL9_XL, (u8_t *)value, 1) )
+    return MEMS_ERROR;
+
+  *value &= LSM6DSL_ACC_GYRO_DEN_AXES_MASK; //mask
+
+  return MEMS_SUCCESS;
+}
+
 /*******************************************************************************
 * Function Name  : LSM6DSL_ACC_GYRO_W_SOFT
 * Description    : Write SOFT_EN
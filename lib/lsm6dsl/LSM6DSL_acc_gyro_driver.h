@@ -1120,6 +1120,21 @@ typedef enum {
 mems_status_t LSM6DSL_ACC_GYRO_W_SleepMode_G(void *handle, LSM6DSL_ACC_GYRO_SLEEP_G_t newValue);
 mems_status_t LSM6DSL_ACC_GYRO_R_SleepMode_G(void *handle, LSM6DSL_ACC_GYRO_SLEEP_G_t *value);
 
+/*******************************************************************************
+* Register      : CTRL4_C
+* Address       : 0X13
+* Bit Group Name: DEN_XL_EN
+* Permission    : RW
+*******************************************************************************/
+typedef enum {
+    LSM6DSL_ACC_GYRO_DEN_XL_EN_DISABLED          =0x00,
+    LSM6DSL_ACC_GYRO_DEN_XL_EN_ENABLED       =0x80,
+} LSM6DSL_ACC_GYRO_DEN_XL_EN_t;
+
+#define       LSM6DSL_ACC_GYRO_DEN_XL_EN_MASK     0x80
+mems_status_t LSM6DSL_ACC_GYRO_W_DEN_XL_EN(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_EN_t newValue);
+mems_status_t LSM6DSL_ACC_GYRO_R_DEN_XL_EN(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_EN_t *value);
+
 /*******************************************************************************
 * Register      : CTRL5_C
 * Address       : 0X14
@@ -1469,6 +1484,39 @@ mems_status_t LSM6DSL_ACC_GYRO_W_LowPassFiltSel_XL(void *handle, LSM6DSL_ACC_GYR
 mems_status_t LSM6DSL_ACC_GYRO_R_LowPassFiltSel_XL(void *handle, LSM6DSL_ACC_GYRO_LPF2_XL_t *value);
 
 
+/*******************************************************************************
+* Register      : CTRL9_XL
+* Address       : 0X18
+* Bit Group Name: DEN_XL_G
+* Permission    : RW
+*******************************************************************************/
+typedef enum {
+    LSM6DSL_ACC_GYRO_DEN_G           =0x00,
+    LSM6DSL_ACC_GYRO_DEN_XL          =0x10,
+} LSM6DSL_ACC_GYRO_DEN_XL_G_t;
+
+#define       LSM6DSL_ACC_GYRO_DEN_XL_G_MASK      0x10
+mems_status_t LSM6DSL_ACC_GYRO_W_DEN_XL_G(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_G_t newValue);
+mems_status_t LSM6DSL_ACC_GYRO_R_DEN_XL_G(void *handle, LSM6DSL_ACC_GYRO_DEN_XL_G_t *value);
+
+/*******************************************************************************
+* Register      : CTRL9_XL
+* Address       : 0X18
+* Bit Group Name: DEN_X, DEN_Y, DEN_Z
+* Permission    : RW
+*******************************************************************************/
+typedef enum {
+    LSM6DSL_ACC_GYRO_DEN_NONE        =0x00,
+    LSM6DSL_ACC_GYRO_DEN_Z       =0x20,
+    LSM6DSL_ACC_GYRO_DEN_Y       =0x40,
+    LSM6DSL_ACC_GYRO_DEN_X       =0x80,
+    LSM6DSL_ACC_GYRO_DEN_XYZ         =0xE0,
+} LSM6DSL_ACC_GYRO_DEN_AXES_t;
+
+#define       LSM6DSL_ACC_GYRO_DEN_AXES_MASK      0xE0
+mems_status_t LSM6DSL_ACC_GYRO_W_DEN_Axes(void *handle, LSM6DSL_ACC_GYRO_DEN_AXES_t newValue);
+mems_status_t LSM6DSL_ACC_GYRO_R_DEN_Axes(void *handle, LSM6DSL_ACC_GYRO_DEN_AXES_t *value);
+
 /*******************************************************************************
 * Register      : CTRL9_XL
 * Address       : 0X18
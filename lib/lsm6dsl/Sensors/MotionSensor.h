@@ -46,6 +46,7 @@
 /* Includes ------------------------------------------------------------------*/
 
 #include <Component.h>
+#include <stddef.h>
 
 
 /* Classes  ------------------------------------------------------------------*/
@@ -117,6 +118,33 @@ public:
 	 */
 	virtual int set_x_fs(float fs) = 0;
 
+	/**
+	 * @brief       Get a block of consecutive accelerometer raw data X/Y/Z-axes values
+	 *              in device specific LSB units
+	 * @param[out]  p_data Pointer to where to store the accelerometer raw data to.
+	 *              p_data must point to an array of (at least) 3 * n elements,
+	 *              filled with X/Y/Z triplets in acquisition order.
+	 * @param[in]   n Number of samples to read.
+	 * @param[out]  p_got Pointer to where the number of samples actually read is stored to
+	 * @return      0 in case of success, an error code otherwise
+	 * @note        This generic implementation issues one get_x_axes_raw() per sample.
+	 *              Implementers with a hardware FIFO should override it with a burst read.
+	 */
+	virtual int read_x_block(int16_t *p_data, size_t n, size_t *p_got) {
+		int ret;
+
+		*p_got = 0;
+		while (*p_got < n) {
+			ret = get_x_axes_raw(p_data + (3 * *p_got));
+			if (ret) {
+				return ret;
+			}
+			(*p_got)++;
+		}
+
+		return 0;
+	}
+
     /**
      * @brief Destructor.
      */
@@ -0,0 +1,518 @@
+/**
+ ******************************************************************************
+ * @file    LSM6DSLSimulator.h
+ * @brief   Register-level LSM6DSL model for host builds.
+ ******************************************************************************
+ * LSM6DSLSimulator emulates the register file, the output data rates and the
+ * 4 KB FIFO of the LSM6DSL. Samples come from a user supplied source and are
+ * produced as simulated time advances, either explicitly with advance_us() or
+ * through the delay_us() of LSM6DSLSimBus, so that LSM6DSLSensorT<LSM6DSLSimBus>
+ * runs the firmware acquisition code unchanged on a PC.
+ *
+ * The level of the DEN input, see set_den(), is stamped into the LSB of the
+ * accelerometer axes selected in CTRL9_XL in level-sensitive mode.
+ *
+ * The oscillator of the sensor may run off its nominal frequency, see
+ * set_clock_ppm(): the output data rates and the timestamp counter, at the
+ * resolution set by TIMER_HR, then drift together against simulated time.
+ *
+ * Bus transactions and bytes are counted to compare access strategies.
+ *
+ * @note   Host only, this header does not depend on mbed.
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+
+#ifndef __LSM6DSLSimulator_H__
+#define __LSM6DSLSimulator_H__
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+#include "LSM6DSL_acc_gyro_driver.h"
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class LSM6DSLSimulator
+{
+  public:
+    /** Sample source: fills the raw X/Y/Z of sample number index of a data set. */
+    typedef void (*source_t)(void *context, uint32_t index, int16_t *xl, int16_t *g);
+
+    static const uint16_t FIFO_WORDS = 2048;
+
+    LSM6DSLSimulator() : _source(NULL), _context(NULL), _den(false), _clock(1.0)
+    {
+        reset();
+    }
+
+    /**
+     * @brief  Power-on reset: register defaults, empty FIFO, time and counters at zero.
+     */
+    void reset(void)
+    {
+        memset(_regs, 0, sizeof(_regs));
+        _regs[LSM6DSL_ACC_GYRO_WHO_AM_I_REG] = LSM6DSL_ACC_GYRO_WHO_AM_I;
+        _regs[LSM6DSL_ACC_GYRO_CTRL3_C] = LSM6DSL_ACC_GYRO_IF_INC_MASK;
+        _regs[LSM6DSL_ACC_GYRO_CTRL9_XL] = LSM6DSL_ACC_GYRO_DEN_XYZ;
+        _now_us = 0.0;
+        _timer_us = 0.0;
+        _next_xl_us = _next_g_us = _next_fifo_us = 0.0;
+        _xl_index = _g_index = 0;
+        memset(_xl, 0, sizeof(_xl));
+        memset(_g, 0, sizeof(_g));
+        flush_fifo();
+        reset_counters();
+    }
+
+    void set_source(source_t source, void *context)
+    {
+        _source = source;
+        _context = context;
+    }
+
+    /**
+     * @brief  Drive the DEN input, the INT2 pin, from the next sample on.
+     * @param  high the electrical level of the pin
+     */
+    void set_den(bool high)
+    {
+        _den = high;
+    }
+
+    /**
+     * @brief  Offset of the sensor oscillator from its nominal frequency.
+     * @param  ppm positive for a sensor running fast
+     */
+    void set_clock_ppm(double ppm)
+    {
+        _clock = 1.0 + ppm * 1e-6;
+    }
+
+    /**
+     * @brief  Let simulated time run, producing the samples due meanwhile.
+     * @param  us the time to advance in microseconds
+     */
+    void advance_us(double us)
+    {
+        double end = _now_us + us;
+
+        for (;;) {
+            double next = end;
+            int event = 0;
+
+            /* Earliest event first, on a tie the output registers are
+               updated before the FIFO stores them. */
+            if (odr_hz(_regs[LSM6DSL_ACC_GYRO_CTRL1_XL] >> 4) > 0.0 && _next_xl_us <= next) {
+                next = _next_xl_us;
+                event = 1;
+            }
+            if (odr_hz(_regs[LSM6DSL_ACC_GYRO_CTRL2_G] >> 4) > 0.0 && _next_g_us <= end && (!event || _next_g_us < next)) {
+                next = _next_g_us;
+                event = 2;
+            }
+            if (fifo_odr_hz() > 0.0 && _next_fifo_us <= end && (!event || _next_fifo_us < next)) {
+                next = _next_fifo_us;
+                event = 3;
+            }
+            if (!event) {
+                break;
+            }
+            _now_us = next;
+            if (event == 1) {
+                sample_xl();
+                _next_xl_us += 1e6 / (odr_hz(_regs[LSM6DSL_ACC_GYRO_CTRL1_XL] >> 4) * _clock);
+            } else if (event == 2) {
+                sample_g();
+                _next_g_us += 1e6 / (odr_hz(_regs[LSM6DSL_ACC_GYRO_CTRL2_G] >> 4) * _clock);
+            } else {
+                store_fifo_pattern();
+                _next_fifo_us += 1e6 / (fifo_odr_hz() * _clock);
+            }
+        }
+        _now_us = end;
+    }
+
+    /**
+     * @brief  Register read with auto increment, as one bus transaction.
+     * @retval 0
+     */
+    uint8_t read(uint8_t reg, uint8_t *pBuffer, uint16_t NumByteToRead)
+    {
+        _transactions++;
+        _bytes += 1 + NumByteToRead;
+        for (uint16_t i = 0; i < NumByteToRead; i++) {
+            pBuffer[i] = read_byte(reg);
+            reg = next_address(reg);
+        }
+        return 0;
+    }
+
+    /**
+     * @brief  Register write with auto increment, as one bus transaction.
+     * @retval 0
+     */
+    uint8_t write(uint8_t reg, const uint8_t *pBuffer, uint16_t NumByteToWrite)
+    {
+        _transactions++;
+        _bytes += 1 + NumByteToWrite;
+        for (uint16_t i = 0; i < NumByteToWrite; i++) {
+            write_byte(reg, pBuffer[i]);
+            reg = next_address(reg);
+        }
+        return 0;
+    }
+
+    uint8_t reg(uint8_t address) const
+    {
+        return _regs[address & 0x7F];
+    }
+
+    double now_us(void) const
+    {
+        return _now_us;
+    }
+
+    uint16_t fifo_words(void) const
+    {
+        return _fifo_count;
+    }
+
+    uint32_t transactions(void) const
+    {
+        return _transactions;
+    }
+
+    uint32_t bytes(void) const
+    {
+        return _bytes;
+    }
+
+    void reset_counters(void)
+    {
+        _transactions = 0;
+        _bytes = 0;
+    }
+
+  private:
+    static double odr_hz(uint8_t code)
+    {
+        static const double table[11] = { 0.0, 12.5, 26.0, 52.0, 104.0, 208.0, 416.0, 833.0, 1666.0, 3330.0, 6660.0 };
+        return (code < 11) ? table[code] : 0.0;
+    }
+
+    double fifo_odr_hz(void) const
+    {
+        return odr_hz((_regs[LSM6DSL_ACC_GYRO_FIFO_CTRL5] & LSM6DSL_ACC_GYRO_ODR_FIFO_MASK) >> 3);
+    }
+
+    uint8_t fifo_mode(void) const
+    {
+        return _regs[LSM6DSL_ACC_GYRO_FIFO_CTRL5] & LSM6DSL_ACC_GYRO_FIFO_MODE_MASK;
+    }
+
+    uint8_t pattern_words(void) const
+    {
+        uint8_t dec = _regs[LSM6DSL_ACC_GYRO_FIFO_CTRL3];
+        return (uint8_t)(((dec & LSM6DSL_ACC_GYRO_DEC_FIFO_G_MASK) ? 3 : 0) + ((dec & LSM6DSL_ACC_GYRO_DEC_FIFO_XL_MASK) ? 3 : 0));
+    }
+
+    uint8_t next_address(uint8_t reg) const
+    {
+        if (!(_regs[LSM6DSL_ACC_GYRO_CTRL3_C] & LSM6DSL_ACC_GYRO_IF_INC_MASK)) {
+            return reg;
+        }
+        /* FIFO output rolls back on itself so that a burst drains the FIFO. */
+        if (reg == LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_H) {
+            return LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L;
+        }
+        return (uint8_t)((reg + 1) & 0x7F);
+    }
+
+    void sample_xl(void)
+    {
+        int16_t unused[3];
+
+        if (_source) {
+            _source(_context, _xl_index, _xl, unused);
+        }
+        stamp_den(_xl);
+        _xl_index++;
+        _regs[LSM6DSL_ACC_GYRO_STATUS_REG] |= LSM6DSL_ACC_GYRO_XLDA_MASK;
+    }
+
+    /* Level-sensitive DEN stamping of the accelerometer, CTRL6_G LVL_EN
+       with CTRL4_C DEN_XL_EN and CTRL9_XL DEN_XL_G. */
+    void stamp_den(int16_t *axes) const
+    {
+        uint8_t ctrl9 = _regs[LSM6DSL_ACC_GYRO_CTRL9_XL];
+        bool active = (_den == ((_regs[LSM6DSL_ACC_GYRO_CTRL5_C] & LSM6DSL_ACC_GYRO_DEN_LH_MASK) != 0));
+
+        if (!(_regs[LSM6DSL_ACC_GYRO_CTRL6_G] & LSM6DSL_ACC_GYRO_DEN_LVL_EN_MASK)
+            || !(_regs[LSM6DSL_ACC_GYRO_CTRL4_C] & LSM6DSL_ACC_GYRO_DEN_XL_EN_MASK)
+            || !(ctrl9 & LSM6DSL_ACC_GYRO_DEN_XL_G_MASK)) {
+            return;
+        }
+        for (int i = 0; i < 3; i++) {
+            if (ctrl9 & (LSM6DSL_ACC_GYRO_DEN_X >> i)) {
+                axes[i] = (int16_t)((axes[i] & ~1) | (active ? 1 : 0));
+            }
+        }
+    }
+
+    void sample_g(void)
+    {
+        int16_t unused[3];
+
+        if (_source) {
+            _source(_context, _g_index, unused, _g);
+        }
+        _g_index++;
+        _regs[LSM6DSL_ACC_GYRO_STATUS_REG] |= LSM6DSL_ACC_GYRO_GDA_MASK;
+    }
+
+    void store_fifo_pattern(void)
+    {
+        uint8_t dec = _regs[LSM6DSL_ACC_GYRO_FIFO_CTRL3];
+        uint8_t mode = fifo_mode();
+
+        /* Continuous mode (110b) and FIFO mode (001b) are modelled, other
+           modes hold the FIFO empty. */
+        if (mode != LSM6DSL_ACC_GYRO_FIFO_MODE_FIFO && mode != LSM6DSL_ACC_GYRO_FIFO_MODE_DYN_STREAM_2) {
+            return;
+        }
+        /* Gyroscope data set comes first in the pattern. */
+        if (dec & LSM6DSL_ACC_GYRO_DEC_FIFO_G_MASK) {
+            for (int i = 0; i < 3; i++) {
+                push_word((uint16_t)_g[i]);
+            }
+        }
+        if (dec & LSM6DSL_ACC_GYRO_DEC_FIFO_XL_MASK) {
+            for (int i = 0; i < 3; i++) {
+                push_word((uint16_t)_xl[i]);
+            }
+        }
+    }
+
+    void push_word(uint16_t word)
+    {
+        if (_fifo_count == FIFO_WORDS) {
+            if (fifo_mode() == LSM6DSL_ACC_GYRO_FIFO_MODE_FIFO) {
+                return;
+            }
+            /* Continuous mode: the oldest word is overwritten. */
+            pop_word();
+            _overrun = true;
+        }
+        _fifo[(_fifo_head + _fifo_count) % FIFO_WORDS] = word;
+        _fifo_count++;
+    }
+
+    uint16_t pop_word(void)
+    {
+        uint16_t word;
+        uint8_t len = pattern_words();
+
+        if (_fifo_count == 0) {
+            return 0;
+        }
+        word = _fifo[_fifo_head];
+        _fifo_head = (uint16_t)((_fifo_head + 1) % FIFO_WORDS);
+        _fifo_count--;
+        _pattern = len ? (uint16_t)((_pattern + 1) % len) : 0;
+        return word;
+    }
+
+    void flush_fifo(void)
+    {
+        _fifo_head = 0;
+        _fifo_count = 0;
+        _pattern = 0;
+        _overrun = false;
+        _fifo_low_pending = false;
+    }
+
+    uint8_t read_byte(uint8_t reg)
+    {
+        uint16_t fth;
+        uint8_t value;
+
+        reg &= 0x7F;
+        switch (reg) {
+            case LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L:
+                _fifo_word = pop_word();
+                _fifo_low_pending = true;
+                /* The overrun flag holds until the FIFO is read. */
+                _overrun = false;
+                return (uint8_t)(_fifo_word & 0xFF);
+            case LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_H:
+                /* High byte of the word whose low byte was just read. */
+                if (!_fifo_low_pending) {
+                    _fifo_word = pop_word();
+                }
+                _fifo_low_pending = false;
+                return (uint8_t)(_fifo_word >> 8);
+            case LSM6DSL_ACC_GYRO_FIFO_STATUS1:
+                return (uint8_t)(diff_fifo() & 0xFF);
+            case LSM6DSL_ACC_GYRO_FIFO_STATUS2:
+                fth = (uint16_t)(((_regs[LSM6DSL_ACC_GYRO_FIFO_CTRL2] & 0x07) << 8) | _regs[LSM6DSL_ACC_GYRO_FIFO_CTRL1]);
+                value = (uint8_t)((diff_fifo() >> 8) & 0x07);
+                value |= (_fifo_count == 0) ? LSM6DSL_ACC_GYRO_FIFO_EMPTY_MASK : 0;
+                value |= (_fifo_count == FIFO_WORDS) ? LSM6DSL_ACC_GYRO_FIFO_FULL_MASK : 0;
+                value |= _overrun ? LSM6DSL_ACC_GYRO_OVERRUN_MASK : 0;
+                value |= (fth && _fifo_count >= fth) ? 0x80 : 0;
+                return value;
+            case LSM6DSL_ACC_GYRO_FIFO_STATUS3:
+                return (uint8_t)(_pattern & 0xFF);
+            case LSM6DSL_ACC_GYRO_FIFO_STATUS4:
+                return (uint8_t)((_pattern >> 8) & 0x03);
+            case LSM6DSL_ACC_GYRO_TIMESTAMP0_REG:
+            case LSM6DSL_ACC_GYRO_TIMESTAMP1_REG:
+            case LSM6DSL_ACC_GYRO_TIMESTAMP2_REG:
+                return (uint8_t)(timestamp() >> (8 * (reg - LSM6DSL_ACC_GYRO_TIMESTAMP0_REG)));
+            case LSM6DSL_ACC_GYRO_OUTX_L_G: case LSM6DSL_ACC_GYRO_OUTX_H_G:
+            case LSM6DSL_ACC_GYRO_OUTY_L_G: case LSM6DSL_ACC_GYRO_OUTY_H_G:
+            case LSM6DSL_ACC_GYRO_OUTZ_L_G: case LSM6DSL_ACC_GYRO_OUTZ_H_G:
+                _regs[LSM6DSL_ACC_GYRO_STATUS_REG] &= (uint8_t)~LSM6DSL_ACC_GYRO_GDA_MASK;
+                return output_byte(_g, reg - LSM6DSL_ACC_GYRO_OUTX_L_G);
+            case LSM6DSL_ACC_GYRO_OUTX_L_XL: case LSM6DSL_ACC_GYRO_OUTX_H_XL:
+            case LSM6DSL_ACC_GYRO_OUTY_L_XL: case LSM6DSL_ACC_GYRO_OUTY_H_XL:
+            case LSM6DSL_ACC_GYRO_OUTZ_L_XL: case LSM6DSL_ACC_GYRO_OUTZ_H_XL:
+                _regs[LSM6DSL_ACC_GYRO_STATUS_REG] &= (uint8_t)~LSM6DSL_ACC_GYRO_XLDA_MASK;
+                return output_byte(_xl, reg - LSM6DSL_ACC_GYRO_OUTX_L_XL);
+            default:
+                return _regs[reg];
+        }
+    }
+
+    /* DIFF_FIFO is 11 bits wide, a full FIFO is flagged by FIFO_FULL. */
+    uint16_t diff_fifo(void) const
+    {
+        return (_fifo_count < FIFO_WORDS) ? _fifo_count : (uint16_t)(FIFO_WORDS - 1);
+    }
+
+    /* 24-bit counter of the sensor oscillator, from the last reset. */
+    uint32_t timestamp(void) const
+    {
+        double lsb_us = (_regs[LSM6DSL_ACC_GYRO_WAKE_UP_DUR] & LSM6DSL_ACC_GYRO_TIMER_HR_MASK) ? 25.0 : 6400.0;
+
+        if (!(_regs[LSM6DSL_ACC_GYRO_CTRL10_C] & LSM6DSL_ACC_GYRO_TIMER_MASK)) {
+            return 0;
+        }
+        return (uint32_t)((_now_us - _timer_us) * _clock / lsb_us) & 0xFFFFFF;
+    }
+
+    static uint8_t output_byte(const int16_t *axes, int offset)
+    {
+        uint16_t word = (uint16_t)axes[offset / 2];
+        return (uint8_t)((offset & 1) ? (word >> 8) : (word & 0xFF));
+    }
+
+    void write_byte(uint8_t reg, uint8_t value)
+    {
+        uint8_t previous;
+
+        reg &= 0x7F;
+        /* Writing 0xAA to TIMESTAMP2 resets the counter. */
+        if (reg == LSM6DSL_ACC_GYRO_TIMESTAMP2_REG) {
+            if (value == 0xAA) {
+                _timer_us = _now_us;
+            }
+            return;
+        }
+        /* Identification, status and output registers are read only. */
+        if (reg == LSM6DSL_ACC_GYRO_WHO_AM_I_REG || (reg >= LSM6DSL_ACC_GYRO_WAKE_UP_SRC && reg <= LSM6DSL_ACC_GYRO_FUNC_SRC)) {
+            return;
+        }
+        previous = _regs[reg];
+        _regs[reg] = value;
+
+        if (reg == LSM6DSL_ACC_GYRO_FIFO_CTRL5 && (value & LSM6DSL_ACC_GYRO_FIFO_MODE_MASK) == LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS) {
+            /* Bypass mode empties the FIFO and clears the overrun flag. */
+            flush_fifo();
+        }
+        if (reg == LSM6DSL_ACC_GYRO_CTRL10_C && !(previous & LSM6DSL_ACC_GYRO_TIMER_MASK)) {
+            _timer_us = _now_us;
+        }
+        /* The FIFO is filled on the accelerometer sample clock, it stores
+           each sample as it is produced. */
+        if (reg == LSM6DSL_ACC_GYRO_CTRL1_XL) {
+            _next_xl_us = _now_us;
+            _next_fifo_us = _now_us;
+        } else if (reg == LSM6DSL_ACC_GYRO_CTRL2_G) {
+            _next_g_us = _now_us;
+        } else if (reg == LSM6DSL_ACC_GYRO_FIFO_CTRL5) {
+            _next_fifo_us = (_next_xl_us > _now_us) ? _next_xl_us : _now_us;
+        }
+    }
+
+    source_t _source;
+    void *_context;
+    bool _den;
+    double _clock;
+
+    uint8_t _regs[128];
+    double _now_us;
+    double _timer_us;
+    double _next_xl_us;
+    double _next_g_us;
+    double _next_fifo_us;
+    uint32_t _xl_index;
+    uint32_t _g_index;
+    int16_t _xl[3];
+    int16_t _g[3];
+
+    uint16_t _fifo[FIFO_WORDS];
+    uint16_t _fifo_head;
+    uint16_t _fifo_count;
+    uint16_t _pattern;
+    uint16_t _fifo_word;
+    bool _fifo_low_pending;
+    bool _overrun;
+
+    uint32_t _transactions;
+    uint32_t _bytes;
+};
+
+/**
+ * Bus policy binding LSM6DSLSensorT to a simulator: delays advance simulated time, now_us() reads it.
+ */
+class LSM6DSLSimBus
+{
+  public:
+    static const bool spi_3wire = false;
+
+    explicit LSM6DSLSimBus(LSM6DSLSimulator &sim) : _sim(sim) {}
+
+    uint8_t read(uint8_t reg, uint8_t *pBuffer, uint16_t NumByteToRead)
+    {
+        return _sim.read(reg, pBuffer, NumByteToRead);
+    }
+
+    uint8_t write(uint8_t reg, const uint8_t *pBuffer, uint16_t NumByteToWrite)
+    {
+        return _sim.write(reg, pBuffer, NumByteToWrite);
+    }
+
+    void delay_us(uint32_t us)
+    {
+        _sim.advance_us(us);
+    }
+
+    uint32_t now_us(void)
+    {
+        return (uint32_t) _sim.now_us();
+    }
+
+    LSM6DSLSimulator &simulator(void)
+    {
+        return _sim;
+    }
+
+  private:
+    LSM6DSLSimulator &_sim;
+};
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ * @file    ReplaySensor.h
+ * @brief   Recorded capture played back as the sensor FIFO of Acquisition.
+ ******************************************************************************
+ * ReplaySensor provides the FIFO calls Acquisition uses, get_fifo_samples(),
+ * read_x_block(), reset_fifo() and get_fifo_stats(), over a capture of float
+ * x, y, z triplets in g, converted back to raw values at a given sensitivity.
+ *
+ * The FIFO holds at most batch() samples per call, 1 by default so that the
+ * caller knows the exact sample a window ends on: the samples read so far,
+ * see position(). Resetting the FIFO skips the samples the sensor would have
+ * produced meanwhile, set_reset_gap(), none by default.
+ *
+ * @note   Host only, this header does not depend on mbed.
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+
+#ifndef __ReplaySensor_H__
+#define __ReplaySensor_H__
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "LSM6DSLFifo.h"
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class ReplaySensor
+{
+  public:
+    /**
+     * @param  xyz the capture, x, y, z interleaved in g
+     * @param  samples number of samples of the capture
+     * @param  sensitivity mg/LSB of the raw values, as get_x_sensitivity()
+     */
+    ReplaySensor(const float *xyz, size_t samples, float sensitivity) :
+        _xyz(xyz), _samples(samples), _lsb_per_g(1000.0f / sensitivity), _position(0), _batch(1), _reset_gap(0)
+    {
+    }
+
+    void set_batch(size_t batch)
+    {
+        _batch = batch ? batch : 1;
+    }
+
+    void set_reset_gap(size_t samples)
+    {
+        _reset_gap = samples;
+    }
+
+    /* Samples read or skipped since the start of the capture */
+    size_t position(void) const
+    {
+        return _position;
+    }
+
+    bool done(void) const
+    {
+        return _position >= _samples;
+    }
+
+    int get_fifo_samples(size_t *samples)
+    {
+        size_t left = (_position < _samples) ? _samples - _position : 0;
+
+        *samples = (left < _batch) ? left : _batch;
+        return 0;
+    }
+
+    int read_x_block(int16_t *raw, size_t samples, size_t *read)
+    {
+        float lsb;
+
+        for (*read = 0; *read < samples && _position < _samples; (*read)++, _position++) {
+            for (uint8_t i = 0; i < 3; i++) {
+                lsb = floorf(_xyz[3 * _position + i] * _lsb_per_g + 0.5f);
+                raw[3 * *read + i] = (int16_t)(lsb > 32767.0f ? 32767.0f : lsb < -32768.0f ? -32768.0f : lsb);
+            }
+        }
+        return 0;
+    }
+
+    int reset_fifo(void)
+    {
+        _position += _reset_gap;
+        return 0;
+    }
+
+    /* No sensor clock behind a capture, windows are not synchronized */
+    int get_timestamp(uint32_t *ticks)
+    {
+        *ticks = 0;
+        return 1;
+    }
+
+    int get_fifo_stats(LSM6DSL_Fifo_Stats_t *stats)
+    {
+        stats->overruns = 0;
+        stats->resyncs = 0;
+        stats->dropped_words = 0;
+        stats->lost_samples = 0;
+        return 0;
+    }
+
+  private:
+    const float *_xyz;
+    size_t _samples;
+    float _lsb_per_g;
+    size_t _position;
+    size_t _batch;
+    size_t _reset_gap;
+};
+
+#endif
@@ -0,0 +1,439 @@
+/**
+ ******************************************************************************
+ * @file    StrumSynth.h
+ * @brief   Synthetic ukulele strums as seen by a body-mounted accelerometer.
+ ******************************************************************************
+ * StrumSynth produces accelerometer samples of an instrument being strummed:
+ *
+ *  - each of the four strings (G4 C4 E4 A4, re-entrant tuning) is a bank of
+ *    slightly inharmonic partials decaying exponentially, higher partials
+ *    faster, plucked in turn with a short attack as the hand strokes down
+ *    or up across them;
+ *  - the body adds resonant modes excited by the strings, and a low
+ *    frequency thump from the hand hitting the instrument;
+ *  - vibrations are projected on a direction of the sensor frame, on top of
+ *    gravity for a given pitch and roll with a slow sway;
+ *  - white sensor noise of a given density, then quantization and clipping
+ *    at the full scale.
+ *
+ * Chords, strum times, stroke direction, velocity and stroke speed are drawn
+ * from a seeded generator: a seed always yields the same samples.
+ *
+ * Samples are produced one at a time, either as g values for captures
+ * (next()) or as raw output for LSM6DSLSimulator (source()).
+ *
+ * @note   No mbed dependency, also used on target by src/BenchSuite.h.
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+
+#ifndef __StrumSynth_H__
+#define __StrumSynth_H__
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class StrumSynth
+{
+  public:
+    static const uint8_t STRINGS = 4;
+    static const uint8_t PARTIALS = 8;
+    static const uint8_t BODY_MODES = 2;
+    static const uint8_t CHORDS = 8;
+
+    explicit StrumSynth(uint32_t seed = 1)
+    {
+        reset(seed);
+    }
+
+    /**
+     * @brief  Restart the signal from sample 0 with default settings.
+     * @param  seed the random sequence to use
+     */
+    void reset(uint32_t seed)
+    {
+        memset(_strings, 0, sizeof(_strings));
+        memset(_body, 0, sizeof(_body));
+        _seed = seed ? seed : 1;
+        _index = 0;
+        _strums = 0;
+        _thump = 0.0f;
+        _sway_phase = 0.0f;
+        _gaussian_spare = 0.0f;
+        _has_spare = false;
+        _odr = 0.0f;
+        _chord = -1;
+        set_interval(1.0f, 2.5f);
+        set_velocity(0.1f, 0.5f);
+        set_orientation(20.0f, 10.0f);
+        set_noise_density(130.0f);
+        set_format(3330.0f, 4.0f);
+        _next_strum = draw_interval();
+    }
+
+    /**
+     * @brief  Output data rate and full scale, applied from the next sample.
+     * @param  odr the sample rate in Hz
+     * @param  fullScale the range in g, for raw samples
+     */
+    void set_format(float odr, float fullScale)
+    {
+        /* Times already drawn are kept in seconds */
+        if (_index > 0 && _odr > 0.0f) {
+            _next_strum = _index + (uint64_t)((_next_strum - _index) * odr / _odr);
+        }
+        _odr = odr;
+        _lsb_per_g = 1000.0f / (0.061f * (fullScale <= 2.0f ? 1 : fullScale <= 4.0f ? 2 : fullScale <= 8.0f ? 4 : 8));
+        for (uint8_t s = 0; s < STRINGS; s++) {
+            tune(&_strings[s]);
+        }
+        tune_body();
+        _noise_sigma = _noise_density * 1e-6f * sqrtf(_odr / 2.0f);
+    }
+
+    /**
+     * @brief  Random time between two strums, from their onsets.
+     */
+    void set_interval(float min_s, float max_s)
+    {
+        _interval_min = min_s;
+        _interval_max = max_s > min_s ? max_s : min_s;
+    }
+
+    /**
+     * @brief  Random strum strength, as the fundamental amplitude of each
+     *         string in g.
+     */
+    void set_velocity(float min_g, float max_g)
+    {
+        _velocity_min = min_g;
+        _velocity_max = max_g > min_g ? max_g : min_g;
+    }
+
+    /**
+     * @brief  Play a single chord, to compare strums of a same chord.
+     * @param  chord index in the chord table, below CHORDS, or -1 to draw
+     *         each chord at random
+     */
+    void set_chord(int8_t chord)
+    {
+        _chord = (chord < CHORDS) ? chord : -1;
+    }
+
+    /**
+     * @brief  Instrument orientation, gravity seen by the sensor.
+     * @param  pitch_deg rotation about the y axis in degrees
+     * @param  roll_deg rotation about the x axis in degrees
+     */
+    void set_orientation(float pitch_deg, float roll_deg)
+    {
+        _pitch = pitch_deg * (float)M_PI / 180.0f;
+        _roll = roll_deg * (float)M_PI / 180.0f;
+    }
+
+    /**
+     * @brief  Sensor noise density in ug/sqrt(Hz), 130 for the LSM6DSL at 4 g.
+     */
+    void set_noise_density(float ug_per_sqrt_hz)
+    {
+        _noise_density = ug_per_sqrt_hz;
+        _noise_sigma = _noise_density * 1e-6f * sqrtf(_odr / 2.0f);
+    }
+
+    /**
+     * @brief  Produce the next sample.
+     * @param  xyz acceleration on x, y and z in g
+     * @retval true if a strum starts on this sample
+     */
+    bool next(float *xyz)
+    {
+        bool onset = (_index == _next_strum);
+        float strings = 0.0f, body = 0.0f, vibration, sway, pitch, roll;
+
+        if (onset) {
+            strum();
+            _next_strum = _index + draw_interval();
+        }
+
+        for (uint8_t s = 0; s < STRINGS; s++) {
+            strings += string_sample(&_strings[s]);
+        }
+        for (uint8_t m = 0; m < BODY_MODES; m++) {
+            body += resonate(&_body[m], strings);
+        }
+        vibration = strings + body + _thump;
+        _thump *= _thump_decay;
+
+        /* Slow sway of a few tenths of a degree at 0.3 Hz */
+        _sway_phase += 2.0f * (float)M_PI * 0.3f / _odr;
+        if (_sway_phase > 2.0f * (float)M_PI) {
+            _sway_phase -= 2.0f * (float)M_PI;
+        }
+        sway = 0.005f * sinf(_sway_phase);
+        pitch = _pitch + sway;
+        roll = _roll + 0.5f * sway;
+
+        /* Vibrations mostly normal to the top plate, the sensor z axis */
+        xyz[0] = -sinf(pitch) + 0.15f * vibration + _noise_sigma * gaussian();
+        xyz[1] = cosf(pitch) * sinf(roll) + 0.25f * vibration + _noise_sigma * gaussian();
+        xyz[2] = cosf(pitch) * cosf(roll) + 0.95f * vibration + _noise_sigma * gaussian();
+
+        _index++;
+        return onset;
+    }
+
+    /**
+     * @brief  Produce the next sample as raw sensor output.
+     * @param  xl raw x, y and z, clipped at the full scale
+     * @retval true if a strum starts on this sample
+     */
+    bool next_raw(int16_t *xl)
+    {
+        float xyz[3], lsb;
+        bool onset = next(xyz);
+
+        for (uint8_t i = 0; i < 3; i++) {
+            lsb = floorf(xyz[i] * _lsb_per_g + 0.5f);
+            xl[i] = (int16_t)(lsb > 32767.0f ? 32767.0f : lsb < -32768.0f ? -32768.0f : lsb);
+        }
+        return onset;
+    }
+
+    /**
+     * @brief  LSM6DSLSimulator source, context being the StrumSynth.
+     * @note   Samples are produced in sequence whatever the index, the
+     *         simulator asking for them in order.
+     */
+    static void source(void *context, uint32_t index, int16_t *xl, int16_t *g)
+    {
+        (void)index;
+        ((StrumSynth *)context)->next_raw(xl);
+        g[0] = g[1] = g[2] = 0;
+    }
+
+    /* Samples produced since reset() */
+    uint64_t samples(void) const
+    {
+        return _index;
+    }
+
+    /* Strums started since reset() */
+    uint32_t strums(void) const
+    {
+        return _strums;
+    }
+
+    /* Fret of each string, G C E A order, for the chords drawn, see set_chord() */
+    static const int8_t *chord_frets(uint8_t chord)
+    {
+        static const int8_t frets[CHORDS][STRINGS] = {
+            { 0, 0, 0, 3 },     /* C  */
+            { 0, 2, 3, 2 },     /* G  */
+            { 2, 0, 0, 0 },     /* Am */
+            { 2, 0, 1, 0 },     /* F  */
+            { 2, 2, 2, 0 },     /* D  */
+            { 0, 4, 3, 2 },     /* Em */
+            { 0, 0, 0, 1 },     /* C7 */
+            { 2, 0, 2, 0 }      /* D7 */
+        };
+        return frets[chord];
+    }
+
+  private:
+    typedef struct {
+        float freq[PARTIALS];       /* Hz */
+        float tau[PARTIALS];        /* Decay time constant in s */
+        float weight[PARTIALS];     /* Amplitude relative to the fundamental */
+        float rot_c[PARTIALS];      /* Per sample rotation and decay */
+        float rot_s[PARTIALS];
+        float re[PARTIALS];
+        float im[PARTIALS];
+        float attack;               /* Envelope, 0 to 1 */
+        float attack_rate;
+        float amplitude;            /* Pluck strength, applied at pluck_at */
+        uint64_t pluck_at;
+        bool pending;
+    } String_t;
+
+    typedef struct {
+        float freq;
+        float q;
+        float gain;
+        float b0, a1, a2;           /* Band-pass, b1 = 0 and b2 = -b0 */
+        float x1, x2, y1, y2;
+    } BodyMode_t;
+
+    static float open_string_hz(uint8_t s)
+    {
+        static const float open[STRINGS] = { 392.00f, 261.63f, 329.63f, 440.00f };
+        return open[s];
+    }
+
+    uint32_t draw_interval(void)
+    {
+        float s = _interval_min + (_interval_max - _interval_min) * uniform();
+        uint32_t samples = (uint32_t)(s * _odr);
+
+        return samples ? samples : 1;
+    }
+
+    float uniform(void)
+    {
+        /* xorshift32, uniform in [0, 1) */
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 17;
+        _seed ^= _seed << 5;
+        return (float)(_seed >> 8) / (float)(1u << 24);
+    }
+
+    float gaussian(void)
+    {
+        float u, v, r;
+
+        /* Box-Muller, two values per draw */
+        if (_has_spare) {
+            _has_spare = false;
+            return _gaussian_spare;
+        }
+        u = uniform() + 1e-7f;
+        v = uniform();
+        r = sqrtf(-2.0f * logf(u));
+        _gaussian_spare = r * sinf(2.0f * (float)M_PI * v);
+        _has_spare = true;
+        return r * cosf(2.0f * (float)M_PI * v);
+    }
+
+    /**
+     * @brief  Pluck the strings of a random chord in turn.
+     */
+    void strum(void)
+    {
+        uint8_t chord = (uint8_t)(uniform() * CHORDS);
+        const int8_t *frets = chord_frets(_chord >= 0 ? (uint8_t)_chord : chord);
+        bool down = uniform() < 0.6f;
+        float velocity = _velocity_min + (_velocity_max - _velocity_min) * uniform();
+        float stroke_s = 0.004f + 0.012f * uniform();
+        String_t *string;
+
+        for (uint8_t i = 0; i < STRINGS; i++) {
+            uint8_t s = down ? i : (uint8_t)(STRINGS - 1 - i);
+            float freq = open_string_hz(s) * powf(2.0f, frets[s] / 12.0f);
+
+            string = &_strings[s];
+            for (uint8_t p = 0; p < PARTIALS; p++) {
+                /* Slightly stretched partials, as on nylon strings */
+                string->freq[p] = freq * (p + 1) * sqrtf(1.0f + 2e-4f * (p + 1) * (p + 1));
+                string->tau[p] = 0.9f / (1.0f + 0.6f * p);
+                string->weight[p] = 1.0f / ((p + 1) * (p + 1));
+            }
+            tune(string);
+            string->amplitude = velocity * (0.8f + 0.4f * uniform());
+            string->pluck_at = _index + (uint64_t)(i * stroke_s * _odr / (STRINGS - 1));
+            string->pending = true;
+        }
+
+        /* Hand hitting the body, felt as a short low frequency push */
+        _thump += 0.5f * velocity;
+        _strums++;
+    }
+
+    /* Per sample rotation of the partials of a string, for the current rate */
+    void tune(String_t *string)
+    {
+        for (uint8_t p = 0; p < PARTIALS; p++) {
+            float decay = (string->tau[p] > 0.0f) ? expf(-1.0f / (string->tau[p] * _odr)) : 0.0f;
+            float w = 2.0f * (float)M_PI * string->freq[p] / _odr;
+
+            /* Partials beyond the sensor bandwidth are filtered out */
+            if (string->freq[p] > 0.45f * _odr) {
+                decay = 0.0f;
+            }
+            string->rot_c[p] = decay * cosf(w);
+            string->rot_s[p] = decay * sinf(w);
+        }
+        string->attack_rate = 1.0f - expf(-1.0f / (0.001f * _odr));
+    }
+
+    float string_sample(String_t *string)
+    {
+        float sum = 0.0f, re;
+
+        if (string->pending && _index >= string->pluck_at) {
+            /* Phase restarts at zero, the previous vibration is damped */
+            for (uint8_t p = 0; p < PARTIALS; p++) {
+                string->re[p] = string->amplitude * string->weight[p];
+                string->im[p] = 0.0f;
+            }
+            string->attack = 0.0f;
+            string->pending = false;
+        }
+        for (uint8_t p = 0; p < PARTIALS; p++) {
+            re = string->re[p] * string->rot_c[p] - string->im[p] * string->rot_s[p];
+            string->im[p] = string->re[p] * string->rot_s[p] + string->im[p] * string->rot_c[p];
+            string->re[p] = re;
+            sum += string->im[p];
+        }
+        string->attack += (1.0f - string->attack) * string->attack_rate;
+
+        return sum * string->attack;
+    }
+
+    /* Air and top plate modes of a soprano ukulele body */
+    void tune_body(void)
+    {
+        static const float freq[BODY_MODES] = { 290.0f, 460.0f };
+        static const float q[BODY_MODES] = { 12.0f, 20.0f };
+        static const float gain[BODY_MODES] = { 0.6f, 0.4f };
+
+        for (uint8_t m = 0; m < BODY_MODES; m++) {
+            BodyMode_t *mode = &_body[m];
+            float w = 2.0f * (float)M_PI * freq[m] / _odr;
+            float alpha = sinf(w) / (2.0f * q[m]);
+
+            mode->freq = freq[m];
+            mode->q = q[m];
+            mode->gain = gain[m];
+            mode->b0 = alpha / (1.0f + alpha);
+            mode->a1 = -2.0f * cosf(w) / (1.0f + alpha);
+            mode->a2 = (1.0f - alpha) / (1.0f + alpha);
+        }
+        _thump_decay = expf(-1.0f / (0.08f * _odr));
+    }
+
+    static float resonate(BodyMode_t *mode, float x)
+    {
+        float y = mode->b0 * (x - mode->x2) - mode->a1 * mode->y1 - mode->a2 * mode->y2;
+
+        mode->x2 = mode->x1;
+        mode->x1 = x;
+        mode->y2 = mode->y1;
+        mode->y1 = y;
+        return mode->gain * y;
+    }
+
+    String_t _strings[STRINGS];
+    BodyMode_t _body[BODY_MODES];
+    uint32_t _seed;
+    uint64_t _index;
+    uint64_t _next_strum;
+    uint32_t _strums;
+    int8_t _chord;
+    float _odr;
+    float _lsb_per_g;
+    float _interval_min, _interval_max;
+    float _velocity_min, _velocity_max;
+    float _pitch, _roll;
+    float _noise_density, _noise_sigma;
+    float _thump, _thump_decay;
+    float _sway_phase;
+    float _gaussian_spare;
+    bool _has_spare;
+};
+
+#endif
@@ -0,0 +1,612 @@
+/**
+*******************************************************************************
+* @file   Acquisition.h
+* @brief  Triggered window capture from the accelerometer FIFO
+*******************************************************************************
+* drain() reads whatever the sensor FIFO holds, without waiting. Samples feed
+* the strum trigger until it fires, then fill the window. Once the window is
+* complete, drain() leaves the FIFO alone until rearm() is called. When the
+* sensor detects the strum itself, trigger() starts the window without the
+* strum trigger.
+*
+* Samples lost by the sensor FIFO while a window is captured are counted, see
+* window_lost_samples().
+*
+* With an OnsetAligner, see set_aligner(), the last samples before the
+* trigger are kept at the start of the window buffer, the capture goes on
+* margin() samples beyond the window, and window() points to the window
+* aligned on the attack peak, within the same buffer.
+*
+* In stream mode, see set_stream(), every sample goes to a StreamWindow
+* instead and drain() returns true at each hop. The strum trigger is not
+* used and the FIFO is never reset: the stream only restarts, empty, after
+* samples are lost.
+*
+* With a marker axis, see set_marker(), the LSB of that axis is the level of
+* the DEN input stamped by the sensor, see enable_den_stamping(). It is
+* cleared before the conversion and counted per window, see
+* window_marked(), so that a footswitch on DEN labels windows without any
+* interrupt or bus access of its own.
+*
+* With a SyncClock as well, see set_sync(), the stamp is a sync pulse shared
+* with other recorders instead: every sample read goes to the clock, which
+* is also given the sensor timestamp with each FIFO level, and each window
+* gets the time of its first sample against the sync edges, see
+* window_time().
+*
+* With a GoertzelBank, see set_bank(), one axis of the capture goes to the
+* bank sample by sample, and the amplitudes of the notes over the window
+* are ready when drain() returns true. The bank takes the aligned window to
+* the sample, without the resampling of its fraction. Not in stream mode.
+*
+* Samples are converted to g minus an offset, set by the temperature
+* compensation when it runs in software. Samples seen while waiting for a
+* strum are also summed for get_mean().
+*
+* Sensor is LSM6DSLSensor on target or LSM6DSLSensorT<LSM6DSLSimBus> on host,
+* any class with get_fifo_samples(), read_x_block(), reset_fifo(),
+* get_fifo_stats() and get_timestamp() fits.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __ACQUISITION_H__
+#define __ACQUISITION_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include "StrumTrigger.h"
+#include "StreamWindow.h"
+#include "OnsetAlign.h"
+#include "SyncClock.h"
+#include "GoertzelBank.h"
+#include "LSM6DSLFifo.h"
+
+/* Class Declaration ---------------------------------------------------------*/
+
+template <class Sensor>
+class Acquisition
+{
+public:
+	/* Samples read from the FIFO in one bus transfer */
+	static const uint16_t CHUNK = 64;
+
+	Acquisition(Sensor *sensor, StrumTrigger *trigger, float *window, uint16_t window_samples) :
+		_sensor(sensor), _trigger(trigger), _stream(NULL), _aligner(NULL), _sync(NULL), _bank(NULL), _window(window), _window_capacity(window_samples),
+		_window_samples(window_samples), _capture_samples(window_samples), _window_start(0), _history_pos(0), _history_count(0),
+		_scale(0.0f), _filled(0), _capturing(false), _complete(false), _samples(0), _discard(0), _lost_start(0), _window_lost(0),
+		_stream_restarts(0), _fifo_peak(0), _marker_axis(-1), _marked(0), _window_marked(0), _sync_lost(0),
+		_window_synced(false), _bank_axis(0), _mean_count(0)
+	{
+		for (uint8_t i = 0; i < 3; i++) {
+			_offset[i] = 0.0f;
+			_mean_sum[i] = 0;
+		}
+	}
+
+	/**
+	 * @brief  Decode the DEN stamp of the sensor
+	 *
+	 * @param  axis 0, 1 or 2 for the x, y or z LSB carrying the stamp, -1
+	 *         for none
+	 * @retval None
+	 */
+	void set_marker(int8_t axis)
+	{
+		_marker_axis = (axis >= 0 && axis < 3) ? axis : -1;
+	}
+
+	/* Marked samples of the last complete window, in stream mode of the last hop */
+	uint16_t window_marked() const
+	{
+		return _window_marked;
+	}
+
+	/**
+	 * @brief  Time the windows against the sync pulse stamped on the marker
+	 *         axis, see set_marker()
+	 *
+	 * @param  sync clock fed from now on, NULL for none
+	 * @retval None
+	 * @note   The sensor timestamp counter must run, see enable_timestamp().
+	 */
+	void set_sync(SyncClock *sync)
+	{
+		_sync = sync;
+		_window_synced = false;
+		if (_sync) {
+			_sync_lost = lost_samples();
+			_sync->restart();
+		}
+	}
+
+	/**
+	 * @brief  Time of the first sample of the last complete window
+	 *
+	 * @param  time output
+	 * @retval false if the window has no time: no sync clock, clock not
+	 *         locked yet or samples lost during the window
+	 */
+	bool window_time(SyncTime_t *time) const
+	{
+		if (!_window_synced) {
+			return false;
+		}
+		*time = _window_time;
+		return true;
+	}
+
+	/**
+	 * @brief  Measure the notes of each captured window
+	 *
+	 * @param  bank fed from the next window on, NULL for none
+	 * @param  axis 0, 1 or 2 for x, y or z
+	 * @retval None
+	 */
+	void set_bank(GoertzelBank *bank, uint8_t axis)
+	{
+		_bank = bank;
+		_bank_axis = (axis < 3) ? axis : 2;
+	}
+
+	/**
+	 * @brief  Set the conversion from raw values to g
+	 *
+	 * @param  sensitivity accelerometer sensitivity in mg/LSB
+	 * @retval None
+	 */
+	void set_sensitivity(float sensitivity)
+	{
+		_scale = sensitivity / 1000;
+	}
+
+	/**
+	 * @brief  Change the window length, within the buffer given at construction
+	 *
+	 * @param  window_samples samples per window
+	 * @retval false if the buffer is too small, the length is unchanged
+	 * @note   Call between windows, see rearm().
+	 */
+	bool set_window_samples(uint16_t window_samples)
+	{
+		uint16_t margin = _aligner ? _aligner->margin() : 0;
+
+		if (window_samples == 0 || window_samples + margin > _window_capacity) {
+			return false;
+		}
+		_window_samples = window_samples;
+		_capture_samples = (uint16_t)(window_samples + margin);
+
+		return true;
+	}
+
+	uint16_t window_samples() const
+	{
+		return _window_samples;
+	}
+
+	/**
+	 * @brief  Align the windows on the attack peak of the strums
+	 *
+	 * @param  aligner alignment used from the next window, NULL for none
+	 * @retval false if the buffer cannot hold the window and the margin of
+	 *         the aligner, nothing is changed
+	 * @note   Call between windows, see rearm().
+	 */
+	bool set_aligner(OnsetAligner *aligner)
+	{
+		OnsetAligner *previous = _aligner;
+
+		_aligner = aligner;
+		if (!set_window_samples(_window_samples)) {
+			_aligner = previous;
+			return false;
+		}
+		_history_pos = 0;
+		_history_count = 0;
+
+		return true;
+	}
+
+	/* The last complete window, aligned if an aligner is set */
+	const float *window() const
+	{
+		return &_window[3 * _window_start];
+	}
+
+	/**
+	 * @brief  Feed a sliding window with every sample instead of capturing
+	 *         triggered windows
+	 *
+	 * @param  stream window filled from now on, NULL to go back to triggers
+	 * @retval None
+	 * @note   drain() stops at each hop, the window being valid until the
+	 *         next drain().
+	 */
+	void set_stream(StreamWindow *stream)
+	{
+		_stream = stream;
+		_lost_start = lost_samples();
+		if (_stream) {
+			_stream->reset();
+		}
+	}
+
+	/**
+	 * @brief  Set the offset removed from every sample
+	 *
+	 * @param  offset offset on x, y and z in g
+	 * @retval None
+	 */
+	void set_offset(const float *offset)
+	{
+		for (uint8_t i = 0; i < 3; i++) {
+			_offset[i] = offset[i];
+		}
+	}
+
+	/**
+	 * @brief  Mean of the samples seen outside windows since the last call,
+	 *         before the offset is removed
+	 *
+	 * @param  xyz mean acceleration on x, y and z in g
+	 * @retval false if no sample was seen
+	 * @note   Sums are kept on 32 bits, call at least every 10 s at 3330 Hz.
+	 */
+	bool get_mean(float *xyz)
+	{
+		uint32_t count = _mean_count;
+
+		for (uint8_t i = 0; i < 3; i++) {
+			xyz[i] = count ? _mean_sum[i] * _scale / count : 0.0f;
+			_mean_sum[i] = 0;
+		}
+		_mean_count = 0;
+
+		return count != 0;
+	}
+
+	/**
+	 * @brief  Read the samples available in the sensor FIFO
+	 *
+	 * @param  None
+	 * @retval true when the window is complete
+	 */
+	bool drain()
+	{
+		size_t available = 0, got, i;
+		uint32_t timestamp = 0, newest = 0, lost;
+		bool observed = false;
+		float xyz[3];
+
+		while (!_complete) {
+			if (_sensor->get_fifo_samples(&available) != 0 || available == 0) {
+				break;
+			}
+			if (available > _fifo_peak) {
+				_fifo_peak = available;
+			}
+			/* The newest sample held was produced within the period before the counter read */
+			if (_sync) {
+				newest = _sync->index() + (uint32_t)available - 1;
+				observed = (_sensor->get_timestamp(&timestamp) == 0);
+			}
+			if (available > CHUNK) {
+				available = CHUNK;
+			}
+			/* A hop ends a read so that the next one starts the next hop */
+			if (_stream && available > _stream->until_hop()) {
+				available = _stream->until_hop();
+			}
+			if (_sensor->read_x_block(_raw, available, &got) != 0) {
+				break;
+			}
+			_samples += got;
+			if (_stream) {
+				restart_stream_on_loss();
+			}
+			if (_sync) {
+				/* Samples were lost before those just read */
+				lost = lost_samples();
+				if (lost != _sync_lost) {
+					_sync_lost = lost;
+					_sync->restart();
+				}
+				if (observed) {
+					_sync->observe(timestamp, newest);
+				}
+				for (i = 0; i < got; i++) {
+					_sync->push(_marker_axis >= 0 && (_raw[3 * i + _marker_axis] & 1) != 0);
+				}
+			}
+
+			for (i = 0; i < got && !_complete; i++) {
+				if (_marker_axis >= 0) {
+					int16_t *stamped = &_raw[3 * i + _marker_axis];
+
+					/* Samples before the window, or discarded, do not count */
+					if ((_capturing || _stream) && !_discard) {
+						_marked += (uint16_t)(*stamped & 1);
+					}
+					*stamped = (int16_t)(*stamped & ~1);
+				}
+				xyz[0] = _raw[3 * i] * _scale - _offset[0];
+				xyz[1] = _raw[3 * i + 1] * _scale - _offset[1];
+				xyz[2] = _raw[3 * i + 2] * _scale - _offset[2];
+
+				if (_discard) {
+					/* Words overwritten while the FIFO was held full were the
+					   oldest of the history: count losses from the window on */
+					if (--_discard == 0) {
+						_lost_start = lost_samples();
+					}
+				} else if (_stream) {
+					_complete = _stream->push(xyz);
+					if (_complete) {
+						_window_marked = _marked;
+						_marked = 0;
+						window_synced(got - i, _stream->samples());
+					}
+				} else if (_capturing) {
+					_window[3 * _filled] = xyz[0];
+					_window[3 * _filled + 1] = xyz[1];
+					_window[3 * _filled + 2] = xyz[2];
+					if (_bank) {
+						_bank->push(xyz[_bank_axis]);
+					}
+					if (++_filled == _capture_samples) {
+						_capturing = false;
+						_complete = true;
+						_window_lost = lost_samples() - _lost_start;
+						_window_marked = _marked;
+						if (_aligner) {
+							_window_start = _aligner->align(_window, _window_samples);
+						}
+						/* The margin around the window is left untouched by the alignment */
+						if (_bank) {
+							_bank->window(&_window[_bank_axis], 3, _window_start, _window_samples);
+						}
+						window_synced(got - i, _capture_samples - _window_start);
+					}
+				} else {
+					_mean_sum[0] += _raw[3 * i];
+					_mean_sum[1] += _raw[3 * i + 1];
+					_mean_sum[2] += _raw[3 * i + 2];
+					_mean_count++;
+					if (_aligner) {
+						keep_history(xyz);
+					}
+					if (_trigger->push(xyz)) {
+						start_window();
+					}
+				}
+			}
+		}
+
+		return _complete;
+	}
+
+	/**
+	 * @brief  Start the window on a strum detected by the sensor
+	 *
+	 * @param  discard number of samples to skip first, the oldest of the
+	 *         history held by the FIFO
+	 * @retval None
+	 * @note   The FIFO was full when released, its overrun and the words it
+	 *         overwrote are not counted against the window as long as they
+	 *         fall within the samples discarded.
+	 */
+	void trigger(uint16_t discard)
+	{
+		start_window();
+		_discard = discard;
+	}
+
+	/**
+	 * @brief  Release the window and wait for the next strum on fresh data
+	 *
+	 * @param  None
+	 * @retval None
+	 */
+	void rearm()
+	{
+		/* The stream goes on with the samples the FIFO holds */
+		if (_stream) {
+			_complete = false;
+			return;
+		}
+		_sensor->reset_fifo();
+		if (_sync) {
+			_sync->restart();
+		}
+		_trigger->reset();
+		_capturing = false;
+		_complete = false;
+		_filled = 0;
+		_discard = 0;
+		_window_start = 0;
+		_history_pos = 0;
+		_history_count = 0;
+	}
+
+	bool capturing() const
+	{
+		return _capturing;
+	}
+
+	/* Samples read from the sensor since start */
+	uint32_t samples() const
+	{
+		return _samples;
+	}
+
+	/* Times the stream started over after lost samples */
+	uint32_t stream_restarts() const
+	{
+		return _stream_restarts;
+	}
+
+	/* Highest FIFO level met by drain() since the last call, in samples */
+	uint32_t take_fifo_peak()
+	{
+		uint32_t peak = _fifo_peak;
+
+		_fifo_peak = 0;
+		return peak;
+	}
+
+	/* Samples missing from the last complete window, as estimated by the sensor */
+	uint32_t window_lost_samples() const
+	{
+		return _window_lost;
+	}
+
+private:
+	/**
+	 * @brief  Time the window that just completed
+	 *
+	 * @param  unread samples of the read from the one that completed it
+	 * @param  back samples from the first of the window to the one that
+	 *         completed it, included
+	 * @retval None
+	 * @note   The window must not span a gap, see window_lost_samples().
+	 */
+	void window_synced(size_t unread, uint32_t back)
+	{
+		float resampled = 0.0f;
+
+		_window_synced = false;
+		if (!_sync || _window_lost) {
+			return;
+		}
+		_window_synced = _sync->time(_sync->index() - (uint32_t)unread + 1 - back, &_window_time);
+		/* The aligner interpolates the window between two samples */
+		if (_window_synced && _aligner && !_stream) {
+			resampled = _aligner->attack() - _aligner->pre() - _window_start;
+			if (resampled > 0.0f && resampled < 1.0f) {
+				_window_time.offset_us += resampled * _window_time.sample_us;
+			}
+		}
+	}
+
+	void start_window()
+	{
+		_capturing = true;
+		_marked = 0;
+		_filled = _history_count ? unroll_history() : 0;
+		_lost_start = lost_samples();
+		if (_bank) {
+			_bank->reset();
+			for (uint16_t n = 0; n < _filled; n++) {
+				_bank->push(_window[3 * n + _bank_axis]);
+			}
+		}
+	}
+
+	/* The first history() samples of the buffer are a ring while waiting */
+	void keep_history(const float *xyz)
+	{
+		_window[3 * _history_pos] = xyz[0];
+		_window[3 * _history_pos + 1] = xyz[1];
+		_window[3 * _history_pos + 2] = xyz[2];
+		if (++_history_pos == _aligner->history()) {
+			_history_pos = 0;
+		}
+		if (_history_count < _aligner->history()) {
+			_history_count++;
+		}
+	}
+
+	/* Oldest first, by three reversals of the ring */
+	uint16_t unroll_history()
+	{
+		uint16_t count = _history_count;
+
+		/* Not full yet: samples are in order from the start of the ring */
+		if (count == _aligner->history() && _history_pos != 0) {
+			reverse(0, _history_pos);
+			reverse(_history_pos, count);
+			reverse(0, count);
+		}
+		_history_pos = 0;
+		_history_count = 0;
+
+		return count;
+	}
+
+	void reverse(uint16_t first, uint16_t end)
+	{
+		float tmp;
+
+		while (end > first + 1) {
+			end--;
+			for (uint8_t i = 0; i < 3; i++) {
+				tmp = _window[3 * first + i];
+				_window[3 * first + i] = _window[3 * end + i];
+				_window[3 * end + i] = tmp;
+			}
+			first++;
+		}
+	}
+
+	/* A window must not span a gap: the samples just read start a new one */
+	void restart_stream_on_loss()
+	{
+		uint32_t lost = lost_samples();
+
+		if (lost != _lost_start) {
+			_lost_start = lost;
+			_stream->reset();
+			_stream_restarts++;
+		}
+	}
+
+	uint32_t lost_samples()
+	{
+		LSM6DSL_Fifo_Stats_t stats;
+
+		if (_sensor->get_fifo_stats(&stats) != 0) {
+			return 0;
+		}
+		return stats.lost_samples;
+	}
+
+	Sensor *_sensor;
+	StrumTrigger *_trigger;
+	StreamWindow *_stream;
+	OnsetAligner *_aligner;
+	SyncClock *_sync;
+	GoertzelBank *_bank;
+	float *_window;
+	uint16_t _window_capacity;
+	uint16_t _window_samples;
+	uint16_t _capture_samples;
+	uint16_t _window_start;
+	uint16_t _history_pos;
+	uint16_t _history_count;
+	float _scale;
+	uint16_t _filled;
+	bool _capturing;
+	bool _complete;
+	uint32_t _samples;
+	uint16_t _discard;
+	uint32_t _lost_start;
+	uint32_t _window_lost;
+	uint32_t _stream_restarts;
+	uint32_t _fifo_peak;
+	int8_t _marker_axis;
+	uint16_t _marked;
+	uint16_t _window_marked;
+	uint32_t _sync_lost;
+	bool _window_synced;
+	SyncTime_t _window_time;
+	uint8_t _bank_axis;
+	float _offset[3];
+	int32_t _mean_sum[3];
+	uint32_t _mean_count;
+	int16_t _raw[3 * CHUNK];
+};
+
+#endif
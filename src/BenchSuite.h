@@ -0,0 +1,420 @@
+/**
+*******************************************************************************
+* @file   BenchSuite.h
+* @brief  Driver, DSP and inference microbenchmarks, on target and on host
+*******************************************************************************
+* A fixed list of measurements, run the same way by the BENCHMARK firmware
+* and by tools/host_bench against the simulator:
+*
+*  x_axes          get_x_axes(), output registers read and converted to mg
+*  x_axes_raw      get_x_axes_raw(), a 6-byte burst
+*  fifo_drain      read_x_block() of FIFO_SAMPLES samples, 510 FIFO words
+*  trigger_window  StrumTrigger::push() over a window
+*  align_window    OnsetAligner::align() of a capture
+*  stream_sample   StreamWindow::push() of a sample
+*  goertzel_window GoertzelBank over a window, pushed sample by sample
+*  goertzel_close  GoertzelBank::window() once a capture is pushed, the
+*                  alignment margin removed: the wait for the notes
+*  fft_window      the same notes from a radix-2 real FFT of the same window
+*  detect          NanoEdgeAI_detect() of a window, when linked
+*  print_line      the similarity line printed per window
+*
+* The signals are strums produced by StrumSynth. Each measurement is taken
+* RUNS times, after a first untimed one, and reported as one line of
+* KEY=VALUE fields with the minimum, median and maximum in ticks of the
+* platform counter per operation:
+*
+*   BENCH begin suite=1 platform=target clock_hz=80000000
+*   BENCH name=x_axes_raw per=32 runs=15 min=... median=... max=...
+*   BENCH name=detect skipped
+*   BENCH end
+*
+* On host, bus transfers are simulated and cost no time: the numbers are the
+* CPU cost of the code paths only, see tools/bench_compare.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __BENCH_SUITE_H__
+#define __BENCH_SUITE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "StrumTrigger.h"
+#include "OnsetAlign.h"
+#include "StreamWindow.h"
+#include "GoertzelBank.h"
+#include "StrumSynth.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define BENCH_SUITE_VERSION		2		/* Changes with the list of measurements */
+#define BENCH_ODR_HZ			3330.0f	/* Output data rate of StrumSynth */
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef struct {
+	const char *name;					/* Reported as platform= */
+	uint32_t (*ticks)(void);			/* Free running counter, wrapping */
+	uint32_t clock_hz;					/* Its frequency */
+	void (*wait_ms)(uint32_t ms);		/* The sensor keeps producing samples meanwhile */
+	void (*print)(const char *line);	/* One line of the report, no newline */
+	void (*print_similarity)(uint8_t similarity);	/* As printed per window */
+	void (*learn)(float *window);		/* NanoEdgeAI_learn(), NULL if not linked */
+	uint8_t (*detect)(float *window);	/* NanoEdgeAI_detect(), NULL if not linked */
+} BenchPlatform_t;
+
+/* Class Declaration ---------------------------------------------------------*/
+
+template <class Sensor>
+class BenchSuite
+{
+public:
+	static const uint16_t RUNS = 15;
+	static const uint16_t FIFO_SAMPLES = 170;
+	static const uint16_t LEARNING = 5;
+	static const uint16_t STREAM_WINDOW = 128;
+	static const uint16_t STREAM_HOP = 32;
+	static const uint16_t PRE = 24;
+	static const uint16_t SEARCH = 64;
+	static const uint8_t FRETS = 12;
+	static const uint8_t AXIS = 2;
+	static const uint32_t SEED = 1;
+
+	/* Samples of the work buffer: a capture to align */
+	static uint32_t work_samples(uint16_t window)
+	{
+		return window + SEARCH + 1;
+	}
+
+	/**
+	 * @param  sensor configured and enabled, FIFO disabled
+	 * @param  platform counters and output
+	 * @param  work 3 * work_samples(window) floats, overwritten
+	 * @param  window samples per window, as given to NanoEdge AI
+	 */
+	BenchSuite(Sensor *sensor, const BenchPlatform_t *platform, float *work, uint16_t window) :
+		_sensor(sensor), _platform(platform), _work(work), _window(window),
+		_trigger(5, 1.4f, 0.15f), _aligner(PRE, SEARCH), _stream(_stream_buffer, STREAM_WINDOW, STREAM_HOP),
+		_bank(BENCH_ODR_HZ, FRETS)
+	{
+		/* Largest power of two in the window */
+		for (_fft_size = 2; 2 * _fft_size <= window; _fft_size *= 2) {
+		}
+	}
+
+	/**
+	 * @brief  Run every measurement and print the report
+	 *
+	 * @param  None
+	 * @retval None
+	 */
+	void run()
+	{
+		char line[96];
+
+		snprintf(line, sizeof(line), "BENCH begin suite=%d platform=%s clock_hz=%lu", BENCH_SUITE_VERSION,
+		         _platform->name, (unsigned long)_platform->clock_hz);
+		_platform->print(line);
+
+		measure("x_axes", 32, &BenchSuite::x_axes, NULL);
+		measure("x_axes_raw", 32, &BenchSuite::x_axes_raw, NULL);
+		measure("fifo_drain", 1, &BenchSuite::fifo_drain, &BenchSuite::fifo_fill);
+		_sensor->disable_fifo();
+		measure("trigger_window", 1, &BenchSuite::trigger_window, &BenchSuite::capture);
+		measure("align_window", 1, &BenchSuite::align_window, &BenchSuite::capture);
+		measure("stream_sample", STREAM_HOP, &BenchSuite::stream_hop, &BenchSuite::capture);
+		measure("goertzel_window", 1, &BenchSuite::goertzel_window, &BenchSuite::capture);
+		measure("goertzel_close", 1, &BenchSuite::goertzel_close, &BenchSuite::bank_capture);
+		measure("fft_window", 1, &BenchSuite::fft_window, &BenchSuite::capture);
+		if (_platform->detect && _platform->learn) {
+			learn();
+			measure("detect", 1, &BenchSuite::detect, &BenchSuite::capture);
+		} else {
+			_platform->print("BENCH name=detect skipped");
+		}
+		measure("print_line", 1, &BenchSuite::print_line, NULL);
+
+		_platform->print("BENCH end");
+	}
+
+	/**
+	 * @brief  Print the line of one measurement
+	 *
+	 * @param  print output of the platform
+	 * @param  name of the measurement
+	 * @param  per operations per run
+	 * @param  ticks RUNS durations of a run, sorted in place
+	 * @retval None
+	 * @note   Also used by the firmware for target-only measurements.
+	 */
+	static void report(void (*print)(const char *line), const char *name, uint32_t per, uint32_t *ticks, uint16_t runs)
+	{
+		char line[96];
+		uint32_t tmp;
+
+		/* Insertion sort, a few values */
+		for (uint16_t i = 1; i < runs; i++) {
+			for (uint16_t j = i; j > 0 && ticks[j - 1] > ticks[j]; j--) {
+				tmp = ticks[j];
+				ticks[j] = ticks[j - 1];
+				ticks[j - 1] = tmp;
+			}
+		}
+		snprintf(line, sizeof(line), "BENCH name=%s per=%lu runs=%u min=%lu median=%lu max=%lu", name,
+		         (unsigned long)per, (unsigned)runs, (unsigned long)(ticks[0] / per),
+		         (unsigned long)(ticks[runs / 2] / per), (unsigned long)(ticks[runs - 1] / per));
+		print(line);
+	}
+
+private:
+	typedef void (BenchSuite::*Step)(void);
+
+	void measure(const char *name, uint32_t per, Step body, Step setup)
+	{
+		uint32_t ticks[RUNS], start;
+
+		/* The first run warms caches and loads the code, not timed */
+		for (int16_t run = -1; run < (int16_t)RUNS; run++) {
+			if (setup) {
+				(this->*setup)();
+			}
+			start = _platform->ticks();
+			(this->*body)();
+			if (run >= 0) {
+				ticks[run] = _platform->ticks() - start;
+			}
+		}
+		report(_platform->print, name, per, ticks, RUNS);
+	}
+
+	/* A strum from its onset, restarted each time for the same samples */
+	void capture()
+	{
+		_synth.reset(SEED);
+		_synth.set_chord(0);
+		while (!_synth.next(&_work[0])) {
+		}
+		for (uint32_t n = 1; n < work_samples(_window); n++) {
+			_synth.next(&_work[3 * n]);
+		}
+	}
+
+	void x_axes()
+	{
+		int32_t axes[3];
+
+		for (uint8_t i = 0; i < 32; i++) {
+			_sensor->get_x_axes(axes);
+		}
+	}
+
+	void x_axes_raw()
+	{
+		int16_t raw[3];
+
+		for (uint8_t i = 0; i < 32; i++) {
+			_sensor->get_x_axes_raw(raw);
+		}
+	}
+
+	void fifo_fill()
+	{
+		_sensor->enable_x_fifo();
+		_sensor->reset_fifo();
+		/* FIFO_SAMPLES and a margin at 3330 Hz */
+		_platform->wait_ms(60);
+	}
+
+	void fifo_drain()
+	{
+		size_t got;
+
+		/* The work buffer is free, no window is being captured */
+		_sensor->read_x_block((int16_t *)_work, FIFO_SAMPLES, &got);
+	}
+
+	void trigger_window()
+	{
+		_trigger.reset();
+		for (uint16_t n = 0; n < _window; n++) {
+			_trigger.push(&_work[3 * n]);
+		}
+	}
+
+	void align_window()
+	{
+		_aligner.align(_work, _window);
+	}
+
+	void stream_hop()
+	{
+		for (uint16_t n = 0; n < STREAM_HOP; n++) {
+			_stream.push(&_work[3 * n]);
+		}
+	}
+
+	void goertzel_window()
+	{
+		_bank.reset();
+		for (uint16_t n = 0; n < _window; n++) {
+			_bank.push(_work[3 * n + AXIS]);
+		}
+		_bank.window(&_work[AXIS], 3, 0, _window);
+	}
+
+	void bank_capture()
+	{
+		capture();
+		_bank.reset();
+		for (uint32_t n = 0; n < work_samples(_window); n++) {
+			_bank.push(_work[3 * n + AXIS]);
+		}
+	}
+
+	/* Window in the middle of the capture, as aligned */
+	void goertzel_close()
+	{
+		_bank.window(&_work[AXIS], 3, SEARCH / 2, _window);
+	}
+
+	/* Amplitudes of the bins nearest to the notes, as the bank gives them */
+	void fft_window()
+	{
+		float *data = _work;
+		uint16_t bin;
+
+		/* One axis, in place: each sample moves to a lower index */
+		for (uint16_t n = 0; n < _fft_size; n++) {
+			data[n] = _work[3 * n + AXIS];
+		}
+		real_fft(data, _fft_size);
+		for (uint8_t k = 0; k < _bank.notes(); k++) {
+			bin = (uint16_t)(440.0f * powf(2.0f, (_bank.note(k) - 69) / 12.0f) * _fft_size / BENCH_ODR_HZ + 0.5f);
+			_fft_amplitude[k] = 2.0f * sqrtf(data[2 * bin] * data[2 * bin] + data[2 * bin + 1] * data[2 * bin + 1]) / _fft_size;
+		}
+	}
+
+	/* Radix-2 FFT of n complex values, re and im interleaved, in place */
+	static void complex_fft(float *data, uint16_t n)
+	{
+		uint16_t i, j, m, step;
+		float wr, wi, wpr, wpi, tmp, tr, ti;
+
+		/* Bit reversed order */
+		for (i = 0, j = 0; i < n; i++) {
+			if (j > i) {
+				tmp = data[2 * j];
+				data[2 * j] = data[2 * i];
+				data[2 * i] = tmp;
+				tmp = data[2 * j + 1];
+				data[2 * j + 1] = data[2 * i + 1];
+				data[2 * i + 1] = tmp;
+			}
+			for (m = n >> 1; m >= 1 && j >= m; m >>= 1) {
+				j -= m;
+			}
+			j += m;
+		}
+		/* Butterflies, the twiddles by recurrence rather than from a table */
+		for (m = 1; m < n; m = step) {
+			step = (uint16_t)(2 * m);
+			tmp = sinf(-0.5f * (float)M_PI / m);
+			wpr = -2.0f * tmp * tmp;
+			wpi = sinf(-(float)M_PI / m);
+			wr = 1.0f;
+			wi = 0.0f;
+			for (uint16_t k = 0; k < m; k++) {
+				for (i = k; i < n; i += step) {
+					j = (uint16_t)(i + m);
+					tr = wr * data[2 * j] - wi * data[2 * j + 1];
+					ti = wr * data[2 * j + 1] + wi * data[2 * j];
+					data[2 * j] = data[2 * i] - tr;
+					data[2 * j + 1] = data[2 * i + 1] - ti;
+					data[2 * i] += tr;
+					data[2 * i + 1] += ti;
+				}
+				tmp = wr;
+				wr += wr * wpr - wi * wpi;
+				wi += wi * wpr + tmp * wpi;
+			}
+		}
+	}
+
+	/**
+	 * FFT of n real values in place, as a complex FFT of n / 2 values:
+	 * bin k of 1 to n / 2 - 1 as re, im in data[2k], data[2k + 1], the
+	 * DC and n / 2 bins, both real, in data[0] and data[1]
+	 */
+	static void real_fft(float *data, uint16_t n)
+	{
+		uint16_t half = (uint16_t)(n / 2), k, l;
+		float wr = 1.0f, wi = 0.0f, wpr, wpi, tmp, er, ei, or_, oi, dc;
+
+		complex_fft(data, half);
+		tmp = sinf(-0.5f * (float)M_PI / half);
+		wpr = -2.0f * tmp * tmp;
+		wpi = sinf(-(float)M_PI / half);
+		for (k = 1; k <= half / 2; k++) {
+			tmp = wr;
+			wr += wr * wpr - wi * wpi;
+			wi += wi * wpr + tmp * wpi;
+			l = (uint16_t)(half - k);
+			/* Even and odd samples of bin k, from bins k and n / 2 - k */
+			er = 0.5f * (data[2 * k] + data[2 * l]);
+			ei = 0.5f * (data[2 * k + 1] - data[2 * l + 1]);
+			or_ = 0.5f * (data[2 * k + 1] + data[2 * l + 1]);
+			oi = -0.5f * (data[2 * k] - data[2 * l]);
+			/* X[k] = E + W^k O, X[n / 2 - k] = conj(E - W^k O) */
+			data[2 * k] = er + wr * or_ - wi * oi;
+			data[2 * k + 1] = ei + wr * oi + wi * or_;
+			data[2 * l] = er - wr * or_ + wi * oi;
+			data[2 * l + 1] = -(ei - wr * oi - wi * or_);
+		}
+		dc = data[0];
+		data[0] = dc + data[1];
+		data[1] = dc - data[1];
+	}
+
+	void learn()
+	{
+		_synth.reset(SEED + 1);
+		for (uint16_t i = 0; i < LEARNING; i++) {
+			while (!_synth.next(&_work[0])) {
+			}
+			for (uint16_t n = 1; n < _window; n++) {
+				_synth.next(&_work[3 * n]);
+			}
+			_platform->learn(_work);
+		}
+	}
+
+	void detect()
+	{
+		_platform->detect(_work);
+	}
+
+	void print_line()
+	{
+		_platform->print_similarity(87);
+	}
+
+	Sensor *_sensor;
+	const BenchPlatform_t *_platform;
+	float *_work;
+	uint16_t _window;
+	StrumSynth _synth;
+	StrumTrigger _trigger;
+	OnsetAligner _aligner;
+	float _stream_buffer[3 * STREAM_BUFFER_SAMPLES(STREAM_WINDOW, STREAM_HOP)];
+	StreamWindow _stream;
+	GoertzelBank _bank;
+	uint16_t _fft_size;
+	float _fft_amplitude[GOERTZEL_NOTES_MAX];
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+*******************************************************************************
+* @file   EventLoop.cpp
+* @brief  Event queue dispatch with duty-cycle accounting
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "EventLoop.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+EventLoop::EventLoop(EventQueue *queue) : _queue(queue), _total_events(0), _total_busy_us(0)
+{
+	_boot_us = us_ticker_read();
+	reset_stats();
+}
+
+/**
+ * @brief  Run a handler from the loop, safe to call from interrupt context
+ *
+ * @param  handler the function to run
+ * @retval the event id, 0 if the queue is full
+ */
+int EventLoop::post(Callback<void()> handler)
+{
+	return _queue->call(this, &EventLoop::measured, handler);
+}
+
+/**
+ * @brief  Run a handler from the loop periodically
+ *
+ * @param  ms the period in milliseconds
+ * @param  handler the function to run
+ * @retval the event id, 0 if the queue is full
+ */
+int EventLoop::post_every(int ms, Callback<void()> handler)
+{
+	return _queue->call_every(ms, this, &EventLoop::measured, handler);
+}
+
+/**
+ * @brief  Stop a handler posted, periodic or not yet run
+ *
+ * @param  id the event id returned by post() or post_every(), 0 for none
+ * @retval None
+ */
+void EventLoop::cancel(int id)
+{
+	if (id) {
+		_queue->cancel(id);
+	}
+}
+
+/**
+ * @brief  Dispatch events forever, sleeping while the queue is empty
+ *
+ * @param  None
+ * @retval None
+ */
+void EventLoop::run()
+{
+	_queue->dispatch_forever();
+}
+
+void EventLoop::get_stats(EventLoopStats *stats) const
+{
+	stats->events = _events;
+	stats->busy_us = _busy_us;
+	stats->elapsed_us = us_ticker_read() - _start_us;
+}
+
+/* Same as get_stats() since the loop was created, never reset */
+void EventLoop::get_totals(EventLoopStats *stats) const
+{
+	stats->events = _total_events;
+	stats->busy_us = _total_busy_us;
+	stats->elapsed_us = us_ticker_read() - _boot_us;
+}
+
+void EventLoop::reset_stats()
+{
+	_events = 0;
+	_busy_us = 0;
+	_start_us = us_ticker_read();
+}
+
+void EventLoop::measured(Callback<void()> handler)
+{
+	uint32_t start = us_ticker_read(), busy;
+
+	handler();
+	busy = us_ticker_read() - start;
+	_busy_us += busy;
+	_total_busy_us += busy;
+	_events++;
+	_total_events++;
+}
@@ -0,0 +1,63 @@
+/**
+*******************************************************************************
+* @file   EventLoop.h
+* @brief  Event queue dispatch with duty-cycle accounting
+*******************************************************************************
+* Interrupts, timers and UART input post handlers to an EventQueue, which
+* runs them one at a time in thread context. When the queue is empty the
+* core sleeps until the next interrupt or timer. The time spent in handlers
+* is accumulated to report the share of time the core is busy, since the
+* last reset_stats() and since start for telemetry.
+*
+* On host builds, tools/host_runtime provides EventQueue, Callback and
+* us_ticker_read() on top of the simulated time base.
+*******************************************************************************
+*/
+
+#ifndef __EVENT_LOOP_H__
+#define __EVENT_LOOP_H__
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef __MBED__
+#include "mbed.h"
+#else
+#include "HostEventQueue.h"
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef struct {
+	uint32_t events;		/* Handlers run */
+	uint32_t busy_us;		/* Time spent in handlers */
+	uint32_t elapsed_us;	/* Time since the statistics were reset */
+} EventLoopStats;
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class EventLoop
+{
+public:
+	EventLoop(EventQueue *queue);
+
+	int post(Callback<void()> handler);
+	int post_every(int ms, Callback<void()> handler);
+	void cancel(int id);
+	void run(void);
+
+	void get_stats(EventLoopStats *stats) const;
+	void get_totals(EventLoopStats *stats) const;
+	void reset_stats(void);
+
+private:
+	void measured(Callback<void()> handler);
+
+	EventQueue *_queue;
+	volatile uint32_t _events;
+	volatile uint32_t _busy_us;
+	uint32_t _start_us;
+	uint32_t _total_events;
+	uint32_t _total_busy_us;
+	uint32_t _boot_us;
+};
+
+#endif
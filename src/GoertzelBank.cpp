@@ -0,0 +1,207 @@
+/**
+*******************************************************************************
+* @file   GoertzelBank.cpp
+* @brief  Amplitude of each note of the fretboard over a window
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include "GoertzelBank.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+/**
+ * @param  odr_hz output data rate of the samples
+ * @param  frets counted on each string, notes up to GOERTZEL_NOTES_MAX
+ */
+GoertzelBank::GoertzelBank(float odr_hz, uint8_t frets) :
+	_notes(GOERTZEL_NOTES(frets) < GOERTZEL_NOTES_MAX ? GOERTZEL_NOTES(frets) : GOERTZEL_NOTES_MAX), _measured(0), _count(0)
+{
+	set_odr(odr_hz);
+}
+
+/**
+ * @brief  Tune the resonators for an output data rate, which starts over
+ *
+ * @param  odr_hz output data rate of the samples
+ * @retval None
+ */
+void GoertzelBank::set_odr(float odr_hz)
+{
+	float hz, w;
+
+	_measured = 0;
+	for (uint8_t k = 0; k < _notes; k++) {
+		/* Equal temperament, A4 = 440 Hz */
+		hz = 440.0f * powf(2.0f, (note(k) - 69) / 12.0f);
+		_amplitude[k] = 0.0f;
+		/* Ascending, the notes measured come first */
+		if (hz >= 0.5f * odr_hz) {
+			continue;
+		}
+		_measured++;
+		_coeff[k] = 2.0f * cosf(2.0f * (float)M_PI * hz / odr_hz);
+		/* The frequency the rounded coefficient resonates at */
+		w = acosf(0.5f * _coeff[k]);
+		_sin[k] = sinf(w);
+		_cycles[k] = w / (2.0f * (float)M_PI);
+	}
+	reset();
+}
+
+/**
+ * @brief  Start a new capture
+ *
+ * @param  None
+ * @retval None
+ */
+void GoertzelBank::reset()
+{
+	for (uint8_t k = 0; k < _measured; k++) {
+		_s1[k] = 0.0f;
+		_s2[k] = 0.0f;
+	}
+	_count = 0;
+}
+
+/**
+ * @brief  End the capture and measure the notes over a window within it
+ *
+ * @param  samples the capture as pushed, sample n at samples[n * stride],
+ *         read outside of the window only
+ * @param  stride floats from a sample to the next, e.g. 3 for one axis of
+ *         interleaved x, y, z
+ * @param  start first sample of the window in the capture
+ * @param  length samples of the window
+ * @retval None
+ * @note   Costs the samples outside of the window, e.g. the alignment
+ *         margin, not the window. Call reset() before pushing again.
+ */
+void GoertzelBank::window(const float *samples, uint8_t stride, uint16_t start, uint16_t length)
+{
+	uint32_t end = (uint32_t)start + length;
+
+	if (end > _count || length == 0) {
+		end = _count;
+		start = 0;
+		length = (uint16_t)_count;
+	}
+	/* Sum of x[n] e^(jw (count - 1 - n)) over the samples pushed */
+	for (uint8_t k = 0; k < _measured; k++) {
+		_re[k] = _s1[k] - 0.5f * _coeff[k] * _s2[k];
+		_im[k] = _sin[k] * _s2[k];
+	}
+	remove(samples, stride, 0, start);
+	remove(samples, stride, (uint16_t)end, (uint16_t)_count);
+
+	for (uint8_t k = 0; k < _measured; k++) {
+		_amplitude[k] = length ? 2.0f * sqrtf(_re[k] * _re[k] + _im[k] * _im[k]) / length : 0.0f;
+	}
+}
+
+/**
+ * @brief  Amplitude of the fundamental of a string at a fret, last window
+ *
+ * @param  string 0 to 3, G C E A
+ * @param  fret 0 for the open string
+ * @retval amplitude, 0 beyond the last fret of the bank
+ */
+float GoertzelBank::string_amplitude(uint8_t string, uint8_t fret) const
+{
+	uint16_t k = (uint16_t)(open_string(string) + fret - GOERTZEL_LOWEST);
+
+	return (string < STRINGS && k < _notes) ? _amplitude[k] : 0.0f;
+}
+
+/**
+ * @brief  Notes that sounded in the last window
+ *
+ * @param  ratio of the strongest note a note must reach, e.g. 0.25
+ * @param  floor amplitude below which nothing sounded
+ * @retval bit k set for note(k)
+ */
+uint32_t GoertzelBank::sounded(float ratio, float floor) const
+{
+	float strongest = 0.0f;
+	uint32_t notes = 0;
+
+	for (uint8_t k = 0; k < _notes; k++) {
+		if (_amplitude[k] > strongest) {
+			strongest = _amplitude[k];
+		}
+	}
+	if (strongest * ratio > floor) {
+		floor = strongest * ratio;
+	}
+	for (uint8_t k = 0; k < _notes; k++) {
+		if (_amplitude[k] >= floor && _amplitude[k] > 0.0f) {
+			notes |= (uint32_t)1 << k;
+		}
+	}
+
+	return notes;
+}
+
+/**
+ * @brief  MIDI number of an open string, re-entrant tuning
+ *
+ * @param  string 0 to 3, G C E A
+ * @retval note, G4 beyond
+ */
+uint8_t GoertzelBank::open_string(uint8_t string)
+{
+	static const uint8_t open[STRINGS] = { 67, 60, 64, 69 };
+
+	return open[string < STRINGS ? string : 0];
+}
+
+/**
+ * @brief  Name of a note, e.g. C#4
+ *
+ * @param  note MIDI number
+ * @param  text at least 5 chars
+ * @retval None
+ */
+void GoertzelBank::name(uint8_t note, char *text)
+{
+	static const char names[] = "C C#D D#E F F#G G#A A#B ";
+	const char *letters = &names[2 * (note % 12)];
+	uint8_t octave = (uint8_t)(note / 12);
+
+	*text++ = letters[0];
+	if (letters[1] != ' ') {
+		*text++ = letters[1];
+	}
+	/* MIDI octave -1 has no note on the fretboard */
+	*text++ = (char)('0' + (octave ? octave - 1 : 0) % 10);
+	*text = '\0';
+}
+
+/* Take the samples [first, end) out of the sums */
+void GoertzelBank::remove(const float *samples, uint8_t stride, uint16_t first, uint16_t end)
+{
+	float turns, c, s, cw, sw, tmp, x;
+
+	if (first >= end) {
+		return;
+	}
+	for (uint8_t k = 0; k < _measured; k++) {
+		/* e^(jw (count - 1 - first)), the turns reduced before the angle */
+		turns = (float)(_count - 1 - first) * _cycles[k];
+		turns -= floorf(turns);
+		c = cosf(2.0f * (float)M_PI * turns);
+		s = sinf(2.0f * (float)M_PI * turns);
+		cw = 0.5f * _coeff[k];
+		sw = _sin[k];
+		for (uint16_t n = first; n < end; n++) {
+			x = samples[(uint32_t)n * stride];
+			_re[k] -= x * c;
+			_im[k] -= x * s;
+			/* Next sample, one step of w less */
+			tmp = c * cw + s * sw;
+			s = s * cw - c * sw;
+			c = tmp;
+		}
+	}
+}
@@ -0,0 +1,117 @@
+/**
+*******************************************************************************
+* @file   GoertzelBank.h
+* @brief  Amplitude of each note of the fretboard over a window
+*******************************************************************************
+* A chord is checked on the fundamentals of its strings, a few dozen known
+* frequencies: the notes of the four strings, G4 C4 E4 A4 in re-entrant
+* tuning, from the open string to the last fret counted. Each note is a
+* Goertzel resonator, two multiply-adds per sample, run on one axis as the
+* samples of the capture arrive, see push(): the amplitudes are ready as
+* soon as the window closes, without a spectrum of the whole window.
+*
+* Notes are semitones from C4, the lowest open string, so that the strings
+* share the notes they have in common: with 12 frets, 22 notes from C4 to
+* A5, all below the Nyquist frequency from 1660 Hz on. At lower rates the
+* notes above it are not measured, their amplitude is 0.
+*
+* window() keeps a part of the samples pushed, the window aligned within a
+* longer capture: the others are removed from the resonators, the capture
+* being still in memory. The amplitude of each note is then that of a
+* sinusoid at its frequency over the window, in the unit of the samples,
+* e.g. g: usable as model input, see amplitudes(), or to tell which notes
+* sounded, see sounded().
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __GOERTZEL_BANK_H__
+#define __GOERTZEL_BANK_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+#define GOERTZEL_NOTES_MAX		32		/* Notes of the bank, bits of sounded() */
+#define GOERTZEL_LOWEST			60		/* MIDI number of C4, the lowest open string */
+#define GOERTZEL_NOTES(frets)	(69 - GOERTZEL_LOWEST + 1 + (frets))	/* C4 to the last fret of A4 */
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class GoertzelBank
+{
+public:
+	static const uint8_t STRINGS = 4;
+
+	GoertzelBank(float odr_hz, uint8_t frets);
+
+	void set_odr(float odr_hz);
+	void reset(void);
+	void window(const float *samples, uint8_t stride, uint16_t start, uint16_t length);
+	float string_amplitude(uint8_t string, uint8_t fret) const;
+	uint32_t sounded(float ratio, float floor) const;
+
+	static uint8_t open_string(uint8_t string);
+	static void name(uint8_t note, char *text);
+
+	/**
+	 * @brief  Next sample of the capture, in order
+	 *
+	 * @param  x sample of the axis measured
+	 * @retval None
+	 */
+	void push(float x)
+	{
+		float s;
+
+		for (uint8_t k = 0; k < _measured; k++) {
+			s = x + _coeff[k] * _s1[k] - _s2[k];
+			_s2[k] = _s1[k];
+			_s1[k] = s;
+		}
+		_count++;
+	}
+
+	/* Notes of the bank */
+	uint8_t notes(void) const
+	{
+		return _notes;
+	}
+
+	/* MIDI number of a note of the bank */
+	uint8_t note(uint8_t k) const
+	{
+		return (uint8_t)(GOERTZEL_LOWEST + k);
+	}
+
+	/* Amplitude of each note over the last window, notes() values from C4 */
+	const float *amplitudes(void) const
+	{
+		return _amplitude;
+	}
+
+	/* Samples pushed since reset() */
+	uint32_t count(void) const
+	{
+		return _count;
+	}
+
+private:
+	void remove(const float *samples, uint8_t stride, uint16_t first, uint16_t end);
+
+	uint8_t _notes;
+	uint8_t _measured;					/* Notes below the Nyquist frequency */
+	uint32_t _count;
+	float _coeff[GOERTZEL_NOTES_MAX];	/* 2 cos(w) */
+	float _sin[GOERTZEL_NOTES_MAX];		/* sin(w) */
+	float _cycles[GOERTZEL_NOTES_MAX];	/* Cycles per sample */
+	float _s1[GOERTZEL_NOTES_MAX];
+	float _s2[GOERTZEL_NOTES_MAX];
+	float _re[GOERTZEL_NOTES_MAX];
+	float _im[GOERTZEL_NOTES_MAX];
+	float _amplitude[GOERTZEL_NOTES_MAX];
+};
+
+#endif
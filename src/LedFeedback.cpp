@@ -0,0 +1,136 @@
+/**
+*******************************************************************************
+* @file   LedFeedback.cpp
+* @brief  Non-blocking LED pattern engine
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "LedFeedback.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+LedFeedback::LedFeedback(EventQueue *events) : _events(events), _event_id(0), _head(0), _count(0), _remaining(0), _on(false), _active(false)
+{
+}
+
+/**
+ * @brief  Play a pattern now, dropping the current and queued ones
+ *
+ * @param  pattern the pattern to play
+ * @retval None
+ */
+void LedFeedback::play(const LedPattern &pattern)
+{
+	core_util_critical_section_enter();
+	cancel();
+	if (_active) {
+		*_current.led = 0;
+	}
+	_count = 0;
+	start(pattern);
+	core_util_critical_section_exit();
+}
+
+/**
+ * @brief  Play a pattern once the current and queued ones are over
+ *
+ * @param  pattern the pattern to play
+ * @retval false if the queue is full, true otherwise
+ */
+bool LedFeedback::queue(const LedPattern &pattern)
+{
+	bool queued = true;
+
+	core_util_critical_section_enter();
+	if (!_active) {
+		start(pattern);
+	} else if (_count < QUEUE_SIZE) {
+		_queue[(_head + _count) % QUEUE_SIZE] = pattern;
+		_count++;
+	} else {
+		queued = false;
+	}
+	core_util_critical_section_exit();
+
+	return queued;
+}
+
+/**
+ * @brief  Stop playing and switch the LED off
+ *
+ * @param  None
+ * @retval None
+ */
+void LedFeedback::stop()
+{
+	core_util_critical_section_enter();
+	cancel();
+	if (_active) {
+		*_current.led = 0;
+	}
+	_count = 0;
+	_active = false;
+	core_util_critical_section_exit();
+}
+
+bool LedFeedback::busy() const
+{
+	return _active;
+}
+
+void LedFeedback::start(const LedPattern &pattern)
+{
+	_current = pattern;
+	_remaining = pattern.repeat;
+	if (_remaining == 0) {
+		_active = false;
+		return;
+	}
+	_active = true;
+	_on = true;
+	*_current.led = 1;
+	schedule(_current.on_ms);
+}
+
+void LedFeedback::step()
+{
+	/* Called from the Timeout interrupt or the event queue */
+	if (_on) {
+		_on = false;
+		*_current.led = 0;
+		schedule(_current.off_ms);
+	} else if (--_remaining > 0) {
+		_on = true;
+		*_current.led = 1;
+		schedule(_current.on_ms);
+	} else if (_count > 0) {
+		LedPattern next = _queue[_head];
+		_head = (_head + 1) % QUEUE_SIZE;
+		_count--;
+		start(next);
+	} else {
+		_active = false;
+	}
+}
+
+void LedFeedback::schedule(uint16_t ms)
+{
+	if (_events) {
+		_event_id = _events->call_in(ms, this, &LedFeedback::step);
+	} else {
+		_timeout.attach_us(callback(this, &LedFeedback::step), ms * 1000);
+	}
+}
+
+void LedFeedback::cancel()
+{
+	if (_events) {
+		if (_event_id) {
+			_events->cancel(_event_id);
+			_event_id = 0;
+		}
+	} else {
+		_timeout.detach();
+	}
+}
@@ -0,0 +1,61 @@
+/**
+*******************************************************************************
+* @file   LedFeedback.h
+* @brief  Non-blocking LED pattern engine
+*******************************************************************************
+* Patterns are played in the background, so the caller returns immediately.
+* play() preempts whatever is playing, queue() appends a pattern to be played
+* after the current one. Steps run from a Timeout interrupt, or as events of
+* the given EventQueue.
+*******************************************************************************
+*/
+
+#ifndef __LED_FEEDBACK_H__
+#define __LED_FEEDBACK_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "mbed.h"
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/* A LED blinked repeat times, on_ms on then off_ms off */
+typedef struct {
+	DigitalOut *led;
+	uint16_t on_ms;
+	uint16_t off_ms;
+	uint8_t repeat;
+} LedPattern;
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class LedFeedback
+{
+public:
+	LedFeedback(EventQueue *events = NULL);
+
+	void play(const LedPattern &pattern);
+	bool queue(const LedPattern &pattern);
+	void stop(void);
+	bool busy(void) const;
+
+private:
+	static const uint8_t QUEUE_SIZE = 4;
+
+	void start(const LedPattern &pattern);
+	void step(void);
+	void schedule(uint16_t ms);
+	void cancel(void);
+
+	EventQueue *_events;
+	int _event_id;
+	Timeout _timeout;
+	LedPattern _current;
+	LedPattern _queue[QUEUE_SIZE];
+	uint8_t _head;
+	uint8_t _count;
+	uint8_t _remaining;
+	bool _on;
+	volatile bool _active;
+};
+
+#endif
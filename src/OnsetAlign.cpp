@@ -0,0 +1,141 @@
+/**
+*******************************************************************************
+* @file   OnsetAlign.cpp
+* @brief  Window aligned on the attack peak of a strum
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "OnsetAlign.h"
+#include <math.h>
+
+/* Class Implementation ------------------------------------------------------*/
+
+/**
+ * @param  pre samples kept before the attack peak
+ * @param  search latest start of the window in the capture, in samples
+ */
+OnsetAligner::OnsetAligner(uint16_t pre, uint16_t search) :
+	_pre(pre), _search(search), _attack(0.0f)
+{
+}
+
+/* Energy of a sample around the resting level */
+static inline float energy(const float *capture, const float *rest, uint16_t n)
+{
+	float e = 0.0f, d;
+
+	for (uint8_t i = 0; i < 3; i++) {
+		d = capture[3 * n + i] - rest[i];
+		e += d * d;
+	}
+	return e;
+}
+
+/**
+ * @brief  Peak of the relative rise of the energy, the energy over the next
+ *         SMOOTH samples against the previous SMOOTH ones
+ *
+ * @param  capture samples, x, y, z interleaved
+ * @param  rest resting level on x, y and z
+ * @param  floor energy over SMOOTH samples added to both, against noise
+ * @param  last latest position searched
+ * @param  enough first local peak at least this high, else the highest
+ * @param  at position of the peak, refined between samples
+ * @retval height of the peak
+ */
+static float rise_peak(const float *capture, const float *rest, float floor, uint16_t last, float enough, float *at)
+{
+	const uint16_t SMOOTH = OnsetAligner::SMOOTH;
+	float before = 0.0f, after = 0.0f, rise, best = 0.0f, left = 0.0f, right = 0.0f, previous = 0.0f, d;
+	uint16_t best_k = SMOOTH;
+	bool next_is_right = false;
+
+	for (uint16_t n = 0; n < SMOOTH; n++) {
+		before += energy(capture, rest, n);
+		after += energy(capture, rest, (uint16_t)(n + SMOOTH));
+	}
+
+	for (uint16_t k = SMOOTH; k <= last; k++) {
+		rise = (after + floor) / (before + floor);
+		if (next_is_right) {
+			right = rise;
+			next_is_right = false;
+			if (rise < best && best >= enough) {
+				break;
+			}
+		}
+		if (rise > best) {
+			best = rise;
+			best_k = k;
+			left = previous;
+			next_is_right = true;
+		}
+		previous = rise;
+
+		d = energy(capture, rest, k);
+		before += d - energy(capture, rest, (uint16_t)(k - SMOOTH));
+		after += energy(capture, rest, (uint16_t)(k + SMOOTH)) - d;
+	}
+
+	/* Vertex of the parabola through the peak and its neighbours */
+	*at = best_k;
+	d = left - 2.0f * best + right;
+	if (best_k > SMOOTH && !next_is_right && d < 0.0f) {
+		*at += 0.5f * (left - right) / d;
+	}
+
+	return best;
+}
+
+/**
+ * @brief  Locate the attack peak of the strum and align the window on it,
+ *         in place
+ *
+ * @param  capture window + margin() samples, x, y, z interleaved
+ * @param  window samples per window
+ * @retval index of the first sample of the aligned window in capture
+ */
+uint16_t OnsetAligner::align(float *capture, uint16_t window)
+{
+	float rest[3] = { 0.0f, 0.0f, 0.0f };
+	float floor = 1e-6f, highest, start, frac;
+	uint16_t rest_samples = (_pre < SMOOTH) ? SMOOTH : _pre;
+	uint16_t last = (uint16_t)(_search + _pre), first;
+
+	/* Resting level from the samples before the strum */
+	for (uint16_t n = 0; n < rest_samples; n++) {
+		for (uint8_t i = 0; i < 3; i++) {
+			rest[i] += capture[3 * n + i] / rest_samples;
+		}
+	}
+	/* Noise floor, or what the previous strums still ring */
+	for (uint16_t n = 0; n < rest_samples; n++) {
+		floor += energy(capture, rest, n) * SMOOTH / rest_samples;
+	}
+
+	/* The first string rings before the others add up: first strong rise */
+	highest = rise_peak(capture, rest, floor, last, HUGE_VALF, &_attack);
+	rise_peak(capture, rest, floor, last, 0.5f * highest, &_attack);
+
+	start = _attack - _pre;
+	if (start <= 0.0f) {
+		return 0;
+	}
+	if (start >= _search) {
+		return _search;
+	}
+	first = (uint16_t)start;
+	frac = start - first;
+
+	/* Resampled in place, each sample only reading the next, original one */
+	if (frac > 0.0f) {
+		float *sample = &capture[3 * first];
+
+		for (uint16_t n = 0; n < window * 3; n++) {
+			sample[n] += frac * (sample[n + 3] - sample[n]);
+		}
+	}
+
+	return first;
+}
@@ -0,0 +1,74 @@
+/**
+*******************************************************************************
+* @file   OnsetAlign.h
+* @brief  Window aligned on the attack peak of a strum
+*******************************************************************************
+* The trigger fires anywhere in the first milliseconds of a strum, so the
+* windows of a same chord are shifted by tens of samples. A capture a little
+* longer than the window is searched for the attack peak: the peak of the
+* energy over the next SMOOTH samples against the previous SMOOTH ones,
+* refined between samples by a parabola through its neighbours. Relative to
+* what was ringing before, the first string stands out as much as the whole
+* chord, so the first peak reaching half of the highest one is taken, which
+* does not move with the loudest string of the stroke. The window then starts
+* PRE samples before the attack, the fractional part being resampled in
+* place by linear interpolation.
+*
+* The capture holds window + margin() samples, x, y, z interleaved. Its
+* first samples are taken as the resting level, so it should start before
+* the strum: keep history() samples before the trigger, more than PRE as the
+* trigger only fires some samples into the strum.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __ONSET_ALIGN_H__
+#define __ONSET_ALIGN_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class OnsetAligner
+{
+public:
+	/* Samples of the energy sums, a period of the lowest string, C4 */
+	static const uint16_t SMOOTH = 12;
+
+	OnsetAligner(uint16_t pre, uint16_t search);
+
+	uint16_t align(float *capture, uint16_t window);
+
+	/* Samples kept before the attack peak */
+	uint16_t pre(void) const
+	{
+		return _pre;
+	}
+
+	/* Samples to keep before the trigger, which fires after the attack */
+	uint16_t history(void) const
+	{
+		return _search;
+	}
+
+	/* Samples captured beyond the window, the last one for interpolation */
+	uint16_t margin(void) const
+	{
+		return (uint16_t)(_search + 1);
+	}
+
+	/* Attack peak in the last capture, in samples from its start */
+	float attack(void) const
+	{
+		return _attack;
+	}
+
+private:
+	uint16_t _pre;
+	uint16_t _search;
+	float _attack;
+};
+
+#endif
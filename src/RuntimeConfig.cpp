@@ -0,0 +1,159 @@
+/**
+*******************************************************************************
+* @file   RuntimeConfig.cpp
+* @brief  Acquisition parameters changed at runtime
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "RuntimeConfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Class Implementation ------------------------------------------------------*/
+
+ConfigStage::ConfigStage(const RuntimeConfig &initial, uint16_t max_window, bool fixed_window) :
+	_active(initial), _staged(initial), _max_window(max_window), _fixed_window(fixed_window),
+	_pending(false), _error("")
+{
+}
+
+/**
+ * @brief  Stage a line of KEY=VALUE assignments
+ *
+ * @param  assignments assignments separated by spaces
+ * @retval false if any of them is invalid, nothing is staged then
+ */
+bool ConfigStage::stage(const char *assignments)
+{
+	RuntimeConfig config = _staged;
+	const char *p = assignments, *key, *equal;
+	size_t length;
+
+	while (*p) {
+		while (*p == ' ') {
+			p++;
+		}
+		if (!*p) {
+			break;
+		}
+		key = p;
+		length = strcspn(p, " ");
+		equal = (const char *)memchr(key, '=', length);
+		if (!equal) {
+			_error = "expected KEY=VALUE";
+			return false;
+		}
+		if (!assign(&config, key, (size_t)(equal - key), equal + 1)) {
+			return false;
+		}
+		p += length;
+	}
+
+	_staged = config;
+	/* Field by field, the padding bytes of RuntimeConfig are indeterminate */
+	_pending = _staged.mini != _active.mini || _staged.thresh != _active.thresh
+	        || _staged.noise != _active.noise || _staged.window != _active.window
+	        || _staged.odr != _active.odr || _staged.fs != _active.fs;
+
+	return true;
+}
+
+/**
+ * @brief  The staged values have been applied
+ *
+ * @param  None
+ * @retval None
+ */
+void ConfigStage::commit()
+{
+	_active = _staged;
+	_pending = false;
+}
+
+/**
+ * @brief  Format a configuration as KEY=VALUE assignments
+ *
+ * @param  buffer destination string
+ * @param  size buffer size
+ * @param  config active() or staged()
+ * @retval number of characters, as snprintf()
+ */
+int ConfigStage::print(char *buffer, size_t size, const RuntimeConfig &config) const
+{
+	return snprintf(buffer, size, "MINI=%u THRESH=%.3f NOISE=%.3f WINDOW=%u ODR=%.0f FS=%.0f",
+	                (unsigned)config.mini, config.thresh, config.noise, (unsigned)config.window, config.odr, config.fs);
+}
+
+bool ConfigStage::assign(RuntimeConfig *config, const char *key, size_t key_length, const char *value)
+{
+	static const float odrs[] = { 13.0f, 26.0f, 52.0f, 104.0f, 208.0f, 416.0f, 833.0f, 1660.0f, 3330.0f, 6660.0f };
+	char *end;
+	float number = strtof(value, &end);
+	uint8_t i;
+
+	if (end == value || (*end != ' ' && *end != '\0')) {
+		_error = "invalid number";
+		return false;
+	}
+
+	/* Ranges are written so that NaN fails them, and checked before any cast */
+	if (key_length == 4 && strncmp(key, "MINI", 4) == 0) {
+		if (!(number >= 1 && number <= 1000)) {
+			_error = "MINI out of 1..1000";
+			return false;
+		}
+		if (number != (float)(uint16_t)number) {
+			_error = "MINI not an integer";
+			return false;
+		}
+		config->mini = (uint16_t)number;
+	} else if (key_length == 6 && strncmp(key, "THRESH", 6) == 0) {
+		if (!(number > 1.0f && number <= 100.0f)) {
+			_error = "THRESH out of ]1..100]";
+			return false;
+		}
+		config->thresh = number;
+	} else if (key_length == 5 && strncmp(key, "NOISE", 5) == 0) {
+		if (!(number >= 0.0f && number <= 16.0f)) {
+			_error = "NOISE out of 0..16";
+			return false;
+		}
+		config->noise = number;
+	} else if (key_length == 6 && strncmp(key, "WINDOW", 6) == 0) {
+		if (!(number >= 1 && number <= _max_window)) {
+			_error = "WINDOW out of range";
+			return false;
+		}
+		if (number != (float)(uint16_t)number) {
+			_error = "WINDOW not an integer";
+			return false;
+		}
+		if (_fixed_window && (uint16_t)number != _max_window) {
+			_error = "WINDOW fixed by the model";
+			return false;
+		}
+		config->window = (uint16_t)number;
+	} else if (key_length == 3 && strncmp(key, "ODR", 3) == 0) {
+		if (!(number > 0.0f && number <= 6660.0f)) {
+			_error = "ODR out of 13..6660";
+			return false;
+		}
+		/* Rounded up to a rate of the sensor, as set_x_odr() does */
+		for (i = 0; i < sizeof(odrs) / sizeof(odrs[0]) - 1 && number > odrs[i]; i++) {
+		}
+		config->odr = odrs[i];
+	} else if (key_length == 2 && strncmp(key, "FS", 2) == 0) {
+		if (number != 2.0f && number != 4.0f && number != 8.0f && number != 16.0f) {
+			_error = "FS not 2, 4, 8 or 16";
+			return false;
+		}
+		config->fs = number;
+	} else {
+		_error = "unknown key";
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,86 @@
+/**
+*******************************************************************************
+* @file   RuntimeConfig.h
+* @brief  Acquisition parameters changed at runtime
+*******************************************************************************
+* Parameters are received as KEY=VALUE assignments, several per line:
+*
+*   MINI=5 THRESH=1.4 NOISE=0.15 WINDOW=1024 ODR=3330 FS=4
+*
+* stage() checks a whole line before keeping any of it. Staged values are
+* applied by the application between windows, then commit() makes them the
+* active ones.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __RUNTIME_CONFIG_H__
+#define __RUNTIME_CONFIG_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef struct {
+	uint16_t mini;		/* StrumTrigger mini-buffer length */
+	float thresh;		/* StrumTrigger ratio */
+	float noise;		/* StrumTrigger noise floor in g */
+	uint16_t window;	/* Samples per window */
+	float odr;			/* Accelerometer output data rate in Hz */
+	float fs;			/* Accelerometer full scale in g */
+} RuntimeConfig;
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class ConfigStage
+{
+public:
+	ConfigStage(const RuntimeConfig &initial, uint16_t max_window, bool fixed_window);
+
+	bool stage(const char *assignments);
+	void commit(void);
+
+	bool pending(void) const
+	{
+		return _pending;
+	}
+
+	/* Output data rate or full scale staged, the sensor is to be updated */
+	bool sensor_changed(void) const
+	{
+		return _staged.odr != _active.odr || _staged.fs != _active.fs;
+	}
+
+	const RuntimeConfig &active(void) const
+	{
+		return _active;
+	}
+
+	const RuntimeConfig &staged(void) const
+	{
+		return _staged;
+	}
+
+	/* Reason for the last stage() failure */
+	const char *error(void) const
+	{
+		return _error;
+	}
+
+	int print(char *buffer, size_t size, const RuntimeConfig &config) const;
+
+private:
+	bool assign(RuntimeConfig *config, const char *key, size_t key_length, const char *value);
+
+	RuntimeConfig _active;
+	RuntimeConfig _staged;
+	uint16_t _max_window;
+	bool _fixed_window;
+	bool _pending;
+	const char *_error;
+};
+
+#endif
@@ -0,0 +1,268 @@
+/**
+*******************************************************************************
+* @file   Sampler.cpp
+* @brief  Periodic reads of slow sensors scheduled on a timer wheel
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "Sampler.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+/**
+ * @param  tick_ms period of the calls to tick(), 1 at least
+ */
+Sampler::Sampler(uint16_t tick_ms) :
+	_tick_ms(tick_ms ? tick_ms : 1), _tick(0), _used(0), _buses_used(0), _sessions(0)
+{
+	for (uint8_t i = 0; i < WHEEL_SLOTS; i++) {
+		_slots[i] = SAMPLER_NONE;
+	}
+}
+
+/**
+ * @brief  Register a bus shared by channels
+ *
+ * @param  bus lock and unlock hooks, copied
+ * @retval index of the bus, SAMPLER_NONE if SAMPLER_BUSES are registered
+ */
+uint8_t Sampler::add_bus(const SamplerBus_t *bus)
+{
+	if (_buses_used == SAMPLER_BUSES) {
+		return SAMPLER_NONE;
+	}
+	_buses[_buses_used] = *bus;
+
+	return _buses_used++;
+}
+
+/**
+ * @brief  Register a channel, read for the first time at the next tick
+ *
+ * @param  sensor read by the channel
+ * @param  bus index given by add_bus(), SAMPLER_NONE for no lock
+ * @param  period_ms time between two reads, rounded to ticks
+ * @param  ring last samples of the channel, depth of them
+ * @param  depth samples of ring
+ * @retval index of the channel, SAMPLER_NONE if it cannot be added
+ */
+uint8_t Sampler::add(TempSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth)
+{
+	return add_channel(sensor, SAMPLER_TEMPERATURE, bus, period_ms, ring, depth);
+}
+
+uint8_t Sampler::add(HumiditySensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth)
+{
+	return add_channel(sensor, SAMPLER_HUMIDITY, bus, period_ms, ring, depth);
+}
+
+uint8_t Sampler::add(PressureSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth)
+{
+	return add_channel(sensor, SAMPLER_PRESSURE, bus, period_ms, ring, depth);
+}
+
+uint8_t Sampler::add(MagneticSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth)
+{
+	return add_channel(sensor, SAMPLER_MAGNETIC, bus, period_ms, ring, depth);
+}
+
+uint8_t Sampler::add(LightSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth)
+{
+	return add_channel(sensor, SAMPLER_LIGHT, bus, period_ms, ring, depth);
+}
+
+uint8_t Sampler::add(RangeSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth)
+{
+	return add_channel(sensor, SAMPLER_RANGE, bus, period_ms, ring, depth);
+}
+
+uint8_t Sampler::add_channel(void *sensor, SamplerKind_t kind, uint8_t bus, uint32_t period_ms,
+                             SamplerSample_t *ring, uint16_t depth)
+{
+	Channel *channel;
+
+	if (_used == SAMPLER_CHANNELS || sensor == NULL || ring == NULL || depth == 0 ||
+	    (bus != SAMPLER_NONE && bus >= _buses_used)) {
+		return SAMPLER_NONE;
+	}
+	channel = &_channels[_used];
+
+	channel->sensor = sensor;
+	channel->kind = kind;
+	channel->bus = bus;
+	channel->period = (period_ms + _tick_ms / 2) / _tick_ms;
+	if (channel->period == 0) {
+		channel->period = 1;
+	}
+	channel->ring = ring;
+	channel->depth = depth;
+	channel->head = 0;
+	channel->count = 0;
+	channel->errors = 0;
+
+	/* First read at the next tick */
+	channel->rounds = 0;
+	channel->next = _slots[(_tick + 1) % WHEEL_SLOTS];
+	_slots[(_tick + 1) % WHEEL_SLOTS] = _used;
+
+	return _used++;
+}
+
+/**
+ * @brief  Put a channel back on the wheel, one period after the current tick
+ *
+ * @param  channel index of the channel, out of any list
+ * @retval None
+ */
+void Sampler::schedule(uint8_t channel)
+{
+	Channel *c = &_channels[channel];
+	uint8_t slot = (uint8_t)((_tick + c->period) % WHEEL_SLOTS);
+
+	c->rounds = (c->period - 1) / WHEEL_SLOTS;
+	c->next = _slots[slot];
+	_slots[slot] = channel;
+}
+
+/**
+ * @brief  Advance by one tick and read the channels due
+ *
+ * @param  None
+ * @retval mask of the channels with a new sample, bit n for channel n
+ */
+uint32_t Sampler::tick()
+{
+	/* Reads of the tick per bus, the last list for channels without one */
+	uint8_t due[SAMPLER_BUSES + 1];
+	uint8_t *link, index, next;
+	uint32_t sampled = 0;
+
+	_tick++;
+	for (uint8_t b = 0; b <= SAMPLER_BUSES; b++) {
+		due[b] = SAMPLER_NONE;
+	}
+
+	/* Only the channels of this slot, the others are not due */
+	link = &_slots[_tick % WHEEL_SLOTS];
+	while (*link != SAMPLER_NONE) {
+		Channel *c = &_channels[*link];
+
+		if (c->rounds > 0) {
+			c->rounds--;
+			link = &c->next;
+			continue;
+		}
+		index = *link;
+		*link = c->next;
+		next = (c->bus == SAMPLER_NONE) ? SAMPLER_BUSES : c->bus;
+		c->next = due[next];
+		due[next] = index;
+	}
+
+	for (uint8_t b = 0; b <= SAMPLER_BUSES; b++) {
+		const SamplerBus_t *bus = (b < _buses_used) ? &_buses[b] : NULL;
+
+		if (due[b] == SAMPLER_NONE) {
+			continue;
+		}
+		/* One session for all the reads on the bus */
+		if (bus != NULL && bus->lock != NULL) {
+			bus->lock(bus->context);
+			_sessions++;
+		}
+		for (index = due[b]; index != SAMPLER_NONE; index = next) {
+			next = _channels[index].next;
+			if (read(index)) {
+				sampled |= (uint32_t)1 << index;
+			}
+			schedule(index);
+		}
+		if (bus != NULL && bus->unlock != NULL) {
+			bus->unlock(bus->context);
+		}
+	}
+
+	return sampled;
+}
+
+/**
+ * @brief  Read the sensor of a channel into its ring
+ *
+ * @param  channel index of the channel
+ * @retval true if a sample was stored
+ */
+bool Sampler::read(uint8_t channel)
+{
+	Channel *c = &_channels[channel];
+	SamplerSample_t sample;
+	int32_t axes[3];
+	uint32_t value;
+	int status;
+
+	sample.value[1] = 0;
+	sample.value[2] = 0;
+	switch (c->kind) {
+	case SAMPLER_TEMPERATURE:
+		status = ((TempSensor *)c->sensor)->get_temperature(&sample.value[0]);
+		break;
+	case SAMPLER_HUMIDITY:
+		status = ((HumiditySensor *)c->sensor)->get_humidity(&sample.value[0]);
+		break;
+	case SAMPLER_PRESSURE:
+		status = ((PressureSensor *)c->sensor)->get_pressure(&sample.value[0]);
+		break;
+	case SAMPLER_MAGNETIC:
+		status = ((MagneticSensor *)c->sensor)->get_m_axes(axes);
+		for (uint8_t i = 0; i < 3; i++) {
+			sample.value[i] = (float)axes[i];
+		}
+		break;
+	case SAMPLER_LIGHT:
+		status = ((LightSensor *)c->sensor)->get_lux(&value);
+		sample.value[0] = (float)value;
+		break;
+	case SAMPLER_RANGE:
+	default:
+		status = ((RangeSensor *)c->sensor)->get_distance(&value);
+		sample.value[0] = (float)value;
+		break;
+	}
+	if (status != 0) {
+		c->errors++;
+		return false;
+	}
+
+	/* Stored only once read, a failure keeps the oldest sample */
+	sample.tick = _tick;
+	c->ring[c->head] = sample;
+	c->head = (uint16_t)((c->head + 1) % c->depth);
+	c->count++;
+
+	return true;
+}
+
+/**
+ * @brief  A sample of a channel
+ *
+ * @param  channel index of the channel
+ * @param  age 0 for the last sample, 1 for the one before...
+ * @param  sample output
+ * @retval false if the channel does not hold that sample
+ */
+bool Sampler::get(uint8_t channel, uint16_t age, SamplerSample_t *sample) const
+{
+	const Channel *c;
+
+	if (channel >= _used) {
+		return false;
+	}
+	c = &_channels[channel];
+	if (age >= c->depth || age >= c->count) {
+		return false;
+	}
+	*sample = c->ring[(c->head + c->depth - 1 - age) % c->depth];
+
+	return true;
+}
@@ -0,0 +1,159 @@
+/**
+*******************************************************************************
+* @file   Sampler.h
+* @brief  Periodic reads of slow sensors scheduled on a timer wheel
+*******************************************************************************
+* Sensors behind the interfaces of lib/lsm6dsl/Sensors (temperature,
+* humidity, pressure, magnetic field, light, range) are registered as
+* channels, each with its own period, and read by tick(), which the event
+* loop calls every tick_ms. The accelerometer keeps its FIFO and windows,
+* this adds slower context read alongside without a polling loop per
+* sensor.
+*
+* Channels wait in a hashed timer wheel of WHEEL_SLOTS slots: a tick only
+* visits the channels of its slot, those whose period wraps the wheel
+* counting down rounds. Channels due in the same tick are read together,
+* grouped by bus, each bus being taken once for its group through the
+* lock and unlock hooks given with it, e.g. LSM6DSLSensor::bus_lock().
+*
+* Each channel keeps its last samples in a ring given at registration.
+* Samples are stamped with the tick count of the sampler, the same for all
+* the channels read in a tick, so that readings of different sensors can be
+* matched; tick_ms converts them to time.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "TempSensor.h"
+#include "HumiditySensor.h"
+#include "PressureSensor.h"
+#include "MagneticSensor.h"
+#include "LightSensor.h"
+#include "RangeSensor.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define SAMPLER_CHANNELS		8		/* Channels of a sampler, bits of the tick() mask */
+#define SAMPLER_BUSES			4		/* Buses of a sampler */
+#define SAMPLER_NONE			0xFF	/* No channel, no bus */
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef enum {
+	SAMPLER_TEMPERATURE = 0,	/* TempSensor, °C */
+	SAMPLER_HUMIDITY,			/* HumiditySensor, % */
+	SAMPLER_PRESSURE,			/* PressureSensor, mbar */
+	SAMPLER_MAGNETIC,			/* MagneticSensor, x, y and z in mGauss */
+	SAMPLER_LIGHT,				/* LightSensor, lux */
+	SAMPLER_RANGE				/* RangeSensor, mm */
+} SamplerKind_t;
+
+typedef struct {
+	uint32_t tick;			/* Tick of the read, see Sampler::tick_ms() */
+	float value[3];			/* value[0] only, but for SAMPLER_MAGNETIC */
+} SamplerSample_t;
+
+/* Taking a bus for the reads of a tick, NULL hooks for a bus without lock */
+typedef struct {
+	void (*lock)(void *context);
+	void (*unlock)(void *context);
+	void *context;
+} SamplerBus_t;
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class Sampler
+{
+public:
+	static const uint8_t WHEEL_SLOTS = 16;
+
+	Sampler(uint16_t tick_ms);
+
+	uint8_t add_bus(const SamplerBus_t *bus);
+	uint8_t add(TempSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth);
+	uint8_t add(HumiditySensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth);
+	uint8_t add(PressureSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth);
+	uint8_t add(MagneticSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth);
+	uint8_t add(LightSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth);
+	uint8_t add(RangeSensor *sensor, uint8_t bus, uint32_t period_ms, SamplerSample_t *ring, uint16_t depth);
+
+	uint32_t tick(void);
+
+	bool get(uint8_t channel, uint16_t age, SamplerSample_t *sample) const;
+
+	/* Samples stored since registration, to find out new ones */
+	uint32_t count(uint8_t channel) const
+	{
+		return _channels[channel].count;
+	}
+
+	/* Reads that failed, nothing stored */
+	uint32_t errors(uint8_t channel) const
+	{
+		return _channels[channel].errors;
+	}
+
+	SamplerKind_t kind(uint8_t channel) const
+	{
+		return _channels[channel].kind;
+	}
+
+	uint8_t channels(void) const
+	{
+		return _used;
+	}
+
+	/* Ticks since start, the stamp of samples read now */
+	uint32_t ticks(void) const
+	{
+		return _tick;
+	}
+
+	uint16_t tick_ms(void) const
+	{
+		return _tick_ms;
+	}
+
+	/* Bus locks taken, one per bus and tick with reads */
+	uint32_t bus_sessions(void) const
+	{
+		return _sessions;
+	}
+
+private:
+	typedef struct {
+		void *sensor;
+		SamplerKind_t kind;
+		uint8_t bus;
+		uint8_t next;			/* In the slot, or in the reads of a tick */
+		uint32_t period;		/* Ticks */
+		uint32_t rounds;		/* Turns of the wheel before it is due */
+		SamplerSample_t *ring;
+		uint16_t depth;
+		uint16_t head;			/* Next sample written */
+		uint32_t count;
+		uint32_t errors;
+	} Channel;
+
+	uint8_t add_channel(void *sensor, SamplerKind_t kind, uint8_t bus, uint32_t period_ms,
+	                    SamplerSample_t *ring, uint16_t depth);
+	void schedule(uint8_t channel);
+	bool read(uint8_t channel);
+
+	uint16_t _tick_ms;
+	uint32_t _tick;
+	uint8_t _used;
+	uint8_t _buses_used;
+	uint32_t _sessions;
+	uint8_t _slots[WHEEL_SLOTS];
+	Channel _channels[SAMPLER_CHANNELS];
+	SamplerBus_t _buses[SAMPLER_BUSES];
+};
+
+#endif
@@ -0,0 +1,90 @@
+/**
+*******************************************************************************
+* @file   SensorEvents.cpp
+* @brief  LSM6DSL interrupt dispatcher
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "SensorEvents.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+SensorEvents::SensorEvents(LSM6DSLSensor *sensor, EventLoop *loop) :
+	_sensor(sensor), _loop(loop), _count(0), _int1(false), _int2(false), _pending(false), _dispatches(0)
+{
+}
+
+/**
+ * @brief  Dispatch the events signaled on a sensor interrupt pin
+ *
+ * @param  pin LSM6DSL_INT1_PIN or LSM6DSL_INT2_PIN
+ * @retval None
+ */
+void SensorEvents::attach(LSM6DSL_Interrupt_Pin_t pin)
+{
+	if (pin == LSM6DSL_INT1_PIN) {
+		_int1 = true;
+		_sensor->attach_int1_irq(callback(this, &SensorEvents::irq));
+		_sensor->enable_int1_irq();
+	} else {
+		_int2 = true;
+		_sensor->attach_int2_irq(callback(this, &SensorEvents::irq));
+		_sensor->enable_int2_irq();
+	}
+}
+
+/**
+ * @brief  Add a handler of the sensor events, run from the event loop
+ *
+ * @param  handler function given the event status
+ * @retval false if MAX_SUBSCRIBERS are already registered
+ */
+bool SensorEvents::subscribe(Callback<void(LSM6DSL_Event_Status_t)> handler)
+{
+	if (_count == MAX_SUBSCRIBERS) {
+		return false;
+	}
+	_subscribers[_count++] = handler;
+
+	return true;
+}
+
+void SensorEvents::irq()
+{
+	/* Interrupts raised before the dispatch runs are served by it */
+	if (!_pending) {
+		_pending = true;
+		_loop->post(callback(this, &SensorEvents::dispatch));
+	}
+}
+
+void SensorEvents::dispatch()
+{
+	LSM6DSL_Event_Status_t status;
+	bool any;
+
+	_pending = false;
+	if (_sensor->get_event_status(&status) != 0) {
+		return;
+	}
+	_dispatches++;
+
+	for (uint8_t i = 0; i < _count; i++) {
+		_subscribers[i](status);
+	}
+
+	/* A source still active keeps the pin high and no new edge will come,
+	   dispatch again as long as the handlers have something to serve */
+	any = status.FreeFallStatus || status.TapStatus || status.DoubleTapStatus || status.WakeUpStatus ||
+	      status.StepStatus || status.TiltStatus || status.D6DOrientationStatus ||
+	      status.FifoWatermarkStatus || status.FifoOverrunStatus;
+	if (any && pin_active()) {
+		irq();
+	}
+}
+
+bool SensorEvents::pin_active()
+{
+	return (_int1 && _sensor->get_int1_level()) || (_int2 && _sensor->get_int2_level());
+}
@@ -0,0 +1,54 @@
+/**
+*******************************************************************************
+* @file   SensorEvents.h
+* @brief  LSM6DSL interrupt dispatcher
+*******************************************************************************
+* The INT1/INT2 interrupt only posts a dispatch to the event loop. There the
+* event sources are read once with get_event_status(), which also releases
+* latched interrupts, and the status is given to every subscriber. Nothing
+* is read from the sensor until an interrupt fires.
+*******************************************************************************
+*/
+
+#ifndef __SENSOR_EVENTS_H__
+#define __SENSOR_EVENTS_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "mbed.h"
+#include "LSM6DSLSensor.h"
+#include "EventLoop.h"
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class SensorEvents
+{
+public:
+	static const uint8_t MAX_SUBSCRIBERS = 4;
+
+	SensorEvents(LSM6DSLSensor *sensor, EventLoop *loop);
+
+	void attach(LSM6DSL_Interrupt_Pin_t pin);
+	bool subscribe(Callback<void(LSM6DSL_Event_Status_t)> handler);
+
+	/* Dispatches run since start */
+	uint32_t dispatches(void) const
+	{
+		return _dispatches;
+	}
+
+private:
+	void irq(void);
+	void dispatch(void);
+	bool pin_active(void);
+
+	LSM6DSLSensor *_sensor;
+	EventLoop *_loop;
+	Callback<void(LSM6DSL_Event_Status_t)> _subscribers[MAX_SUBSCRIBERS];
+	uint8_t _count;
+	bool _int1;
+	bool _int2;
+	volatile bool _pending;
+	uint32_t _dispatches;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/**
+*******************************************************************************
+* @file   StreamWindow.cpp
+* @brief  Sliding window over a continuous stream of accelerometer samples
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "StreamWindow.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+/**
+ * @param  buffer 3 * STREAM_BUFFER_SAMPLES(window, hop) floats
+ * @param  window samples per window
+ * @param  hop samples between two windows, dividing window; a hop that
+ *         does not is replaced by window, without overlap
+ */
+StreamWindow::StreamWindow(float *buffer, uint16_t window, uint16_t hop) :
+	_buffer(buffer), _window(window), _hop(hop)
+{
+	if (_hop == 0 || _hop > _window || _window % _hop != 0) {
+		_hop = _window;
+	}
+	_mirror = (uint16_t)(_window - _hop);
+	reset();
+}
+
+/**
+ * @brief  Forget the samples, the next window is complete after WINDOW
+ *         samples
+ *
+ * @param  None
+ * @retval None
+ */
+void StreamWindow::reset()
+{
+	_pos = 0;
+	_filled = 0;
+	_since_hop = 0;
+	_hops = 0;
+}
+
+/**
+ * @brief  Add one sample
+ *
+ * @param  xyz acceleration on x, y and z in g
+ * @retval true if a window is complete with this sample, see window()
+ */
+bool StreamWindow::push(const float *xyz)
+{
+	float *sample = &_buffer[3 * _pos];
+
+	sample[0] = xyz[0];
+	sample[1] = xyz[1];
+	sample[2] = xyz[2];
+	if (_pos < _mirror) {
+		sample += 3 * _window;
+		sample[0] = xyz[0];
+		sample[1] = xyz[1];
+		sample[2] = xyz[2];
+	}
+	if (++_pos == _window) {
+		_pos = 0;
+	}
+
+	if (_filled < _window) {
+		if (++_filled < _window) {
+			return false;
+		}
+	} else if (++_since_hop < _hop) {
+		return false;
+	}
+	_since_hop = 0;
+	_hops++;
+
+	return true;
+}
@@ -0,0 +1,81 @@
+/**
+*******************************************************************************
+* @file   StreamWindow.h
+* @brief  Sliding window over a continuous stream of accelerometer samples
+*******************************************************************************
+* Keeps the last WINDOW samples of the stream and signals every HOP new
+* samples, so that the window can be analyzed with a HOP overlap.
+*
+* The window is handed out as a contiguous x, y, z array without copying
+* it: the ring is followed by a mirror of its first WINDOW - HOP samples,
+* written along with them. Windows start on a multiple of HOP, so the
+* samples that wrapped around are always found in the mirror. This costs
+* WINDOW - HOP samples of RAM, and a second store for some samples, instead
+* of moving WINDOW samples at every hop.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __STREAM_WINDOW_H__
+#define __STREAM_WINDOW_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Samples of the buffer given to StreamWindow, the hop dividing the window */
+#define STREAM_BUFFER_SAMPLES(window, hop)	(2 * (window) - (hop))
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class StreamWindow
+{
+public:
+	StreamWindow(float *buffer, uint16_t window, uint16_t hop);
+
+	bool push(const float *xyz);
+	void reset(void);
+
+	/* Oldest first, valid until the next push() */
+	const float *window(void) const
+	{
+		return &_buffer[3 * _pos];
+	}
+
+	/* Samples to push before the next hop */
+	uint16_t until_hop(void) const
+	{
+		return (_filled < _window) ? (uint16_t)(_window - _filled) : (uint16_t)(_hop - _since_hop);
+	}
+
+	/* Samples per window */
+	uint16_t samples(void) const
+	{
+		return _window;
+	}
+
+	uint16_t hop(void) const
+	{
+		return _hop;
+	}
+
+	/* Windows completed since reset() */
+	uint32_t hops(void) const
+	{
+		return _hops;
+	}
+
+private:
+	float *_buffer;
+	uint16_t _window;
+	uint16_t _hop;
+	uint16_t _mirror;
+	uint16_t _pos;
+	uint16_t _filled;
+	uint16_t _since_hop;
+	uint32_t _hops;
+};
+
+#endif
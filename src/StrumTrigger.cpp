@@ -0,0 +1,87 @@
+/**
+*******************************************************************************
+* @file   StrumTrigger.cpp
+* @brief  Strum detection on a stream of accelerometer samples
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "StrumTrigger.h"
+#include <math.h>
+
+/* Class Implementation ------------------------------------------------------*/
+
+StrumTrigger::StrumTrigger(uint16_t mini, float thresh, float noise) :
+	_mini(mini), _thresh(thresh), _noise(noise)
+{
+	reset();
+}
+
+/**
+ * @brief  Forget the reference mini-buffer and the partial sums
+ *
+ * @param  None
+ * @retval None
+ */
+void StrumTrigger::reset()
+{
+	_count = 0;
+	_has_ref = false;
+	for (uint8_t i = 0; i < 3; i++) {
+		_sum[i] = 0.0f;
+		_ref_avg[i] = 0.0f;
+	}
+}
+
+/**
+ * @brief  Change the detection parameters, starting over
+ *
+ * @param  mini number of samples averaged in a mini-buffer
+ * @param  thresh ratio to the previous mini-buffer average
+ * @param  noise noise floor in g
+ * @retval None
+ */
+void StrumTrigger::configure(uint16_t mini, float thresh, float noise)
+{
+	_mini = mini;
+	_thresh = thresh;
+	_noise = noise;
+	reset();
+}
+
+/**
+ * @brief  Add one sample
+ *
+ * @param  xyz acceleration on x, y and z in g
+ * @retval true if a strum is detected on the mini-buffer this sample completes
+ */
+bool StrumTrigger::push(const float *xyz)
+{
+	float avg[3];
+	bool above_noise = true, above_ref = false, triggered;
+
+	for (uint8_t i = 0; i < 3; i++) {
+		_sum[i] += xyz[i];
+	}
+	if (++_count < _mini) {
+		return false;
+	}
+
+	for (uint8_t i = 0; i < 3; i++) {
+		avg[i] = fabsf(_sum[i] / _mini);
+		// If we are in a really small range, it might just be noise
+		above_noise = above_noise && (avg[i] > _noise);
+		above_ref = above_ref || (avg[i] > _ref_avg[i] * _thresh);
+	}
+	triggered = _has_ref && above_noise && above_ref;
+
+	// The mini-buffer just completed is the reference for the next one
+	for (uint8_t i = 0; i < 3; i++) {
+		_ref_avg[i] = avg[i];
+		_sum[i] = 0.0f;
+	}
+	_count = 0;
+	_has_ref = true;
+
+	return triggered;
+}
@@ -0,0 +1,42 @@
+/**
+*******************************************************************************
+* @file   StrumTrigger.h
+* @brief  Strum detection on a stream of accelerometer samples
+*******************************************************************************
+* Samples are pushed one by one and averaged over mini-buffers of MINI
+* samples. A strum is detected when the absolute average of a mini-buffer is
+* above the noise floor on every axis and exceeds the previous mini-buffer
+* average by the THRESH ratio on at least one axis.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __STRUM_TRIGGER_H__
+#define __STRUM_TRIGGER_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class StrumTrigger
+{
+public:
+	StrumTrigger(uint16_t mini, float thresh, float noise);
+
+	bool push(const float *xyz);
+	void reset(void);
+	void configure(uint16_t mini, float thresh, float noise);
+
+private:
+	uint16_t _mini;
+	float _thresh;
+	float _noise;
+	uint16_t _count;
+	bool _has_ref;
+	float _sum[3];
+	float _ref_avg[3];
+};
+
+#endif
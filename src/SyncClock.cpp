@@ -0,0 +1,179 @@
+/**
+*******************************************************************************
+* @file   SyncClock.cpp
+* @brief  Sample times against an external sync edge shared by recorders
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include "SyncClock.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+/**
+ * @param  odr_hz nominal output data rate of the samples
+ * @param  period_us period of the sync pulse
+ */
+SyncClock::SyncClock(float odr_hz, uint32_t period_us) :
+	_period_ticks(period_us / SYNC_TICK_US), _period_us(period_us), _index(0), _level(-1), _run_first(0),
+	_observations(0), _outliers(0), _rejected(0), _ticking(false), _last_timestamp(0), _ticks(0), _origin(0.0), _edges(0),
+	_edge_pos(0), _fit_count(0), _fit_number(0.0), _fit_ticks(0.0), _fit_period(0.0)
+{
+	set_odr(odr_hz);
+}
+
+/**
+ * @brief  Change the output data rate, which starts a new run
+ *
+ * @param  odr_hz nominal output data rate of the samples
+ * @retval None
+ */
+void SyncClock::set_odr(float odr_hz)
+{
+	_sample_ticks = 1e6 / (odr_hz * SYNC_TICK_US);
+	restart();
+}
+
+/**
+ * @brief  Start a new run: the next samples do not follow the previous ones
+ *
+ * @param  None
+ * @retval None
+ * @note   The edges already seen are kept, their times do not depend on
+ *         the run.
+ */
+void SyncClock::restart()
+{
+	_run_first = _index;
+	_observations = 0;
+	_outliers = 0;
+	_level = -1;
+}
+
+/**
+ * @brief  Place the samples of the run on the timestamp counter
+ *
+ * @param  timestamp counter read right after the FIFO level
+ * @param  newest index of the newest sample the FIFO held, see index()
+ * @retval None
+ */
+void SyncClock::observe(uint32_t timestamp, uint32_t newest)
+{
+	double origin;
+
+	/* 24-bit counter */
+	_ticks = _ticking ? _ticks + ((timestamp - _last_timestamp) & 0xFFFFFF) : timestamp;
+	_last_timestamp = timestamp;
+	_ticking = true;
+
+	/* The newest sample was produced within the period before the read,
+	   the counter truncates to the tick */
+	origin = _ticks + 0.5 - 0.5 * _sample_ticks - (double)newest * _sample_ticks;
+	/* A counter read across a carry between its bytes, unless it lasts */
+	if (_observations >= 8 && fabs(origin - _origin) > 2 * _sample_ticks) {
+		_rejected++;
+		if (++_outliers < 8) {
+			return;
+		}
+		_observations = 0;
+	}
+	_outliers = 0;
+	if (_observations == 0) {
+		_origin = origin;
+		_observations = 1;
+		return;
+	}
+	if (_observations < AVERAGE) {
+		_observations++;
+	}
+	_origin += (origin - _origin) / _observations;
+}
+
+/**
+ * @brief  Time of a sample against the sync edges
+ *
+ * @param  index of the sample, see index()
+ * @param  time output
+ * @retval false if the sample is not in the current run, or the clock not
+ *         locked yet, see locked()
+ */
+bool SyncClock::time(uint32_t index, SyncTime_t *time) const
+{
+	double ticks, position;
+
+	if (!locked() || index < _run_first) {
+		return false;
+	}
+	ticks = _origin + (double)index * _sample_ticks;
+	position = _fit_number + (ticks - _fit_ticks) / _fit_period;
+	if (position < 0) {
+		return false;
+	}
+	time->edge = (uint32_t)position;
+	time->offset_us = (float)((position - time->edge) * _period_us);
+	time->sample_us = (float)(_sample_ticks / _fit_period * _period_us);
+	time->drift_ppm = (float)((_fit_period / _period_ticks - 1.0) * 1e6);
+
+	return true;
+}
+
+/**
+ * @brief  Number a rising edge of the stamp and fit it
+ *
+ * @param  index of the first sample with the pulse active
+ * @retval None
+ */
+void SyncClock::edge(uint32_t index)
+{
+	double ticks, periods;
+	int32_t number = 0;
+	uint8_t last;
+
+	if (_observations == 0) {
+		return;
+	}
+	/* Halfway from the previous sample */
+	ticks = _origin + ((double)index - 0.5) * _sample_ticks;
+	if (_edges > 0) {
+		last = (uint8_t)((_edge_pos + SYNC_EDGES - 1) % SYNC_EDGES);
+		periods = (ticks - _edge_ticks[last]) / (_fit_count >= 2 ? _fit_period : _period_ticks);
+		/* A bounce, or a pulse out of the sync period */
+		if (periods < 0.5) {
+			return;
+		}
+		number = _edge_number[last] + (int32_t)(periods + 0.5);
+	}
+	_edge_number[_edge_pos] = number;
+	_edge_ticks[_edge_pos] = ticks;
+	_edge_pos = (uint8_t)((_edge_pos + 1) % SYNC_EDGES);
+	if (_fit_count < SYNC_EDGES) {
+		_fit_count++;
+	}
+	_edges++;
+	fit();
+}
+
+/* Least squares line of the edge times against their numbers */
+void SyncClock::fit()
+{
+	double numbers = 0.0, ticks = 0.0, sxx = 0.0, sxy = 0.0, dx;
+
+	if (_fit_count < 2) {
+		return;
+	}
+	for (uint8_t i = 0; i < _fit_count; i++) {
+		numbers += _edge_number[i];
+		ticks += _edge_ticks[i];
+	}
+	numbers /= _fit_count;
+	ticks /= _fit_count;
+	for (uint8_t i = 0; i < _fit_count; i++) {
+		dx = _edge_number[i] - numbers;
+		sxx += dx * dx;
+		sxy += dx * (_edge_ticks[i] - ticks);
+	}
+	_fit_number = numbers;
+	_fit_ticks = ticks;
+	_fit_period = sxy / sxx;
+}
@@ -0,0 +1,136 @@
+/**
+*******************************************************************************
+* @file   SyncClock.h
+* @brief  Sample times against an external sync edge shared by recorders
+*******************************************************************************
+* Boards recording together, and an audio recorder, receive the same
+* periodic sync pulse, e.g. 1 Hz. On each board the pulse drives DEN, whose
+* level the sensor stamps into every sample, see enable_den_stamping(): the
+* edges are found in the sample stream itself, to the sample, without any
+* interrupt.
+*
+* The sensor timestamp counter, see enable_timestamp(), runs on the same
+* oscillator as the output data rate, so samples are evenly spaced in its
+* ticks. Reading it with the FIFO level places the newest sample held to
+* within a sample period; these observations are averaged over the run of
+* contiguous samples into the tick time of its samples. A run ends at any
+* gap, FIFO reset or lost samples, see restart(); the counter goes on
+* meanwhile, so edges seen in different runs stay on the same time line.
+*
+* The edge times are numbered from the first edge seen, missing edges being
+* counted by their spacing, and fitted by a line over the last SYNC_EDGES.
+* Its slope is the length of the sync period in sensor ticks: the drift of
+* the sensor clock against the sync source. time() converts a sample into
+* the last edge before it and the time elapsed since, in microseconds of the
+* sync source, and gives the sample period in the same unit: samples of
+* several boards are then merged by index arithmetic.
+*
+* The timestamp counter wraps every 419 s, observe() must be called more
+* often. With the sync source stopped, the last fit is extrapolated.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __SYNC_CLOCK_H__
+#define __SYNC_CLOCK_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+#define SYNC_TICK_US			25.0	/* LSB of the sensor timestamp counter */
+#define SYNC_EDGES				16		/* Edges of the clock fit */
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef struct {
+	uint32_t edge;			/* Last sync edge before the sample, the first one seen being 0 */
+	float offset_us;		/* Time from that edge to the sample */
+	float sample_us;		/* Sample period */
+	float drift_ppm;		/* Sensor clock against the sync source, positive when fast */
+} SyncTime_t;
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class SyncClock
+{
+public:
+	/* Observations averaged for the time of a run, older ones fade out */
+	static const uint16_t AVERAGE = 256;
+
+	SyncClock(float odr_hz, uint32_t period_us);
+
+	void set_odr(float odr_hz);
+	void restart(void);
+	void observe(uint32_t timestamp, uint32_t newest);
+	bool time(uint32_t index, SyncTime_t *time) const;
+
+	/**
+	 * @brief  Sample of the current run, in order
+	 *
+	 * @param  level of the DEN stamp, true when the sync pulse is active
+	 * @retval None
+	 */
+	void push(bool level)
+	{
+		if (level && _level == 0) {
+			edge(_index);
+		}
+		_level = level ? 1 : 0;
+		_index++;
+	}
+
+	/* Index of the next sample pushed */
+	uint32_t index(void) const
+	{
+		return _index;
+	}
+
+	/* Edges seen since start */
+	uint32_t edges(void) const
+	{
+		return _edges;
+	}
+
+	/* Observations off by more than two sample periods, not averaged */
+	uint32_t rejected(void) const
+	{
+		return _rejected;
+	}
+
+	/* Times can be given, see time() */
+	bool locked(void) const
+	{
+		return _fit_count >= 2 && _observations > 0;
+	}
+
+private:
+	void edge(uint32_t index);
+	void fit(void);
+
+	double _sample_ticks;		/* Sample period in ticks */
+	double _period_ticks;		/* Nominal sync period in ticks */
+	uint32_t _period_us;
+	uint32_t _index;
+	int8_t _level;				/* -1 at the start of a run */
+	uint32_t _run_first;
+	uint16_t _observations;
+	uint8_t _outliers;			/* Rejected in a row */
+	uint32_t _rejected;
+	bool _ticking;
+	uint32_t _last_timestamp;
+	uint32_t _ticks;			/* Timestamp extended to 32 bits */
+	double _origin;				/* Ticks of sample 0, in the current run */
+	uint32_t _edges;
+	int32_t _edge_number[SYNC_EDGES];
+	double _edge_ticks[SYNC_EDGES];
+	uint8_t _edge_pos;
+	uint8_t _fit_count;
+	double _fit_number;			/* Mean edge number of the fit */
+	double _fit_ticks;			/* Mean edge time of the fit */
+	double _fit_period;			/* Sync period in ticks */
+};
+
+#endif
@@ -0,0 +1,105 @@
+/**
+*******************************************************************************
+* @file   Telemetry.cpp
+* @brief  Runtime counters sent as compact binary frames
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "Telemetry.h"
+
+/* Functions -----------------------------------------------------------------*/
+
+static uint8_t *put_varint(uint8_t *out, uint32_t value)
+{
+	while (value >= 0x80) {
+		*out++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (uint8_t)value;
+
+	return out;
+}
+
+static uint16_t crc16(const uint8_t *data, size_t length)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (length--) {
+		crc ^= (uint16_t)(*data++ << 8);
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+/* Class Implementation ------------------------------------------------------*/
+
+Telemetry::Telemetry() : _last_us(0), _sequence(0)
+{
+	for (uint8_t i = 0; i < TELEMETRY_SLOTS; i++) {
+		_slots[i] = 0;
+		_sent[i] = 0;
+	}
+}
+
+bool Telemetry::is_counter(TelemetryId_t id)
+{
+	return id != TELEMETRY_FIFO_PEAK && id != TELEMETRY_CAPTURE_PEAK_US && id != TELEMETRY_DETECT_PEAK_US &&
+	       id != TELEMETRY_SIMILARITY;
+}
+
+bool Telemetry::is_peak(TelemetryId_t id)
+{
+	return id == TELEMETRY_FIFO_PEAK || id == TELEMETRY_CAPTURE_PEAK_US || id == TELEMETRY_DETECT_PEAK_US;
+}
+
+/**
+ * @brief  Encode the block into a frame, then clear the peaks
+ *
+ * @param  frame output, FRAME_MAX bytes are always enough
+ * @param  size size of frame in bytes
+ * @param  now_us current time in microseconds, wrapping
+ * @retval length of the frame, 0 if size is too small
+ */
+size_t Telemetry::encode(uint8_t *frame, size_t size, uint32_t now_us)
+{
+	uint8_t *out = &frame[4];
+	uint32_t value, elapsed_ms = (now_us - _last_us) / 1000;
+	uint16_t crc;
+
+	if (size < FRAME_MAX) {
+		return 0;
+	}
+
+	/* The rest of a millisecond goes to the next frame */
+	out = put_varint(out, elapsed_ms);
+	_last_us += elapsed_ms * 1000;
+	for (uint8_t i = 0; i < TELEMETRY_SLOTS; i++) {
+		TelemetryId_t id = (TelemetryId_t)i;
+
+		/* A single read of the slot, an interrupt may update it */
+		value = _slots[i];
+		if (is_counter(id)) {
+			out = put_varint(out, value - _sent[i]);
+			_sent[i] = value;
+		} else {
+			out = put_varint(out, value);
+			if (is_peak(id)) {
+				_slots[i] = 0;
+			}
+		}
+	}
+
+	frame[0] = TELEMETRY_SYNC;
+	frame[1] = TELEMETRY_VERSION;
+	frame[2] = _sequence++;
+	frame[3] = (uint8_t)(out - &frame[4]);
+	crc = crc16(&frame[1], (size_t)(out - &frame[1]));
+	*out++ = (uint8_t)crc;
+	*out++ = (uint8_t)(crc >> 8);
+
+	return (size_t)(out - frame);
+}
@@ -0,0 +1,111 @@
+/**
+*******************************************************************************
+* @file   Telemetry.h
+* @brief  Runtime counters sent as compact binary frames
+*******************************************************************************
+* A fixed block of 32-bit slots, one per TelemetryId_t, updated where the
+* events happen and encoded periodically into a frame interleaved with the
+* text output of the serial port.
+*
+* Updates take no lock: each slot has a single writer, either an interrupt
+* or the event loop, and aligned 32-bit loads and stores are atomic on
+* Cortex-M. A frame read in the loop may miss an update made by an
+* interrupt meanwhile, it is then in the next frame. Peaks are cleared when
+* a frame is encoded, so only the loop may write them.
+*
+* Frame, little endian:
+*   TELEMETRY_SYNC, TELEMETRY_VERSION, sequence, payload length,
+*   payload: elapsed ms since the previous frame, then one value per slot
+*            in TelemetryId_t order, all as LEB128 varints,
+*   CRC-16/CCITT of the bytes from the version to the end of the payload.
+* Counters are sent as their increase since the previous frame, so that
+* most take one or two bytes, gauges and peaks as their value. The sync
+* byte is never part of the text output, tools/telemetry_decode splits the
+* stream back into text lines and frames.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+#define TELEMETRY_SYNC			0xA5	/* Outside of the ASCII text output */
+#define TELEMETRY_VERSION		1		/* Changes with the layout of TelemetryId_t */
+
+/* Typedefs ------------------------------------------------------------------*/
+
+/* Slots of the block, new ones go at the end with a new TELEMETRY_VERSION */
+typedef enum {
+	TELEMETRY_SAMPLES = 0,		/* Counter: samples read from the sensor */
+	TELEMETRY_WINDOWS,			/* Counter: windows captured */
+	TELEMETRY_LOSSY_WINDOWS,	/* Counter: windows discarded for a gap */
+	TELEMETRY_LOST_SAMPLES,		/* Counter: samples lost by the sensor FIFO, estimated */
+	TELEMETRY_FIFO_OVERRUNS,	/* Counter: FIFO overruns found by the driver */
+	TELEMETRY_FIFO_PEAK,		/* Peak: highest FIFO level met by a drain, samples */
+	TELEMETRY_CAPTURE_PEAK_US,	/* Peak: from the strum detected to the window processed */
+	TELEMETRY_DETECTIONS,		/* Counter: windows given to NanoEdgeAI_detect() */
+	TELEMETRY_DETECT_US,		/* Counter: time spent in NanoEdgeAI_detect() */
+	TELEMETRY_DETECT_PEAK_US,	/* Peak: longest NanoEdgeAI_detect() */
+	TELEMETRY_SIMILARITY,		/* Gauge: last similarity, % */
+	TELEMETRY_EVENTS,			/* Counter: handlers run by the event loop */
+	TELEMETRY_BUSY_US,			/* Counter: time spent in handlers */
+	TELEMETRY_RX_BYTES,			/* Counter: bytes received, serial interrupt */
+	TELEMETRY_RX_DROPPED,		/* Counter: command lines dropped, serial interrupt */
+	TELEMETRY_SLOTS
+} TelemetryId_t;
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class Telemetry
+{
+public:
+	/* Longest frame: header, varints of 5 bytes at most, CRC */
+	static const size_t FRAME_MAX = 4 + 5 * (1 + TELEMETRY_SLOTS) + 2;
+
+	Telemetry();
+
+	/* Counter increased by n */
+	void add(TelemetryId_t id, uint32_t n = 1)
+	{
+		_slots[id] += n;
+	}
+
+	/* Gauge, or counter kept elsewhere, set to its current value */
+	void set(TelemetryId_t id, uint32_t value)
+	{
+		_slots[id] = value;
+	}
+
+	/* Peak raised to value, loop context only */
+	void peak(TelemetryId_t id, uint32_t value)
+	{
+		if (value > _slots[id]) {
+			_slots[id] = value;
+		}
+	}
+
+	uint32_t value(TelemetryId_t id) const
+	{
+		return _slots[id];
+	}
+
+	size_t encode(uint8_t *frame, size_t size, uint32_t now_us);
+
+	static bool is_counter(TelemetryId_t id);
+	static bool is_peak(TelemetryId_t id);
+
+private:
+	volatile uint32_t _slots[TELEMETRY_SLOTS];
+	uint32_t _sent[TELEMETRY_SLOTS];
+	uint32_t _last_us;
+	uint8_t _sequence;
+};
+
+#endif
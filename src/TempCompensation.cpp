@@ -0,0 +1,143 @@
+/**
+*******************************************************************************
+* @file   TempCompensation.cpp
+* @brief  Accelerometer offset against temperature
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "TempCompensation.h"
+
+/* Class Implementation ------------------------------------------------------*/
+
+TempCompensation::TempCompensation()
+{
+	clear();
+}
+
+/**
+ * @brief  Forget the recorded table
+ *
+ * @param  None
+ * @retval None
+ */
+void TempCompensation::clear()
+{
+	_reference = -1;
+	for (uint8_t b = 0; b < BINS; b++) {
+		_count[b] = 0;
+		_sum_t[b] = 0.0f;
+		for (uint8_t i = 0; i < 3; i++) {
+			_sum[b][i] = 0.0f;
+		}
+	}
+}
+
+/**
+ * @brief  Record the mean acceleration of the resting instrument
+ *
+ * @param  temperature sensor temperature in degrees Celsius
+ * @param  xyz mean acceleration on x, y and z in g, without compensation
+ * @retval None
+ */
+void TempCompensation::learn(float temperature, const float *xyz)
+{
+	float position = (temperature - T_MIN) / STEP + 0.5f;
+	uint8_t bin;
+
+	if (position < 0.0f || position >= BINS) {
+		return;
+	}
+	bin = (uint8_t)position;
+	if (_reference < 0) {
+		_reference = bin;
+	}
+
+	_count[bin]++;
+	_sum_t[bin] += temperature;
+	for (uint8_t i = 0; i < 3; i++) {
+		_sum[bin][i] += xyz[i];
+	}
+}
+
+/**
+ * @brief  Offset to remove from the acceleration at a given temperature
+ *
+ * @param  temperature sensor temperature in degrees Celsius
+ * @param  offset offset on x, y and z in g
+ * @retval false if the table holds less than two bins, offset is then zero
+ */
+bool TempCompensation::get_offset(float temperature, float *offset) const
+{
+	float ref_t, ref[3], t, xyz[3];
+	float low_t = 0.0f, low[3] = { 0 }, high_t = 0.0f, high[3] = { 0 };
+	bool has_low = false, has_high = false;
+	float ratio;
+
+	for (uint8_t i = 0; i < 3; i++) {
+		offset[i] = 0.0f;
+	}
+	if (bins() < 2) {
+		return false;
+	}
+	bin_mean((uint8_t)_reference, &ref_t, ref);
+
+	/* Nearest recorded bins below and above the temperature */
+	for (uint8_t b = 0; b < BINS; b++) {
+		if (!bin_mean(b, &t, xyz)) {
+			continue;
+		}
+		if (t <= temperature) {
+			low_t = t;
+			low[0] = xyz[0]; low[1] = xyz[1]; low[2] = xyz[2];
+			has_low = true;
+		} else if (!has_high) {
+			high_t = t;
+			high[0] = xyz[0]; high[1] = xyz[1]; high[2] = xyz[2];
+			has_high = true;
+		}
+	}
+
+	/* Held at the ends of the table */
+	if (!has_low) {
+		low_t = high_t;
+		low[0] = high[0]; low[1] = high[1]; low[2] = high[2];
+	} else if (!has_high) {
+		high_t = low_t;
+		high[0] = low[0]; high[1] = low[1]; high[2] = low[2];
+	}
+
+	ratio = (high_t > low_t) ? (temperature - low_t) / (high_t - low_t) : 0.0f;
+	for (uint8_t i = 0; i < 3; i++) {
+		offset[i] = low[i] + ratio * (high[i] - low[i]) - ref[i];
+	}
+
+	return true;
+}
+
+/* Number of temperature bins recorded */
+uint8_t TempCompensation::bins() const
+{
+	uint8_t n = 0;
+
+	for (uint8_t b = 0; b < BINS; b++) {
+		if (_count[b]) {
+			n++;
+		}
+	}
+
+	return n;
+}
+
+bool TempCompensation::bin_mean(uint8_t bin, float *temperature, float *xyz) const
+{
+	if (_count[bin] == 0) {
+		return false;
+	}
+	*temperature = _sum_t[bin] / _count[bin];
+	for (uint8_t i = 0; i < 3; i++) {
+		xyz[i] = _sum[bin][i] / _count[bin];
+	}
+
+	return true;
+}
@@ -0,0 +1,48 @@
+/**
+*******************************************************************************
+* @file   TempCompensation.h
+* @brief  Accelerometer offset against temperature
+*******************************************************************************
+* During calibration the instrument rests while its temperature changes, and
+* the mean acceleration is recorded in temperature bins of STEP degrees. The
+* offset at a given temperature is the mean acceleration interpolated between
+* the nearest recorded bins, minus the mean of the first recorded bin, which
+* is the reference.
+*
+* @note   No mbed dependency, the same code runs on host tools.
+*******************************************************************************
+*/
+
+#ifndef __TEMP_COMPENSATION_H__
+#define __TEMP_COMPENSATION_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class TempCompensation
+{
+public:
+	/* Temperature range covered by the table, in degrees Celsius */
+	static const int8_t T_MIN = -20;
+	static const uint8_t STEP = 5;
+	static const uint8_t BINS = 17;
+
+	TempCompensation();
+
+	void clear(void);
+	void learn(float temperature, const float *xyz);
+	bool get_offset(float temperature, float *offset) const;
+	uint8_t bins(void) const;
+
+private:
+	bool bin_mean(uint8_t bin, float *temperature, float *xyz) const;
+
+	int8_t _reference;
+	uint32_t _count[BINS];
+	float _sum_t[BINS];
+	float _sum[BINS][3];
+};
+
+#endif
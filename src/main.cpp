@@ -8,27 +8,64 @@
 * Compiler Flags
 * -DDATA_LOGGING : data logging mode for collecting data
 * -DNEAI_LIB     : test mode with NanoEdge AI Library
+* -DBENCHMARK    : driver, DSP and inference timings in CPU cycles, with
+*                  -DNEAI_LIB also NanoEdgeAI_detect(), see BenchSuite.h
+* -DZERO_HEAP    : stop on any C++ heap allocation, all objects being static
+* -DNEAI_STREAM  : with -DNEAI_LIB, detection every STREAM_HOP samples on a
+*                  sliding window instead of triggered windows
 *
 * @note   if no compiler flag then data logging mode by default
 *******************************************************************************
 */
 
 /* Includes ------------------------------------------------------------------*/
+#include <math.h>
 #include "mbed.h"
 #include "LSM6DSLSensor.h"
+#include "StrumTrigger.h"
+#include "Acquisition.h"
+#include "EventLoop.h"
+#include "TempCompensation.h"
+#include "SensorEvents.h"
+#include "RuntimeConfig.h"
+#include "OnsetAlign.h"
+#include "Telemetry.h"
+#include "Sampler.h"
+#include "SyncClock.h"
+#include "GoertzelBank.h"
 
 // In case there is no compiler flag, we set DATA_LOGGING
-#ifndef NEAI_LIB
+#if !defined(NEAI_LIB) && !defined(BENCHMARK)
 #define DATA_LOGGING
 #endif
 
 #ifdef NEAI_LIB
 #include "NanoEdgeAI.h"
+#include "LedFeedback.h"
+#endif
+
+#ifdef NEAI_STREAM
+#ifndef NEAI_LIB
+#error "NEAI_STREAM is a mode of NEAI_LIB"
+#endif
+#include "StreamWindow.h"
+#define STREAMING				1
+#else
+#define STREAMING				0
+#endif
+
+#ifdef BENCHMARK
+#ifdef NEAI_STREAM
+#error "BENCHMARK measures the triggered windows, not NEAI_STREAM"
+#endif
+#include "LSM6DSLBus.h"
+#include "LSM6DSLSensorT.h"
+#include "BenchSuite.h"
 #endif
 
 /* Defines -------------------------------------------------------------------*/
 
-#ifdef DATA_LOGGING
+#ifndef NEAI_LIB
 #define DATA_INPUT_USER 		1024
 #define AXIS_NUMBER 			3
 #else
@@ -39,22 +76,90 @@
 #define THRESH					1.4
 #define NOISE					0.15
 #define THRESH_SIMILARITY 		90
+#define ODR						3330.0f	/* Accelerometer output data rate in Hz */
+#define FULL_SCALE				4.0f	/* Accelerometer full scale in g */
+
+#define SENSOR_INT1				NC		/* Pin wired to the LSM6DSL INT1, NC to poll the FIFO */
+#define WATERMARK_SAMPLES		64		/* FIFO level raising INT1 */
+#define FIFO_HW_TRIGGER			1		/* With INT1 wired, 1: strums detected by the sensor, 0: by StrumTrigger */
+#define WAKE_UP_THS				2		/* Sensor strum detection threshold, 62.5 mg units at 4 g */
+#define PRETRIGGER_SAMPLES		32		/* History kept before a strum detected by the sensor */
+#define DRAIN_PERIOD_MS			20		/* FIFO polling period, 682 samples last 200 ms at 3330 Hz */
+#define SPI_MAX_HZ				10000000	/* LSM6DSL SPI clock limit */
+#define EVENT_QUEUE_EVENTS		32
+#define COMPENSATION_PERIOD_MS	1000	/* Temperature reading period */
+#define SAMPLER_TICK_MS			100		/* Resolution of the periods of the slow sensors */
+#define SAMPLER_DEPTH			16		/* Samples kept per slow sensor */
+#define COMPENSATION_IN_SENSOR	1		/* 1: offset removed by the sensor, 0: by Acquisition */
+#define OFFSET_STEP_G			(0.5f / 1024)	/* Offset change applied, half an LSB of the sensor user offset */
+#define WINDOW_RAM_BUDGET		(16 * 1024)	/* Bytes available for the signal window */
+#define COMMAND_LENGTH			64		/* Longest line received on the serial port */
+#define ALIGN_PRE				24		/* Samples kept before the attack peak */
+#define ALIGN_SEARCH			64		/* Latest window start after the capture start */
+#define STREAM_HOP				256		/* Samples between two detections, NEAI_STREAM */
+#define STREAM_RAM_BUDGET		(24 * 1024)	/* Bytes available for the sliding window */
+#define TELEMETRY_PERIOD_MS		1000	/* Telemetry frame period, about 30 bytes each */
+#define DEN_MARKER				0		/* 1: a footswitch pulling INT2 (DEN) low marks windows */
+#define SYNC_EDGE				0		/* 1: a sync pulse shared with other recorders on INT2 (DEN) times windows */
+#define SYNC_PERIOD_US			1000000	/* Period of the sync pulse */
+#define POSE_GATE				0		/* 1: strums ignored out of the playing pose, with SENSOR_TRIGGER */
+#define POSE_THRESHOLD			LSM6DSL_ACC_GYRO_SIXD_THS_60_degree	/* Tilt from vertical of an axis still pointing up or down */
+#define POSE_4D					0		/* 1: positions of the X and Y axes only */
+#define PLAYING_POSE			0x00	/* D6D_SRC position when playing, 0: learned by POSE SET */
+#define POSE_COUNT_SKIPS		0		/* 1: strums counted while gated, each one waking the core */
+#define NOTE_BANK				0		/* 1: notes of the fretboard measured in each window */
+#define NOTE_FRETS				12		/* Frets of each string measured, 22 notes from C4 to A5 */
+#define NOTE_AXIS				2		/* Axis measured, z being normal to the top plate */
+#define NOTE_RATIO				0.25f	/* Share of the strongest note reached by a note that sounded */
+#define NOTE_FLOOR				0.002f	/* Amplitude in g below which no note sounded */
+#define NOTE_FEATURES			0		/* 1: the note amplitudes are logged instead of the signal */
+
+/* Strums detected by the sensor, holding the history in its FIFO */
+#define SENSOR_TRIGGER			(SENSOR_INT1 != NC && FIFO_HW_TRIGGER && !STREAMING)
+
+#ifdef NEAI_LIB
+#define FIXED_WINDOW			true	/* The model was generated for DATA_INPUT_USER samples */
+#else
+#define FIXED_WINDOW			false
+#endif
+
+/* Frames would corrupt the logged data set, TELEMETRY ON sends them anyway */
+#ifdef DATA_LOGGING
+#define TELEMETRY_AT_START		false
+#else
+#define TELEMETRY_AT_START		true
+#endif
 
 /* Objects -------------------------------------------------------------------*/
 
-Serial pc (USBTX, USBRX);
-SPI spi(A6, A5, A4); // mosi, miso, sclk
+RawSerial pc (USBTX, USBRX);
+DevSPI spi(A6, A5, A4); // mosi, miso, sclk
 DigitalOut cs(A3, 0);
 DigitalOut d1(D2, 0); // D2 = blue
 DigitalOut d2(D3, 0); // D3 = red
 DigitalOut d3(D9, 0); // D9 = green
-LSM6DSLSensor *lsm6dsl = new LSM6DSLSensor(&spi, A3);
+LSM6DSLSensor lsm6dsl(&spi, A3, SENSOR_INT1);
+unsigned char queue_buffer[EVENT_QUEUE_EVENTS * EVENTS_EVENT_SIZE];
+EventQueue queue(sizeof(queue_buffer), queue_buffer);
+EventLoop loop(&queue);
+StrumTrigger trigger(MINI, THRESH, NOISE);
+TempCompensation compensation;
+SensorEvents sensor_events(&lsm6dsl, &loop);
+Sampler sampler(SAMPLER_TICK_MS);
+SyncClock sync_clock(ODR, SYNC_PERIOD_US);
+GoertzelBank note_bank(ODR, NOTE_FRETS);
+#ifdef NEAI_LIB
+LedFeedback leds(&queue);
+#endif
 
 /********************************* Prototypes *********************************/
 void init(void);
 #ifdef DATA_LOGGING
 void data_logging_mode(void);
 #endif
+#ifdef BENCHMARK
+void benchmark_mode(void);
+#endif
 #ifdef NEAI_LIB
 void neai_library_test_mode(void);
 void led_anomaly(void);
@@ -62,13 +167,86 @@ void led_nominal(void);
 void led_learning_over(void);
 void led_learned(void);
 #endif
-void get_values(void);
-void fill_acc_array(void);
-bool strum_trigger(void);
+void event_loop_start(void);
+void sensor_event(LSM6DSL_Event_Status_t status);
+void fifo_drain(void);
+void window_complete(void);
+void serial_rx_irq(void);
+void serial_command(void);
+void temperature_update(void);
+void apply_offset(const float *offset);
+void write_offset(void);
+void next_window(void);
+void apply_config(void);
+void telemetry_emit(void);
+void sampler_tick(void);
+void sampler_add(void);
+void lsm6dsl_bus_lock(void *context);
+void lsm6dsl_bus_unlock(void *context);
+void pose_update(void);
+void pose_skip(void);
 
 /* Variables -----------------------------------------------------------------*/
-int32_t raw_values[AXIS_NUMBER], last_raw_values[AXIS_NUMBER] = {0};
-float values[AXIS_NUMBER], data_user[AXIS_NUMBER * DATA_INPUT_USER] = {0};
+float sensitivity = 0;
+int spi_hz = 1000000;
+MBED_STATIC_ASSERT(DATA_INPUT_USER <= 0xFFFF, "Acquisition counts window samples on 16 bits");
+MBED_STATIC_ASSERT(3 * WATERMARK_SAMPLES < 2048, "FIFO watermark beyond the 2048 words of the FIFO");
+MBED_STATIC_ASSERT(DRAIN_PERIOD_MS < 200, "FIFO polled slower than it fills at 3330 Hz");
+MBED_STATIC_ASSERT(!(DEN_MARKER && SYNC_EDGE), "DEN carries either the footswitch or the sync pulse");
+MBED_STATIC_ASSERT(!POSE_GATE || SENSOR_TRIGGER, "The pose gate holds back strums detected by the sensor");
+MBED_STATIC_ASSERT(!NOTE_BANK || !STREAMING, "The note bank follows triggered windows");
+MBED_STATIC_ASSERT(!NOTE_FEATURES || NOTE_BANK, "Note features come from the note bank");
+MBED_STATIC_ASSERT(GOERTZEL_NOTES(NOTE_FRETS) <= GOERTZEL_NOTES_MAX, "More notes than the bank holds");
+#ifndef NEAI_STREAM
+/* Captures go past the window so that it can be aligned on the attack peak */
+float data_user[AXIS_NUMBER * (DATA_INPUT_USER + ALIGN_SEARCH + 1)] = {0};
+MBED_STATIC_ASSERT(sizeof(data_user) <= WINDOW_RAM_BUDGET, "Signal window over its RAM budget");
+MBED_STATIC_ASSERT(ALIGN_PRE <= PRETRIGGER_SAMPLES, "Sensor triggered captures start PRETRIGGER_SAMPLES before the strum");
+Acquisition<LSM6DSLSensor> acquisition(&lsm6dsl, &trigger, data_user, DATA_INPUT_USER + ALIGN_SEARCH + 1);
+OnsetAligner aligner(ALIGN_PRE, ALIGN_SEARCH);
+#else
+/* The sliding window replaces the triggered one, the model reads it in place */
+float stream_buffer[AXIS_NUMBER * STREAM_BUFFER_SAMPLES(DATA_INPUT_USER, STREAM_HOP)];
+MBED_STATIC_ASSERT(sizeof(stream_buffer) <= STREAM_RAM_BUDGET, "Sliding window over its RAM budget");
+MBED_STATIC_ASSERT(DATA_INPUT_USER % STREAM_HOP == 0, "STREAM_HOP must divide the window");
+StreamWindow stream(stream_buffer, DATA_INPUT_USER, STREAM_HOP);
+Acquisition<LSM6DSLSensor> acquisition(&lsm6dsl, &trigger, NULL, 0);
+uint32_t stream_hops = 0;
+#endif
+const RuntimeConfig default_config = { MINI, THRESH, NOISE, DATA_INPUT_USER, ODR, FULL_SCALE };
+ConfigStage config(default_config, DATA_INPUT_USER, FIXED_WINDOW);
+char rx_line[COMMAND_LENGTH], command[COMMAND_LENGTH];
+uint8_t rx_length = 0;
+MBED_STATIC_ASSERT(COMMAND_LENGTH <= 0xFF, "Serial line length counted on 8 bits");
+volatile bool command_pending = false;
+float temperature = 0;
+float offset[3] = {0};
+float staged_offset[3] = {0};
+bool offset_staged = false;
+bool calibrating = false;
+uint32_t fifo_overruns = 0;
+Telemetry telemetry;
+uint8_t telemetry_frame[Telemetry::FRAME_MAX];
+bool telemetry_on = TELEMETRY_AT_START;
+uint32_t capture_start_us = 0;
+bool capture_timed = false;
+uint8_t playing_pose = PLAYING_POSE;
+uint8_t pose = 0;
+bool gated = false;
+uint32_t gate_closed_us = 0;
+uint32_t gated_from_us = 0;
+uint32_t gated_us = 0;
+uint32_t skipped = 0;
+uint32_t gate_skipped = 0;
+uint32_t skip_us = 0;
+int drain_every = 0;
+SamplerSample_t temperature_ring[SAMPLER_DEPTH];
+uint8_t temperature_channel = SAMPLER_NONE;
+#ifdef NEAI_LIB
+uint16_t learn_cpt = 0;
+uint32_t detect_us = 0;
+uint32_t detect_count = 0;
+#endif
 
 /********************************* Main *********************************/
 int main() 
@@ -81,11 +259,16 @@ int main()
 		/* Compiler flag: -DDATA_LOGGING */
 		data_logging_mode();
 #endif
-#ifdef NEAI_LIB
+#if defined(NEAI_LIB) && !defined(BENCHMARK)
 		/* Smart sensor mode with NanoEdge AI Library*/
 		/* Compiler flag -DNEAI_LIB */
 		neai_library_test_mode();
 #endif
+#ifdef BENCHMARK
+		/* Driver timings */
+		/* Compiler flag -DBENCHMARK */
+		benchmark_mode();
+#endif
 }
 
 /********************************* Functions *********************************/
@@ -93,9 +276,42 @@ void init ()
 {
     pc.baud(115200);
 	wait_ms(100);
-    lsm6dsl->set_x_odr(3330.0f);
-	lsm6dsl->set_x_fs(4.0f);
-	lsm6dsl->enable_x();
+	/* One step below the fastest SPI clock verified on the sensor */
+	lsm6dsl.tune_spi_frequency(SPI_MAX_HZ, &spi_hz);
+#ifndef DATA_LOGGING
+	pc.printf("SPI clock %d Hz\n", spi_hz);
+	/* Driver traces would corrupt the logged data */
+	lsm6dsl.set_log(&pc);
+#endif
+	lsm6dsl.init(NULL);
+    lsm6dsl.set_x_odr(ODR);
+	lsm6dsl.set_x_fs(FULL_SCALE);
+	lsm6dsl.enable_x();
+	lsm6dsl.get_x_sensitivity(&sensitivity);
+	acquisition.set_sensitivity(sensitivity);
+#ifndef NEAI_STREAM
+	/* The rest of data_user is the alignment margin */
+	acquisition.set_window_samples(DATA_INPUT_USER);
+	acquisition.set_aligner(&aligner);
+#endif
+	if (DEN_MARKER) {
+		/* Stamped in the LSB of x, decoded by the acquisition */
+		lsm6dsl.enable_den_stamping(LSM6DSL_ACC_GYRO_DEN_X, LSM6DSL_ACC_GYRO_DEN_LOW);
+		acquisition.set_marker(0);
+	} else if (SYNC_EDGE) {
+		/* Stamped the same way, the timestamp counter places the edges in time */
+		lsm6dsl.enable_den_stamping(LSM6DSL_ACC_GYRO_DEN_X, LSM6DSL_ACC_GYRO_DEN_HIGH);
+		lsm6dsl.enable_timestamp();
+		acquisition.set_marker(0);
+		acquisition.set_sync(&sync_clock);
+	}
+	if (NOTE_BANK) {
+		/* Measured as the samples arrive, ready with the window */
+		acquisition.set_bank(&note_bank, NOTE_AXIS);
+	}
+	/* Samples are buffered by the sensor and read back in bursts of 16-bit frames */
+	lsm6dsl.set_fifo_word_frames(true);
+	lsm6dsl.enable_x_fifo();
 	wait_ms(100);
 #ifdef NEAI_LIB
 	NanoEdgeAI_initialize();
@@ -111,13 +327,10 @@ void init ()
  */
 void data_logging_mode()
 {
-	while(1) {
-		// Here we are polling in order to detect strumming vibration.
-		// Depending on your setup and instrument, edit the trigger function as needed. 
-		if (strum_trigger()) {
-			fill_acc_array();
-		}
-	}
+	// Strums are detected on the samples drained from the sensor FIFO.
+	// Depending on your setup and instrument, edit MINI, THRESH and NOISE as needed,
+	// or change them at runtime with the SET command, see serial_command().
+	event_loop_start();
 }
 #endif
 
@@ -130,162 +343,975 @@ void data_logging_mode()
  */
 void neai_library_test_mode()
 {
-	uint16_t learn_cpt = 0;
-	uint16_t similarity = 0;
-	do {
-		// Here we are polling in order to detect strumming vibration.
-		// Depending on your setup and instrument, edit the trigger function as needed. 
-		if (strum_trigger()) {
-			fill_acc_array();
-			NanoEdgeAI_learn(data_user);
-			led_learned();
-			pc.printf("%d\n", (int)(learn_cpt * 100) / LEARNING_NUMBER);
-			learn_cpt++;
+	// LEARNING_NUMBER windows are learned, then the following ones are
+	// checked, see window_complete().
+#ifdef NEAI_STREAM
+	// Windows slide by STREAM_HOP samples over the continuous stream.
+	acquisition.set_stream(&stream);
+#endif
+	event_loop_start();
+}
+#endif
+
+/**
+ * @brief  Dispatch sensor, timer and UART events, sleeping in between
+ *
+ * @param  None
+ * @retval None
+ */
+void event_loop_start()
+{
+	/* With INT1 wired, the sensor either holds the history of the FIFO
+	   until it detects a strum, the FIFO being drained from then to the
+	   end of the window only, or raises its watermark interrupt. The
+	   FIFO is drained periodically otherwise. */
+	if (SENSOR_TRIGGER) {
+		lsm6dsl.enable_latched_irq();
+		lsm6dsl.enable_fifo_trigger(WAKE_UP_THS, LSM6DSL_INT1_PIN);
+		if (POSE_GATE) {
+			/* Position changes share INT1, at the rates of the acquisition */
+			lsm6dsl.enable_6d_orientation_irq(POSE_THRESHOLD, POSE_4D, LSM6DSL_INT1_PIN);
+			pose_update();
 		}
-	} while (learn_cpt < LEARNING_NUMBER);
+		sensor_events.subscribe(callback(&sensor_event));
+		sensor_events.attach(LSM6DSL_INT1_PIN);
+	} else if (SENSOR_INT1 != NC) {
+		lsm6dsl.set_fifo_watermark(WATERMARK_SAMPLES);
+		lsm6dsl.enable_fifo_watermark_irq(LSM6DSL_INT1_PIN);
+		lsm6dsl.enable_fifo_overrun_irq(LSM6DSL_INT1_PIN);
+		lsm6dsl.enable_latched_irq();
+		sensor_events.subscribe(callback(&sensor_event));
+		sensor_events.attach(LSM6DSL_INT1_PIN);
+	} else {
+		loop.post_every(DRAIN_PERIOD_MS, callback(&fifo_drain));
+	}
+	sampler_add();
+	loop.post_every(SAMPLER_TICK_MS, callback(&sampler_tick));
+	loop.post_every(TELEMETRY_PERIOD_MS, callback(&telemetry_emit));
+	pc.attach(&serial_rx_irq, RawSerial::RxIrq);
+
+	loop.reset_stats();
+	loop.run();
+}
 
-	led_learning_over();
+void sensor_event(LSM6DSL_Event_Status_t status)
+{
+	size_t held = 0;
 
-	while(1) {
-		if (strum_trigger()) {
-			fill_acc_array();
-			similarity = NanoEdgeAI_detect(data_user);
-			pc.printf("%d\n", similarity);
-
-			if (similarity < THRESH_SIMILARITY) {
-				led_anomaly();
-			} else {
-				led_nominal();
-			}
+	if (status.D6DOrientationStatus) {
+		pose_update();
+	}
+	if (status.WakeUpStatus && !acquisition.capturing() && gated) {
+		pose_skip();
+	} else if (status.WakeUpStatus && !acquisition.capturing()) {
+		/* The FIFO holds the samples up to the strum: resume the
+		   acquisition first, then skip the oldest of them */
+		lsm6dsl.release_fifo_trigger();
+		lsm6dsl.get_fifo_samples(&held);
+		acquisition.trigger(held > PRETRIGGER_SAMPLES ? held - PRETRIGGER_SAMPLES : 0);
+		capture_start_us = us_ticker_read();
+		capture_timed = true;
+		if (!drain_every) {
+			drain_every = loop.post_every(DRAIN_PERIOD_MS, callback(&fifo_drain));
 		}
-	}	
-}
-#endif
-
-bool strum_trigger () 
-{
-	/* Continuously monitor the average x, y or z accelerations. 
-	   If 2 consecutive mini-buffers differ by more than a threshold %,
-	   Then the trigger returns True, otherwise False. */
-
-	float ref_sum_x = 0.0, ref_sum_y = 0.0, ref_sum_z = 0.0;
-	float new_sum_x = 0.0, new_sum_y = 0.0, new_sum_z = 0.0;
-	float ref_avg_x = 0.0, ref_avg_y = 0.0, ref_avg_z = 0.0;
-	float new_avg_x = 0.0, new_avg_y = 0.0, new_avg_z = 0.0;
-
-	// First we get some values and create a sum
-	// This will be our reference
-	for (uint16_t i = 0; i < MINI ; i++) {
-		get_values();
-		ref_sum_x += values[0];
-		ref_sum_y += values[1];
-		ref_sum_z += values[2];
-	}
-
-	// Next, we repeat the operation 
-	for (uint16_t i = 0; i < MINI ; i++) {
-		get_values();
-		new_sum_x += values[0];
-		new_sum_y += values[1];
-		new_sum_z += values[2];
-	}
-	
-	// We average both samples
-	new_avg_x = abs(new_sum_x/MINI);
-	new_avg_y = abs(new_sum_y/MINI);
-	new_avg_z = abs(new_sum_z/MINI);
-	ref_avg_x = abs(ref_sum_x/MINI);
-	ref_avg_y = abs(ref_sum_y/MINI);
-	ref_avg_z = abs(ref_sum_z/MINI);
-	
-	// If we are in a really small range, get out, it might just be noise
-	if (new_avg_x > NOISE && new_avg_y > NOISE && new_avg_z > NOISE && new_avg_x > NOISE && new_avg_y > NOISE && new_avg_z > NOISE) {
-		// Then we compare our new sample with the reference one
-		if (new_avg_x > ref_avg_x*THRESH || new_avg_y > ref_avg_y*THRESH || new_avg_z > ref_avg_z*THRESH) {
-    		return true; 
-		} else {
-    		return false;
+		fifo_drain();
+	}
+	if (status.FifoOverrunStatus) {
+		fifo_overruns++;
+	}
+	if (status.FifoWatermarkStatus || status.FifoOverrunStatus) {
+		fifo_drain();
+	}
+}
+
+void fifo_drain()
+{
+	uint32_t start = us_ticker_read();
+
+	if (acquisition.drain()) {
+		window_complete();
+		if (capture_timed || !STREAMING) {
+			/* A window may start and end within one drain */
+			telemetry.peak(TELEMETRY_CAPTURE_PEAK_US, us_ticker_read() - (capture_timed ? capture_start_us : start));
+		}
+		capture_timed = false;
+		next_window();
+		/* The FIFO may already hold the next hop */
+		if (STREAMING) {
+			loop.post(callback(&fifo_drain));
 		}
+	} else if (acquisition.capturing() && !capture_timed) {
+		/* The strum was found among the samples of this drain */
+		capture_start_us = start;
+		capture_timed = true;
+	}
+}
+
+/**
+ * @brief  Close the gate out of the playing pose, open it back in it
+ *
+ * @param  None
+ * @retval None
+ * @note   Closed, the wake-up event is taken off INT1 and the drain timer
+ *         stopped: no strum wakes the core, only sampler_tick() and
+ *         telemetry_emit() still run on their timers, calibration needing
+ *         the temperature at rest. With POSE_COUNT_SKIPS the wake-up stays on
+ *         INT1 and the strums are only counted, see pose_skip(). A capture
+ *         under way when the instrument is put down is dropped.
+ */
+void pose_update()
+{
+	uint8_t position = 0;
+	uint32_t now = us_ticker_read();
+	bool closed;
+
+	/* Between two positions, the gate stays as it is */
+	if (lsm6dsl.get_6d_position(&position) != 0 || position == 0) {
+		return;
+	}
+	pose = position;
+	closed = (playing_pose != 0 && position != playing_pose);
+	if (closed == gated) {
+		return;
+	}
+	gated = closed;
+	capture_timed = false;
+	if (gated) {
+		gate_closed_us = now;
+		gated_from_us = now;
+		gate_skipped = 0;
+		if (!POSE_COUNT_SKIPS) {
+			lsm6dsl.disable_fifo_trigger_irq();
+		}
+		pc.printf("GATE closed position=0x%02X\n", (unsigned)position);
 	} else {
-		return false;
+		gated_us += now - gated_from_us;
+		if (!POSE_COUNT_SKIPS) {
+			lsm6dsl.enable_fifo_trigger_irq(LSM6DSL_INT1_PIN);
+		}
+		pc.printf("GATE open closed_ms=%lu", (unsigned long)((now - gate_closed_us) / 1000));
+		if (POSE_COUNT_SKIPS) {
+			pc.printf(" skipped=%lu", (unsigned long)gate_skipped);
+		}
+		pc.printf("\n");
 	}
+	/* Closing drops the capture, opening the history of the skipped strums */
+	next_window();
 }
 
-void fill_acc_array ()
+/**
+ * @brief  Count a strum detected by the sensor while the gate is closed,
+ *         with POSE_COUNT_SKIPS
+ *
+ * @param  None
+ * @retval None
+ * @note   The wake-up event repeats while the strum lasts, those within a
+ *         window of the first one belong to the same strum.
+ */
+void pose_skip()
 {
-	/* Fill a buffer with accelerometer values 
-	   Print output to serial port */
+	const RuntimeConfig &active = config.active();
+	uint32_t now = us_ticker_read();
 
-	for (uint16_t i = 0; i < DATA_INPUT_USER ; i++) {
-		get_values();
-		data_user[AXIS_NUMBER * i] = values[0];
-		data_user[(AXIS_NUMBER * i) + 1] = values[1];
-		data_user[(AXIS_NUMBER * i) + 2] = values[2];
+	if (gate_skipped > 0 && now - skip_us < (uint32_t)(active.window * 1e6f / active.odr)) {
+		return;
 	}
-	/* Print data in the serial */
+	skip_us = now;
+	gate_skipped++;
+	skipped++;
+}
+
+/**
+ * @brief  Apply the staged configuration, if any, and wait for the next
+ *         strum on fresh data
+ *
+ * @param  None
+ * @retval None
+ */
+void next_window()
+{
+	if (config.pending()) {
+		apply_config();
+	}
+	if (offset_staged) {
+		write_offset();
+	}
+	acquisition.rearm();
+	if (SENSOR_TRIGGER) {
+		lsm6dsl.arm_fifo_trigger();
+		/* Nothing to drain until the next strum */
+		loop.cancel(drain_every);
+		drain_every = 0;
+	}
+}
+
+/**
+ * @brief  Apply the staged configuration, no window being captured
+ *
+ * @param  None
+ * @retval None
+ * @note   Output data rate and full scale go to the sensor in a single
+ *         register write, the FIFO is emptied by the following rearm.
+ */
+void apply_config()
+{
+	const RuntimeConfig &staged = config.staged();
+	uint8_t wake_up_ths;
+
+	if (config.sensor_changed()) {
+		if (lsm6dsl.set_x_odr_fs(staged.odr, staged.fs) != 0) {
+			/* Left staged, tried again after the next window */
+			pc.printf("SET failed\n");
+			return;
+		}
+		lsm6dsl.get_x_sensitivity(&sensitivity);
+		acquisition.set_sensitivity(sensitivity);
+		if (SYNC_EDGE) {
+			sync_clock.set_odr(staged.odr);
+		}
+		note_bank.set_odr(staged.odr);
+#ifdef NEAI_STREAM
+		/* No window mixing samples of both rates or scales */
+		lsm6dsl.reset_fifo();
+		acquisition.set_stream(&stream);
+#endif
+		if (SENSOR_TRIGGER) {
+			/* Same threshold in g whatever the full scale */
+			wake_up_ths = (uint8_t)(WAKE_UP_THS * FULL_SCALE / staged.fs + 0.5f);
+			lsm6dsl.set_wake_up_threshold(wake_up_ths ? wake_up_ths : 1);
+		}
+	}
+	trigger.configure(staged.mini, staged.thresh, staged.noise);
+	acquisition.set_window_samples(staged.window);
+	config.commit();
+	pc.printf("SET applied\n");
+}
+
+/**
+ * @brief  Process a captured window
+ *
+ * @param  None
+ * @retval None
+ */
+void window_complete()
+{
+	SyncTime_t sync_time;
+	uint32_t sounded;
+	char note[5];
+
+	/* A window with a gap would poison the logged data set and the model */
+	if (acquisition.window_lost_samples() > 0) {
+		telemetry.add(TELEMETRY_LOSSY_WINDOWS);
+		return;
+	}
+	telemetry.add(TELEMETRY_WINDOWS);
+	/* Label of the window that follows, the footswitch being down during it */
+	if (DEN_MARKER && acquisition.window_marked() > 0) {
+		pc.printf("MARK samples=%u\n", (unsigned)acquisition.window_marked());
+	}
+	/* Time of the first sample of the window against the shared sync pulse */
+	if (SYNC_EDGE && acquisition.window_time(&sync_time)) {
+		pc.printf("SYNC edge=%lu offset_us=%.1f sample_us=%.4f drift_ppm=%.1f\n", (unsigned long)sync_time.edge,
+		          sync_time.offset_us, sync_time.sample_us, sync_time.drift_ppm);
+	}
+	/* Notes that sounded, measured while the window was captured */
+	if (NOTE_BANK) {
+		sounded = note_bank.sounded(NOTE_RATIO, NOTE_FLOOR);
+		pc.printf("NOTES");
+		for (uint8_t k = 0; k < note_bank.notes(); k++) {
+			if (sounded & ((uint32_t)1 << k)) {
+				GoertzelBank::name(note_bank.note(k), note);
+				pc.printf(" %s", note);
+			}
+		}
+		pc.printf("\n");
+	}
+
 #ifdef DATA_LOGGING
-	for (uint16_t i = 0; i < DATA_INPUT_USER * AXIS_NUMBER; i++) {
-		pc.printf("%.3f ", data_user[i]);
+	/* Print data in the serial */
+	const float *data_window = acquisition.window();
+
+	if (NOTE_FEATURES) {
+		/* A data set of note amplitudes, one line of notes() values per window */
+		for (uint8_t k = 0; k < note_bank.notes(); k++) {
+			pc.printf("%.5f ", note_bank.amplitudes()[k]);
+		}
+	} else {
+		for (uint16_t i = 0; i < acquisition.window_samples() * AXIS_NUMBER; i++) {
+			pc.printf("%.3f ", data_window[i]);
+		}
 	}
 	pc.printf("\n");
 #endif
+#ifdef NEAI_LIB
+	uint16_t similarity = 0;
+	uint32_t start;
+#ifdef NEAI_STREAM
+	/* Read in place, the library does not write its input */
+	float *data_window = (float *)stream.window();
+
+	stream_hops++;
+#else
+	/* Aligned within data_user, the library does not write its input */
+	float *data_window = (float *)acquisition.window();
+#endif
+
+	if (learn_cpt < LEARNING_NUMBER) {
+		NanoEdgeAI_learn(data_window);
+		led_learned();
+		pc.printf("%d\n", (int)(learn_cpt * 100) / LEARNING_NUMBER);
+		learn_cpt++;
+		if (learn_cpt == LEARNING_NUMBER) {
+			led_learning_over();
+		}
+		return;
+	}
+
+	start = us_ticker_read();
+	similarity = NanoEdgeAI_detect(data_window);
+	start = us_ticker_read() - start;
+	detect_us += start;
+	detect_count++;
+	telemetry.add(TELEMETRY_DETECTIONS);
+	telemetry.add(TELEMETRY_DETECT_US, start);
+	telemetry.peak(TELEMETRY_DETECT_PEAK_US, start);
+	telemetry.set(TELEMETRY_SIMILARITY, similarity);
+	pc.printf("%d\n", similarity);
+
+	if (similarity < THRESH_SIMILARITY) {
+		led_anomaly();
+	} else {
+		led_nominal();
+	}
+#endif
+}
+
+void serial_rx_irq()
+{
+	/* Characters are buffered here, complete lines are handled by the loop */
+	while (pc.readable()) {
+		char c = pc.getc();
+		telemetry.add(TELEMETRY_RX_BYTES);
+		if (c == '\r' || c == '\n') {
+			/* A line arriving while the previous one is pending is dropped */
+			if (rx_length > 0 && !command_pending) {
+				memcpy(command, rx_line, rx_length);
+				command[rx_length] = '\0';
+				command_pending = true;
+				loop.post(callback(&serial_command));
+			} else if (rx_length > 0) {
+				telemetry.add(TELEMETRY_RX_DROPPED);
+			}
+			rx_length = 0;
+		} else if (rx_length < sizeof(rx_line) - 1) {
+			rx_line[rx_length++] = c;
+		}
+	}
+}
+
+void lsm6dsl_bus_lock(void *context)
+{
+	((LSM6DSLSensor *)context)->bus_lock();
+}
+
+void lsm6dsl_bus_unlock(void *context)
+{
+	((LSM6DSLSensor *)context)->bus_unlock();
+}
+
+/**
+ * @brief  Register the slow sensors read by the sampler, see Sampler.h
+ *
+ * @param  None
+ * @retval None
+ * @note   Sensors sharing the SPI bus of the LSM6DSL are registered on
+ *         spi_bus, they are then read within one lock per tick.
+ */
+void sampler_add()
+{
+	static const SamplerBus_t spi_hooks = { lsm6dsl_bus_lock, lsm6dsl_bus_unlock, &lsm6dsl };
+	uint8_t spi_bus = sampler.add_bus(&spi_hooks);
+
+	temperature_channel = sampler.add(&lsm6dsl, spi_bus, COMPENSATION_PERIOD_MS, temperature_ring,
+	                                  SAMPLER_DEPTH);
+}
+
+/**
+ * @brief  Read the slow sensors due, then update what depends on them
+ *
+ * @param  None
+ * @retval None
+ */
+void sampler_tick()
+{
+	uint32_t sampled = sampler.tick();
+
+	if (temperature_channel != SAMPLER_NONE && (sampled & ((uint32_t)1 << temperature_channel))) {
+		temperature_update();
+	}
+}
+
+/**
+ * @brief  Record the offset against temperature during calibration, apply
+ *         it otherwise
+ *
+ * @param  None
+ * @retval None
+ */
+void temperature_update()
+{
+	float mean[3], new_offset[3];
+	bool resting;
+	SamplerSample_t sample;
+
+	if (!sampler.get(temperature_channel, 0, &sample)) {
+		return;
+	}
+	temperature = sample.value[0];
+	/* Read the mean every period to restart its sums */
+	resting = acquisition.get_mean(mean);
+	if (!resting && calibrating) {
+		/* No sample read outside windows when the sensor detects strums */
+		int32_t axes[3] = { 0, 0, 0 };
+
+		resting = (lsm6dsl.get_x_axes(axes) == 0);
+		for (uint8_t i = 0; i < 3; i++) {
+			mean[i] = axes[i] / 1000.0f;
+		}
+	}
+
+	if (calibrating) {
+		if (resting) {
+			compensation.learn(temperature, mean);
+		}
+	} else if (compensation.get_offset(temperature, new_offset)) {
+		apply_offset(new_offset);
+	}
+}
+
+/**
+ * @brief  Stage an offset to remove from the acceleration, from the next
+ *         window on
+ *
+ * @param  new_offset offset on x, y and z in g
+ * @retval None
+ * @note   Changes below OFFSET_STEP_G of the offset removed are dropped, a
+ *         new temperature sample most often leaving it as it is.
+ */
+void apply_offset(const float *new_offset)
+{
+	bool changed = false;
+
+	for (uint8_t i = 0; i < 3; i++) {
+		staged_offset[i] = new_offset[i];
+		changed = changed || fabsf(new_offset[i] - offset[i]) >= OFFSET_STEP_G;
+	}
+	offset_staged = changed;
+}
+
+/**
+ * @brief  Remove the staged offset from the acceleration, no window being
+ *         captured, so that no window holds a step
+ *
+ * @param  None
+ * @retval None
+ */
+void write_offset()
+{
+#if COMPENSATION_IN_SENSOR
+	float offset_mg[3];
+#endif
+
+	for (uint8_t i = 0; i < 3; i++) {
+		offset[i] = staged_offset[i];
+	}
+	offset_staged = false;
+#if COMPENSATION_IN_SENSOR
+	/* No cost for the MCU, the sensor removes it from the FIFO data */
+	for (uint8_t i = 0; i < 3; i++) {
+		offset_mg[i] = offset[i] * 1000;
+	}
+	lsm6dsl.set_x_user_offset(offset_mg);
+#else
+	acquisition.set_offset(offset);
+#endif
+}
+
+/**
+ * @brief  Handle a line received on the serial port
+ *         STATS     : share of time spent in event handlers since the last
+ *                     STATS, the SPI clock, FIFO losses and discarded windows,
+ *                     the detection time and, in NEAI_STREAM mode, the hop
+ *                     rate achieved against the one of the sensor, with
+ *                     POSE_GATE the time gated and, with
+ *                     POSE_COUNT_SKIPS, the strums skipped
+ *         CAL START : clear the offset and record it against temperature,
+ *                     the instrument resting
+ *         CAL STOP  : end the recording, the offset follows the temperature
+ *         TEMP      : temperature and offset applied
+ *         SENSORS   : last sample of each slow sensor, see sampler_add()
+ *         SET K=V.. : stage MINI, THRESH, NOISE, WINDOW, ODR or FS, applied
+ *                     together between windows, e.g. SET THRESH=1.6 ODR=1660
+ *         GET       : active configuration, and the staged one if pending
+ *         TELEMETRY ON|OFF : start or stop the telemetry frames, see
+ *                     telemetry_emit()
+ *         POSE      : position of the sensor, playing pose and gate, with
+ *                     POSE_GATE
+ *         POSE SET  : the current position becomes the playing pose
+ *
+ * @param  None
+ * @retval None
+ */
+void serial_command()
+{
+	EventLoopStats stats;
+	LSM6DSL_Fifo_Stats_t fifo_stats;
+	char line[COMMAND_LENGTH + 32];
+	uint8_t position = 0;
+
+	if (strcmp(command, "STATS") == 0) {
+		loop.get_stats(&stats);
+		lsm6dsl.get_fifo_stats(&fifo_stats);
+		pc.printf("STATS events=%lu busy_us=%lu elapsed_us=%lu duty=%lu%% spi_hz=%d sensor_irqs=%lu overrun_irqs=%lu\n",
+		          (unsigned long)stats.events, (unsigned long)stats.busy_us, (unsigned long)stats.elapsed_us,
+		          (unsigned long)(stats.elapsed_us ? (uint64_t)stats.busy_us * 100 / stats.elapsed_us : 0), spi_hz,
+		          (unsigned long)sensor_events.dispatches(), (unsigned long)fifo_overruns);
+		pc.printf("FIFO overruns=%lu resyncs=%lu dropped_words=%lu lost_samples=%lu lossy_windows=%lu\n",
+		          (unsigned long)fifo_stats.overruns, (unsigned long)fifo_stats.resyncs,
+		          (unsigned long)fifo_stats.dropped_words, (unsigned long)fifo_stats.lost_samples,
+		          (unsigned long)telemetry.value(TELEMETRY_LOSSY_WINDOWS));
+#ifdef NEAI_LIB
+		pc.printf("NEAI detections=%lu detect_us=%lu",
+		          (unsigned long)detect_count, (unsigned long)(detect_count ? detect_us / detect_count : 0));
+#ifdef NEAI_STREAM
+		/* Hops served against hops produced by the sensor */
+		pc.printf(" hop=%d hop_rate=%.2f target_rate=%.2f restarts=%lu",
+		          STREAM_HOP, stats.elapsed_us ? stream_hops * 1e6f / stats.elapsed_us : 0.0f,
+		          config.active().odr / STREAM_HOP, (unsigned long)acquisition.stream_restarts());
+		stream_hops = 0;
+#endif
+		pc.printf("\n");
+		detect_us = 0;
+		detect_count = 0;
+#endif
+		if (POSE_GATE) {
+			/* The closed part of the period, up to now */
+			if (gated) {
+				gated_us += us_ticker_read() - gated_from_us;
+				gated_from_us = us_ticker_read();
+			}
+			pc.printf("GATE gated=%d gated_ms=%lu", gated ? 1 : 0, (unsigned long)(gated_us / 1000));
+			if (POSE_COUNT_SKIPS) {
+				pc.printf(" skipped=%lu", (unsigned long)skipped);
+			}
+			pc.printf("\n");
+			skipped = 0;
+			gated_us = 0;
+		}
+		loop.reset_stats();
+	} else if (strcmp(command, "CAL START") == 0) {
+		static const float zero[3] = { 0.0f, 0.0f, 0.0f };
+		float mean[3];
+
+		/* Right away, the calibration reads the mean from now on */
+		apply_offset(zero);
+		write_offset();
+		compensation.clear();
+		acquisition.get_mean(mean);
+		calibrating = true;
+		pc.printf("CAL started\n");
+	} else if (strcmp(command, "CAL STOP") == 0) {
+		calibrating = false;
+		pc.printf("CAL bins=%u\n", (unsigned)compensation.bins());
+	} else if (strcmp(command, "SENSORS") == 0) {
+		static const char *const names[] = { "temperature", "humidity", "pressure", "magnetic", "light", "range" };
+		SamplerSample_t sample;
+
+		pc.printf("SENSORS channels=%u bus_sessions=%lu\n", (unsigned)sampler.channels(),
+		          (unsigned long)sampler.bus_sessions());
+		for (uint8_t i = 0; i < sampler.channels(); i++) {
+			if (!sampler.get(i, 0, &sample)) {
+				sample.tick = 0;
+				sample.value[0] = sample.value[1] = sample.value[2] = 0;
+			}
+			pc.printf("SENSORS %s=%.2f", names[sampler.kind(i)], sample.value[0]);
+			if (sampler.kind(i) == SAMPLER_MAGNETIC) {
+				pc.printf(",%.2f,%.2f", sample.value[1], sample.value[2]);
+			}
+			pc.printf(" age_ms=%lu samples=%lu errors=%lu\n",
+			          (unsigned long)((sampler.ticks() - sample.tick) * SAMPLER_TICK_MS),
+			          (unsigned long)sampler.count(i), (unsigned long)sampler.errors(i));
+		}
+	} else if (strcmp(command, "TEMP") == 0) {
+		pc.printf("TEMP t=%.2f offset_mg=%.1f,%.1f,%.1f bins=%u%s\n", temperature,
+		          offset[0] * 1000, offset[1] * 1000, offset[2] * 1000, (unsigned)compensation.bins(),
+		          calibrating ? " calibrating" : "");
+	} else if (strncmp(command, "SET ", 4) == 0) {
+		if (!config.stage(command + 4)) {
+			pc.printf("SET error: %s\n", config.error());
+		} else if (!config.pending()) {
+			pc.printf("SET unchanged\n");
+		} else if (!acquisition.capturing()) {
+			next_window();
+		} else {
+			pc.printf("SET staged\n");
+		}
+	} else if (strcmp(command, "TELEMETRY ON") == 0 || strcmp(command, "TELEMETRY OFF") == 0) {
+		telemetry_on = (command[11] == 'N');
+		pc.printf("TELEMETRY %s\n", telemetry_on ? "on" : "off");
+	} else if (POSE_GATE && strcmp(command, "POSE") == 0) {
+		pc.printf("POSE position=0x%02X playing=0x%02X gated=%d\n", (unsigned)pose, (unsigned)playing_pose,
+		          gated ? 1 : 0);
+	} else if (POSE_GATE && strcmp(command, "POSE SET") == 0) {
+		if (lsm6dsl.get_6d_position(&position) != 0 || position == 0) {
+			pc.printf("POSE error: between two positions\n");
+		} else {
+			playing_pose = position;
+			pose_update();
+			pc.printf("POSE playing=0x%02X\n", (unsigned)playing_pose);
+		}
+	} else if (strcmp(command, "GET") == 0) {
+		config.print(line, sizeof(line), config.active());
+		pc.printf("GET %s\n", line);
+		if (config.pending()) {
+			config.print(line, sizeof(line), config.staged());
+			pc.printf("GET staged %s\n", line);
+		}
+	}
+	command_pending = false;
 }
 
-void get_values ()
+/**
+ * @brief  Send the telemetry counters as a binary frame, see Telemetry.h
+ *         and tools/telemetry_decode
+ *
+ * @param  None
+ * @retval None
+ * @note   Sent between two lines of text, from the loop. About 30 bytes,
+ *         under 3 ms of the serial port at 115200 baud per period.
+ */
+void telemetry_emit()
 {
-	/* Get acceleration values,
-	   and make sure they are not duplicates */
+	EventLoopStats totals;
+	LSM6DSL_Fifo_Stats_t fifo_stats;
+	size_t length;
 
-	do {
-		lsm6dsl->get_x_axes(raw_values);
+	/* Values counted elsewhere, read once per frame */
+	loop.get_totals(&totals);
+	lsm6dsl.get_fifo_stats(&fifo_stats);
+	telemetry.set(TELEMETRY_SAMPLES, acquisition.samples());
+	telemetry.set(TELEMETRY_LOST_SAMPLES, fifo_stats.lost_samples);
+	telemetry.set(TELEMETRY_FIFO_OVERRUNS, fifo_stats.overruns);
+	telemetry.peak(TELEMETRY_FIFO_PEAK, acquisition.take_fifo_peak());
+	telemetry.set(TELEMETRY_EVENTS, totals.events);
+	telemetry.set(TELEMETRY_BUSY_US, totals.busy_us);
+
+	if (!telemetry_on) {
+		return;
 	}
-	while ( last_raw_values[0] == raw_values[0] || last_raw_values[1] == raw_values[1] || last_raw_values[2] == raw_values[2] );
-	/* Update values */
-	for (uint8_t i = 0; i < AXIS_NUMBER; i++) {
-		last_raw_values[i] = raw_values[i];
-		values[i] = (float) raw_values[i] / 1000;
+	length = telemetry.encode(telemetry_frame, sizeof(telemetry_frame), us_ticker_read());
+	for (size_t i = 0; i < length; i++) {
+		pc.putc(telemetry_frame[i]);
 	}
 }
 
-void led_anomaly()
+#ifdef BENCHMARK
+#define BENCH_LOOPS				1000
+#define OTHER_DEVICE_STACK		512
+#define BENCH_FIFO_SAMPLES		170		/* 510 FIFO words, 51 ms at 3330 Hz */
+
+/* Second device sharing the SPI bus, used to create contention */
+DigitalOut other_cs(A2, 1);
+volatile bool other_active = false;
+volatile uint32_t other_transfers = 0;
+
+void other_device_thread()
+{
+	while(1) {
+		if (!other_active) {
+			ThisThread::sleep_for(10);
+			continue;
+		}
+		spi.lock();
+		other_cs = 0;
+		spi.write(0x80);
+		spi.write(0x00);
+		other_cs = 1;
+		spi.unlock();
+		other_transfers++;
+	}
+}
+
+/**
+ * @brief  Per-sample cost of the runtime selected driver against the
+ *         compile-time bound LSM6DSLSensorT, in CPU cycles (DWT counter)
+ *
+ * @param  None
+ * @retval None
+ */
+void bench_bus_binding()
 {
-	for (uint8_t j = 0; j < 3; j++) {
-		d2 = 1;
-		wait_ms(100);
-		d2 = 0;
-		wait_ms(50);
+	static LSM6DSLSpi4W bus(&spi, A3);
+	static LSM6DSLSensorT<LSM6DSLSpi4W> lsm6dsl_t(bus);
+	int16_t raw[3];
+	uint32_t start, runtime_cycles, template_cycles;
+
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+		lsm6dsl.get_x_axes_raw(raw);
 	}
+	runtime_cycles = (DWT->CYCCNT - start) / BENCH_LOOPS;
 
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+		lsm6dsl_t.get_x_axes_raw(raw);
+	}
+	template_cycles = (DWT->CYCCNT - start) / BENCH_LOOPS;
+
+	pc.printf("get_x_axes_raw cycles/sample: LSM6DSLSensor %lu, LSM6DSLSensorT<LSM6DSLSpi4W> %lu\n",
+	          (unsigned long)runtime_cycles, (unsigned long)template_cycles);
 }
 
-void led_learned()
+/**
+ * @brief  Cost of the 12 register reads of get_event_status() with one
+ *         bus lock per access and within a single BusSession, while
+ *         another thread keeps using the same SPI bus
+ *
+ * @param  None
+ * @retval None
+ */
+void bench_bus_session()
 {
-	for (uint8_t j = 0; j < 1; j++) {
-		d1 = 1;
-		wait_ms(750);
-		d1 = 0;
-		wait_ms(150);
+	static const uint8_t regs[12] = {
+		LSM6DSL_ACC_GYRO_WAKE_UP_SRC, LSM6DSL_ACC_GYRO_TAP_SRC, LSM6DSL_ACC_GYRO_D6D_SRC,
+		LSM6DSL_ACC_GYRO_FUNC_SRC, LSM6DSL_ACC_GYRO_MD1_CFG, LSM6DSL_ACC_GYRO_MD2_CFG,
+		LSM6DSL_ACC_GYRO_INT1_CTRL, LSM6DSL_ACC_GYRO_INT2_CTRL, LSM6DSL_ACC_GYRO_TAP_CFG1,
+		LSM6DSL_ACC_GYRO_CTRL10_C, LSM6DSL_ACC_GYRO_STATUS_REG, LSM6DSL_ACC_GYRO_WHO_AM_I_REG
+	};
+	uint8_t value;
+	uint32_t start, others, locked_cycles, locked_others, session_cycles, session_others;
+
+	others = other_transfers;
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+		for (uint8_t r = 0; r < sizeof(regs); r++) {
+			lsm6dsl.read_reg(regs[r], &value);
+		}
+	}
+	locked_cycles = (DWT->CYCCNT - start) / BENCH_LOOPS;
+	locked_others = other_transfers - others;
+
+	others = other_transfers;
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+		LSM6DSLSensor::BusSession session(&lsm6dsl);
+		for (uint8_t r = 0; r < sizeof(regs); r++) {
+			lsm6dsl.read_reg(regs[r], &value);
+		}
 	}
+	session_cycles = (DWT->CYCCNT - start) / BENCH_LOOPS;
+	session_others = other_transfers - others;
+
+	pc.printf("12 register reads cycles: per access lock %lu (other device %lu transfers), bus session %lu (other device %lu transfers)\n",
+	          (unsigned long)locked_cycles, (unsigned long)locked_others,
+	          (unsigned long)session_cycles, (unsigned long)session_others);
 }
 
-void led_learning_over()
+/**
+ * @brief  Cost of draining the FIFO with 8-bit frames and with 16-bit frames
+ *
+ * @param  None
+ * @retval None
+ */
+void bench_fifo_frames()
 {
-	for (uint8_t j = 0; j < 3; j++) {
-		d1 = 1;
-		wait_ms(750);
-		d1 = 0;
-		wait_ms(50);
+	static int16_t raw[3 * BENCH_FIFO_SAMPLES];
+	size_t got;
+	uint32_t start, byte_cycles, word_cycles;
+
+	lsm6dsl.enable_x_fifo();
+
+	lsm6dsl.set_fifo_word_frames(false);
+	lsm6dsl.reset_fifo();
+	wait_ms(100);
+	start = DWT->CYCCNT;
+	lsm6dsl.read_x_block(raw, BENCH_FIFO_SAMPLES, &got);
+	byte_cycles = DWT->CYCCNT - start;
+
+	lsm6dsl.set_fifo_word_frames(true);
+	lsm6dsl.reset_fifo();
+	wait_ms(100);
+	start = DWT->CYCCNT;
+	lsm6dsl.read_x_block(raw, BENCH_FIFO_SAMPLES, &got);
+	word_cycles = DWT->CYCCNT - start;
+
+	lsm6dsl.disable_fifo();
+
+	pc.printf("FIFO drain of %d samples cycles: 8-bit frames %lu, 16-bit frames %lu\n",
+	          BENCH_FIFO_SAMPLES, (unsigned long)byte_cycles, (unsigned long)word_cycles);
+}
+
+uint32_t bench_ticks()
+{
+	return DWT->CYCCNT;
+}
+
+void bench_wait_ms(uint32_t ms)
+{
+	wait_ms(ms);
+}
+
+void bench_print(const char *line)
+{
+	pc.printf("%s\n", line);
+}
+
+void bench_print_similarity(uint8_t similarity)
+{
+	/* As window_complete() in NEAI_LIB mode */
+	pc.printf("%d\n", similarity);
+}
+
+/**
+ * @brief  Bus usage of reading consecutive samples without the FIFO, one
+ *         get_x_axes_raw() per sample against read_x_stream(), both paced
+ *         by XLDA polled every sixteenth of the ODR period
+ *
+ * @param  None
+ * @retval None
+ */
+void bench_x_stream()
+{
+	static int16_t raw[3 * BENCH_FIFO_SAMPLES];
+	LSM6DSL_Stream_Stats_t sample_stats = { 0, 0, 0, 0 }, stream_stats = { 0, 0, 0, 0 };
+	uint8_t status;
+	size_t got;
+	uint32_t start, sample_cycles, stream_cycles;
+
+	start = DWT->CYCCNT;
+	for (got = 0; got < BENCH_FIFO_SAMPLES; got++) {
+		do {
+			lsm6dsl.read_reg(LSM6DSL_ACC_GYRO_STATUS_REG, &status);
+			sample_stats.transactions++;
+			sample_stats.bytes += 2;
+			if (!(status & LSM6DSL_ACC_GYRO_XLDA_MASK)) {
+				wait_us((int)(1000000.0f / ODR / 16));
+			}
+		} while (!(status & LSM6DSL_ACC_GYRO_XLDA_MASK));
+		lsm6dsl.get_x_axes_raw(&raw[3 * got]);
+		sample_stats.transactions++;
+		sample_stats.bytes += 7;
 	}
+	sample_cycles = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	lsm6dsl.read_x_stream(raw, BENCH_FIFO_SAMPLES, &got, &stream_stats);
+	stream_cycles = DWT->CYCCNT - start;
 
+	pc.printf("%d samples from the output registers: get_x_axes_raw %lu transactions %lu bytes %lu cycles, "
+	          "circular burst %lu transactions %lu bytes %lu cycles (%u samples, %lu late, %lu slipped)\n", BENCH_FIFO_SAMPLES,
+	          (unsigned long)sample_stats.transactions, (unsigned long)sample_stats.bytes, (unsigned long)sample_cycles,
+	          (unsigned long)stream_stats.transactions, (unsigned long)stream_stats.bytes, (unsigned long)stream_cycles,
+	          (unsigned)got, (unsigned long)stream_stats.late, (unsigned long)stream_stats.slipped);
 }
 
-void led_nominal()
+/* SystemCoreClock is set at startup, see benchmark_mode() */
+BenchPlatform_t bench_platform = {
+	"target", bench_ticks, 0, bench_wait_ms, bench_print, bench_print_similarity,
+#ifdef NEAI_LIB
+	NanoEdgeAI_learn, NanoEdgeAI_detect
+#else
+	NULL, NULL
+#endif
+};
+/* No window is captured while benchmarking, data_user is the work buffer */
+MBED_STATIC_ASSERT(sizeof(data_user) / sizeof(float) >= 3 * (DATA_INPUT_USER + BenchSuite<LSM6DSLSensor>::SEARCH + 1),
+                   "data_user too small for the benchmark suite");
+BenchSuite<LSM6DSLSensor> bench_suite(&lsm6dsl, &bench_platform, data_user, DATA_INPUT_USER);
+
+/**
+ * @brief  Benchmark suite then driver timings, printed every second
+ *
+ * @param  None
+ * @retval None
+ */
+void benchmark_mode()
 {
-	for (uint8_t j = 0; j < 1; j++) {
-		d3 = 1;
+	static unsigned char other_device_stack[OTHER_DEVICE_STACK];
+	static Thread other_device(osPriorityNormal, sizeof(other_device_stack), other_device_stack);
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	bench_platform.clock_hz = SystemCoreClock;
+
+	/* Timings read the output registers of the sensor configured by init() */
+	lsm6dsl.disable_fifo();
+	other_device.start(callback(other_device_thread));
+
+	while(1) {
+		bench_suite.run();
+
+		bench_bus_binding();
+
+		other_active = true;
+		bench_bus_session();
+		other_active = false;
+
+		bench_fifo_frames();
+		bench_x_stream();
+
 		wait_ms(1000);
-		d3 = 0;
-		wait_ms(250);
 	}
+}
+#endif
+
+#ifdef NEAI_LIB
+/* LED patterns play in the background, a new verdict preempts the previous one */
+const LedPattern anomaly_pattern = { &d2, 100, 50, 3 };
+const LedPattern learned_pattern = { &d1, 750, 150, 1 };
+const LedPattern learning_over_pattern = { &d1, 750, 50, 3 };
+const LedPattern nominal_pattern = { &d3, 1000, 250, 1 };
+
+void led_anomaly()
+{
+	leds.play(anomaly_pattern);
+}
 
-}
\ No newline at end of file
+void led_learned()
+{
+	leds.play(learned_pattern);
+}
+
+void led_learning_over()
+{
+	/* Played after the last learned pattern */
+	leds.queue(learning_over_pattern);
+}
+
+void led_nominal()
+{
+	leds.play(nominal_pattern);
+}
+#endif
+
+#ifdef ZERO_HEAP
+/**
+ * @brief  Any C++ heap allocation is a bug in this build: every object has
+ *         static storage, sized at compile time
+ *
+ * @param  size requested size
+ * @retval None, does not return
+ */
+void *operator new(size_t size)
+{
+	error("Heap allocation of %u bytes\n", (unsigned)size);
+	return NULL;
+}
+
+void *operator new[](size_t size)
+{
+	error("Heap allocation of %u bytes\n", (unsigned)size);
+	return NULL;
+}
+#endif
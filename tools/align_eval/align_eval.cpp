@@ -0,0 +1,328 @@
+/**
+*******************************************************************************
+* @file   align_eval.cpp
+* @brief  Triggered against peak-aligned windows, on replayed sessions
+*******************************************************************************
+* Replays captures (see tools/trigger_sweep for the format) through the
+* firmware Acquisition and StrumTrigger, once capturing windows as
+* triggered and once aligned on the attack peak by OnsetAligner, and
+* compares the two sets of windows:
+*
+*  - offset and jitter: median of the window start against the nearest
+*    labelled strum onset and its median absolute deviation, scaled as a
+*    standard deviation, in samples. Windows triggered by a decaying strum
+*    do not weigh on them;
+*  - similarity: correlation of the envelope of each window, RMS over
+*    FRAME samples, with the mean envelope, in %, mean and variance. String
+*    phases change from a strum to the next, envelopes do not. NanoEdge AI is
+*    only available as a target library, this is the stand-in for its
+*    similarity score;
+*  - learning: windows averaged before the mean envelope correlates at 98%
+*    with the final one, the stand-in for LEARNING_NUMBER.
+*
+* Play a single chord for meaningful similarities, strum_synth --chord.
+*
+* Build (from this directory):
+*   g++ -std=c++11 -O2 -I../../src -I../../lib/lsm6dsl -I../../lib/lsm6dsl/Sim \
+*       align_eval.cpp ../../src/StrumTrigger.cpp ../../src/StreamWindow.cpp \
+*       ../../src/OnsetAlign.cpp ../../src/SyncClock.cpp ../../src/GoertzelBank.cpp \
+*       -o align_eval
+*
+* Usage: align_eval [--window N] [--pre N] [--search N] [--mini N]
+*                   [--thresh R] [--noise G] capture...
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "ReplaySensor.h"
+#include "StrumTrigger.h"
+#include "OnsetAlign.h"
+#include "Acquisition.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define SENSITIVITY				0.122f	/* mg/LSB at 4 g */
+#define FRAME					16		/* Samples per envelope value, 5 ms */
+#define LEARNING_TARGET			0.98	/* Correlation of the running mean with the final one */
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef struct {
+	std::vector<float> xyz;
+	std::vector<size_t> onsets;
+} Session;
+
+typedef struct {
+	std::vector<std::vector<float> > windows;
+	std::vector<double> offsets;	/* Window start minus the nearest onset, in samples */
+} Windows;
+
+/********************************* Functions *********************************/
+
+bool load_session(const char *path, Session *session)
+{
+	char labels[4096];
+	unsigned long onset;
+	FILE *file = fopen(path, "rb");
+	long bytes;
+
+	if (!file || fseek(file, 0, SEEK_END) != 0 || (bytes = ftell(file)) < 0) {
+		fprintf(stderr, "%s: cannot read\n", path);
+		return false;
+	}
+	rewind(file);
+	session->xyz.resize((size_t)bytes / sizeof(float) / 3 * 3);
+	if (fread(session->xyz.data(), sizeof(float), session->xyz.size(), file) != session->xyz.size()) {
+		fprintf(stderr, "%s: read error\n", path);
+		fclose(file);
+		return false;
+	}
+	fclose(file);
+
+	snprintf(labels, sizeof(labels), "%s.labels", path);
+	file = fopen(labels, "r");
+	if (!file) {
+		fprintf(stderr, "%s: missing\n", labels);
+		return false;
+	}
+	while (fscanf(file, "%lu", &onset) == 1) {
+		session->onsets.push_back(onset);
+	}
+	fclose(file);
+	std::sort(session->onsets.begin(), session->onsets.end());
+	return true;
+}
+
+/**
+ * @brief  Capture the windows of a session, as fifo_drain() does
+ *
+ * @param  session samples and onsets
+ * @param  trigger strum detection
+ * @param  aligner peak alignment, NULL for windows as triggered
+ * @param  window samples per window
+ * @param  out windows and their offset to the nearest onset
+ * @retval None
+ */
+void capture(const Session &session, StrumTrigger *trigger, OnsetAligner *aligner, uint16_t window, Windows *out)
+{
+	uint16_t margin = aligner ? aligner->margin() : 0;
+	std::vector<float> buffer(3 * (window + margin));
+	ReplaySensor sensor(session.xyz.data(), session.xyz.size() / 3, SENSITIVITY);
+	Acquisition<ReplaySensor> acquisition(&sensor, trigger, buffer.data(), (uint16_t)(window + margin));
+	size_t end, start;
+	std::vector<size_t>::const_iterator onset;
+
+	acquisition.set_sensitivity(SENSITIVITY);
+	acquisition.set_window_samples(window);
+	acquisition.set_aligner(aligner);
+	trigger->reset();
+
+	while (!sensor.done()) {
+		if (!acquisition.drain()) {
+			continue;
+		}
+		/* One sample per read, the window ended on the last one */
+		end = sensor.position();
+		start = end - window - margin + (acquisition.window() - buffer.data()) / 3;
+		/* Offset to the nearest labelled onset, the aligned window starts before it */
+		onset = std::upper_bound(session.onsets.begin(), session.onsets.end(), start);
+		if (onset == session.onsets.end() || (onset != session.onsets.begin() && start - *(onset - 1) < *onset - start)) {
+			--onset;
+		}
+		if (onset != session.onsets.end()) {
+			out->offsets.push_back((double)start - (double)*onset);
+			out->windows.push_back(std::vector<float>(acquisition.window(), acquisition.window() + 3 * window));
+		}
+		acquisition.rearm();
+	}
+}
+
+double median(std::vector<double> *values)
+{
+	size_t middle = values->size() / 2;
+
+	std::nth_element(values->begin(), values->begin() + middle, values->end());
+	return (*values)[middle];
+}
+
+/* Envelope of each axis, RMS over FRAME samples, centred and scaled to unit
+   norm: the string phases differ from a strum to the next, the envelope of
+   a chord played the same way does not */
+void envelope(std::vector<float> *window)
+{
+	size_t frames = window->size() / 3 / FRAME;
+	std::vector<float> env(3 * frames, 0.0f);
+	double mean[3] = { 0, 0, 0 }, level, norm = 0;
+
+	for (size_t k = 0; k < frames * FRAME; k++) {
+		for (int i = 0; i < 3; i++) {
+			mean[i] += (*window)[3 * k + i] / (frames * FRAME);
+		}
+	}
+	for (size_t k = 0; k < frames * FRAME; k++) {
+		for (int i = 0; i < 3; i++) {
+			level = (*window)[3 * k + i] - mean[i];
+			env[3 * (k / FRAME) + i] += (float)(level * level / FRAME);
+		}
+	}
+	for (size_t f = 0; f < env.size(); f++) {
+		env[f] = sqrtf(env[f]);
+	}
+	for (int i = 0; i < 3; i++) {
+		mean[i] = 0;
+		for (size_t f = 0; f < frames; f++) {
+			mean[i] += env[3 * f + i] / frames;
+		}
+	}
+	for (size_t f = 0; f < env.size(); f++) {
+		env[f] -= (float)mean[f % 3];
+		norm += env[f] * env[f];
+	}
+	norm = sqrt(norm);
+	for (size_t f = 0; f < env.size(); f++) {
+		env[f] = norm > 0 ? (float)(env[f] / norm) : 0.0f;
+	}
+	window->swap(env);
+}
+
+double correlation(const std::vector<float> &a, const std::vector<double> &template_sum)
+{
+	double dot = 0, norm = 0;
+
+	for (size_t k = 0; k < a.size(); k++) {
+		dot += a[k] * template_sum[k];
+		norm += template_sum[k] * template_sum[k];
+	}
+	return norm > 0 ? dot / sqrt(norm) : 0.0;
+}
+
+/* Correlation of the mean of the first count windows with the mean of all */
+double convergence(const std::vector<std::vector<float> > &windows, size_t count, const std::vector<double> &final_sum)
+{
+	std::vector<float> sum(windows[0].size(), 0.0f);
+	double dot = 0, norm = 0, final_norm = 0;
+
+	for (size_t w = 0; w < count; w++) {
+		for (size_t k = 0; k < sum.size(); k++) {
+			sum[k] += windows[w][k];
+		}
+	}
+	for (size_t k = 0; k < sum.size(); k++) {
+		dot += sum[k] * final_sum[k];
+		norm += (double)sum[k] * sum[k];
+		final_norm += final_sum[k] * final_sum[k];
+	}
+	return (norm > 0 && final_norm > 0) ? dot / sqrt(norm * final_norm) : 0.0;
+}
+
+void report(const char *name, Windows *set)
+{
+	std::vector<double> sum, offsets;
+	double offset_median, jitter, sim_mean = 0, sim_var = 0;
+	size_t n = set->windows.size(), learning;
+
+	if (n < 2) {
+		printf("%-10s %8lu windows, not enough to compare\n", name, (unsigned long)n);
+		return;
+	}
+	/* Median and median absolute deviation, windows started by the decay
+	   of a strum or a string ringing over noise should not weigh much */
+	offsets = set->offsets;
+	offset_median = median(&offsets);
+	for (size_t w = 0; w < n; w++) {
+		envelope(&set->windows[w]);
+		offsets[w] = fabs(set->offsets[w] - offset_median);
+	}
+	jitter = 1.4826 * median(&offsets);
+
+	sum.assign(set->windows[0].size(), 0.0);
+	for (size_t w = 0; w < n; w++) {
+		for (size_t k = 0; k < sum.size(); k++) {
+			sum[k] += set->windows[w][k];
+		}
+	}
+	for (size_t w = 0; w < n; w++) {
+		double s = 100.0 * correlation(set->windows[w], sum);
+
+		sim_mean += s / n;
+		sim_var += s * s / n;
+	}
+	sim_var -= sim_mean * sim_mean;
+
+	for (learning = 1; learning < n; learning++) {
+		if (convergence(set->windows, learning, sum) >= LEARNING_TARGET) {
+			break;
+		}
+	}
+
+	printf("%-10s %8lu %9.1f %9.2f %10.1f %10.2f %9lu\n", name, (unsigned long)n, offset_median, jitter,
+	       sim_mean, sim_var, (unsigned long)learning);
+}
+
+void usage(void)
+{
+	fprintf(stderr, "usage: align_eval [--window N] [--pre N] [--search N] [--mini N] [--thresh R] [--noise G] capture...\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	uint16_t window = 1024, pre = 24, search = 64, mini = 5;
+	float thresh = 1.4f, noise = 0.15f;
+	std::vector<Session> sessions;
+	Windows triggered, aligned;
+
+	for (int i = 1; i < argc; i++) {
+		const char *option = argv[i];
+
+		if (option[0] != '-') {
+			sessions.push_back(Session());
+			if (!load_session(option, &sessions.back())) {
+				return 1;
+			}
+			continue;
+		}
+		if (i + 1 >= argc) {
+			usage();
+		}
+		const char *value = argv[++i];
+
+		if (strcmp(option, "--window") == 0) {
+			window = (uint16_t)atoi(value);
+		} else if (strcmp(option, "--pre") == 0) {
+			pre = (uint16_t)atoi(value);
+		} else if (strcmp(option, "--search") == 0) {
+			search = (uint16_t)atoi(value);
+		} else if (strcmp(option, "--mini") == 0) {
+			mini = (uint16_t)atoi(value);
+		} else if (strcmp(option, "--thresh") == 0) {
+			thresh = (float)atof(value);
+		} else if (strcmp(option, "--noise") == 0) {
+			noise = (float)atof(value);
+		} else {
+			usage();
+		}
+	}
+	if (sessions.empty() || window == 0 || mini == 0) {
+		usage();
+	}
+
+	StrumTrigger trigger(mini, thresh, noise);
+	OnsetAligner aligner(pre, search);
+
+	for (size_t s = 0; s < sessions.size(); s++) {
+		capture(sessions[s], &trigger, NULL, window, &triggered);
+		capture(sessions[s], &trigger, &aligner, window, &aligned);
+	}
+
+	printf("%-10s %8s %9s %9s %10s %10s %9s\n", "capture", "windows", "offset", "jitter", "similarity", "variance", "learning");
+	report("triggered", &triggered);
+	report("aligned", &aligned);
+	return 0;
+}
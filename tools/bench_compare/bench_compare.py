@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+"""
+*******************************************************************************
+* @file   bench_compare.py
+* @brief  Benchmark reports of the target and of the host side by side
+*******************************************************************************
+* Reads the BENCH lines printed by the BENCHMARK firmware and by
+* tools/host_bench, see src/BenchSuite.h, other lines being ignored, and
+* prints the median time per operation of each measurement in microseconds
+* for every report, with the ratio of the first report to the others. When
+* a report holds several runs of the suite, the last complete one is used.
+*
+* Usage (from the project root):
+*   python tools/bench_compare/bench_compare.py target.log host.log
+*   python tools/bench_compare/bench_compare.py --csv target.log host.log
+*
+* Exits with status 1 when the reports come from different suite versions.
+*******************************************************************************
+"""
+
+import argparse
+import sys
+
+
+def parse(path):
+    """Return (header fields, {name: fields}) of the last complete suite"""
+    header, results, last = None, {}, None
+    with open(path, 'rb') as report:
+        for raw in report:
+            line = raw.decode('ascii', 'replace').strip()
+            if not line.startswith('BENCH '):
+                continue
+            words = line.split()[1:]
+            fields = dict(word.split('=', 1) for word in words if '=' in word)
+            if words[0] == 'begin':
+                header, results = fields, {}
+            elif words[0] == 'end' and header is not None:
+                last = (header, results)
+            elif 'name' in fields and header is not None:
+                fields['skipped'] = 'skipped' in words
+                results[fields['name']] = fields
+    if last is None:
+        raise ValueError('%s: no complete BENCH report' % path)
+    return last
+
+
+def microseconds(header, fields):
+    if fields['skipped']:
+        return None
+    return int(fields['median']) * 1e6 / int(header['clock_hz'])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare BENCH reports of the target and host')
+    parser.add_argument('reports', nargs='+', help='serial logs or host_bench outputs, the reference first')
+    parser.add_argument('--csv', action='store_true', help='CSV output')
+    args = parser.parse_args()
+
+    reports = [parse(path) for path in args.reports]
+    versions = set(header.get('suite') for header, _ in reports)
+    if len(versions) > 1:
+        sys.stderr.write('Reports of different suite versions: %s\n' % ', '.join(sorted(versions)))
+        return 1
+
+    names = []
+    for _, results in reports:
+        names += [name for name in results if name not in names]
+    platforms = [header.get('platform', '?') for header, _ in reports]
+
+    columns = ['name'] + ['%s_us' % p for p in platforms] + ['%s/%s' % (platforms[0], p) for p in platforms[1:]]
+    rows = []
+    for name in names:
+        times = [microseconds(header, results[name]) if name in results else None for header, results in reports]
+        row = [name] + ['-' if t is None else '%.3f' % t for t in times]
+        for t in times[1:]:
+            row.append('%.1f' % (times[0] / t) if times[0] is not None and t else '-')
+        rows.append(row)
+
+    if args.csv:
+        print(','.join(columns))
+        for row in rows:
+            print(','.join(row))
+        return 0
+
+    widths = [max(len(r[i]) for r in rows + [columns]) for i in range(len(columns))]
+    print('  '.join(c.rjust(w) if i else c.ljust(w) for i, (c, w) in enumerate(zip(columns, widths))))
+    for row in rows:
+        print('  '.join(c.rjust(w) if i else c.ljust(w) for i, (c, w) in enumerate(zip(row, widths))))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
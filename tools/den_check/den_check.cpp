@@ -0,0 +1,156 @@
+/**
+*******************************************************************************
+* @file   den_check.cpp
+* @brief  Window labels from the DEN stamp, against the simulator
+*******************************************************************************
+* Runs the firmware Acquisition on LSM6DSLSensorT over the simulated bus,
+* fed by StrumSynth, with DEN stamping enabled as in main.cpp (x axis,
+* active low) and the marker decoded by the acquisition. A simulated
+* footswitch is pressed for a random half of the strums, from their onset to
+* the next one, as a player marking the strums of a chord.
+*
+* Each window is expected to be fully marked when its strum was, unmarked
+* otherwise; windows spanning the next onset are left out. The check fails,
+* exit status 1, on any window with the wrong label, on partially marked
+* windows, and when the stamp reaches the converted signal.
+*
+* Build (from this directory):
+*   g++ -std=c++11 -O2 -I../../src -I../../lib/lsm6dsl -I../../lib/lsm6dsl/Sim \
+*       den_check.cpp ../../src/StrumTrigger.cpp ../../src/StreamWindow.cpp \
+*       ../../src/OnsetAlign.cpp ../../src/SyncClock.cpp ../../src/GoertzelBank.cpp \
+*       -o den_check
+*
+* Usage: den_check [seconds] [seed]
+*   seconds: simulated duration, 120 by default
+*   seed: of the strums and of the footswitch, 1 by default
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "LSM6DSLSensorT.h"
+#include "LSM6DSLSimulator.h"
+#include "StrumSynth.h"
+#include "StrumTrigger.h"
+#include "Acquisition.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define WINDOW					1024
+#define ODR_HZ					3330.0f
+#define FS_G					4.0f
+#define DRAIN_PERIOD_MS			20
+#define MINI					5
+#define THRESH					1.4f
+#define NOISE					0.15f
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef LSM6DSLSensorT<LSM6DSLSimBus> SimSensor;
+
+typedef struct {
+	StrumSynth synth;
+	LSM6DSLSimulator *sim;
+	uint32_t random;
+	std::vector<uint64_t> onsets;	/* Sample index of each strum */
+	std::vector<bool> pressed;		/* Footswitch down during each strum */
+} Player;
+
+/********************************* Functions *********************************/
+
+/* LSM6DSLSimulator source: the strums, and the footswitch on DEN */
+void play(void *context, uint32_t index, int16_t *xl, int16_t *g)
+{
+	Player *player = (Player *)context;
+	uint64_t sample = player->synth.samples();
+
+	(void)index;
+	if (player->synth.next_raw(xl)) {
+		player->random = player->random * 1664525u + 1013904223u;
+		player->onsets.push_back(sample);
+		player->pressed.push_back((player->random >> 16) & 1);
+		/* Active low, the switch pulls the pin to ground */
+		player->sim->set_den(!player->pressed.back());
+	}
+	g[0] = g[1] = g[2] = 0;
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = (argc > 1) ? atof(argv[1]) : 120.0;
+	uint32_t seed = (argc > 2) ? (uint32_t)atoi(argv[2]) : 1;
+	LSM6DSLSimulator sim;
+	LSM6DSLSimBus bus(sim);
+	SimSensor lsm6dsl(bus);
+	Player player;
+	StrumTrigger trigger(MINI, THRESH, NOISE);
+	std::vector<float> window(3 * WINDOW);
+	Acquisition<SimSensor> acquisition(&lsm6dsl, &trigger, window.data(), WINDOW);
+	unsigned windows = 0, marked = 0, spanning = 0, wrong = 0, partial = 0, leaked = 0;
+	float sensitivity = 0;
+
+	player.synth.reset(seed);
+	player.sim = &sim;
+	player.random = seed;
+	sim.set_source(&play, &player);
+	sim.set_den(true);
+
+	lsm6dsl.init();
+	lsm6dsl.set_x_odr(ODR_HZ);
+	lsm6dsl.set_x_fs(FS_G);
+	lsm6dsl.enable_x();
+	lsm6dsl.get_x_sensitivity(&sensitivity);
+	lsm6dsl.enable_den_stamping(LSM6DSL_ACC_GYRO_DEN_X, LSM6DSL_ACC_GYRO_DEN_LOW);
+	lsm6dsl.enable_x_fifo();
+	acquisition.set_sensitivity(sensitivity);
+	acquisition.set_marker(0);
+
+	while (sim.now_us() < seconds * 1e6) {
+		bus.delay_us(DRAIN_PERIOD_MS * 1000);
+		if (!acquisition.drain()) {
+			continue;
+		}
+		windows++;
+
+		/* The window ended within the last drain period */
+		uint64_t end = player.synth.samples(), start = end - WINDOW - (uint64_t)(DRAIN_PERIOD_MS * ODR_HZ / 1000);
+		size_t strum = player.onsets.size();
+
+		while (strum > 0 && player.onsets[strum - 1] > end) {
+			strum--;
+		}
+		if (strum == 0 || player.onsets[strum - 1] > start) {
+			spanning++;
+		} else {
+			bool expected = player.pressed[strum - 1];
+			uint16_t count = acquisition.window_marked();
+
+			marked += (count > 0);
+			if ((count > 0) != expected) {
+				wrong++;
+			} else if (count != 0 && count != WINDOW) {
+				partial++;
+			}
+		}
+
+		/* The stamp is cleared before the conversion */
+		for (uint16_t i = 0; i < WINDOW; i++) {
+			int32_t lsb = (int32_t)floorf(window[3 * i] * 1000 / sensitivity + 0.5f);
+
+			leaked += (lsb & 1) != 0;
+		}
+		acquisition.rearm();
+	}
+
+	printf("strums=%u windows=%u marked=%u spanning=%u wrong=%u partial=%u leaked_samples=%u\n",
+	       (unsigned)player.onsets.size(), windows, marked, spanning, wrong, partial, leaked);
+	if (windows == 0 || wrong || partial || leaked) {
+		printf("FAIL\n");
+		return 1;
+	}
+	printf("PASS\n");
+	return 0;
+}
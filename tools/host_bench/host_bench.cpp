@@ -0,0 +1,94 @@
+/**
+*******************************************************************************
+* @file   host_bench.cpp
+* @brief  Benchmark suite of the BENCHMARK firmware, against the simulator
+*******************************************************************************
+* Runs src/BenchSuite.h on a PC with LSM6DSLSensorT over the simulated bus,
+* fed by StrumSynth, and prints the same report as the firmware. Ticks are
+* nanoseconds of the monotonic clock. NanoEdge AI only exists for the
+* target, detect is skipped.
+*
+* Build (from this directory):
+*   g++ -std=c++11 -O2 -I../../src -I../../lib/lsm6dsl -I../../lib/lsm6dsl/Sim \
+*       host_bench.cpp ../../src/StrumTrigger.cpp ../../src/OnsetAlign.cpp \
+*       ../../src/StreamWindow.cpp ../../src/GoertzelBank.cpp -o host_bench
+*
+* Usage: host_bench [window]
+*   window: samples per window, 1024 by default as DATA_INPUT_USER
+*
+* Compare with a target report: tools/bench_compare/bench_compare.py
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "LSM6DSLSensorT.h"
+#include "LSM6DSLSimulator.h"
+#include "StrumSynth.h"
+#include "BenchSuite.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define DATA_INPUT_USER 		1024
+#define ODR_HZ					3330.0f
+#define FS_G					4.0f
+
+typedef LSM6DSLSensorT<LSM6DSLSimBus> SimSensor;
+
+/* Variables -----------------------------------------------------------------*/
+
+LSM6DSLSimulator sim;
+StrumSynth synth;
+LSM6DSLSimBus bus(sim);
+SimSensor lsm6dsl(bus);
+
+/********************************* Functions *********************************/
+
+uint32_t host_ticks()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + now.tv_nsec);
+}
+
+/* Simulated time, the sensor fills its FIFO instantly */
+void host_wait_ms(uint32_t ms)
+{
+	sim.advance_us(ms * 1000.0);
+}
+
+void host_print(const char *line)
+{
+	printf("%s\n", line);
+}
+
+void host_print_similarity(uint8_t similarity)
+{
+	printf("%d\n", similarity);
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	const BenchPlatform_t platform = {
+		"host", &host_ticks, 1000000000u, &host_wait_ms, &host_print, &host_print_similarity, NULL, NULL
+	};
+	uint16_t window = (argc > 1) ? (uint16_t)atoi(argv[1]) : DATA_INPUT_USER;
+	std::vector<float> work(3 * BenchSuite<SimSensor>::work_samples(window));
+	float sensitivity = 0;
+
+	sim.set_source(&StrumSynth::source, &synth);
+	lsm6dsl.init();
+	lsm6dsl.set_x_odr(ODR_HZ);
+	lsm6dsl.set_x_fs(FS_G);
+	lsm6dsl.enable_x();
+	lsm6dsl.get_x_sensitivity(&sensitivity);
+
+	BenchSuite<SimSensor> suite(&lsm6dsl, &platform, work.data(), window);
+	suite.run();
+	return 0;
+}
@@ -0,0 +1,276 @@
+/**
+*******************************************************************************
+* @file   HostEventQueue.h
+* @brief  Host stand-in for the mbed EventQueue, on a simulated time base
+*******************************************************************************
+* Provides the subset of the mbed API used by src/EventLoop and the firmware
+* handlers: Callback, callback(), EventQueue (call, call_in, call_every,
+* cancel, dispatch) and us_ticker_read().
+*
+* Time only moves forward through the idle hook, which the runner binds to
+* LSM6DSLSimulator::advance_us(): when no event is due, the queue lets the
+* simulated sensor run up to the next one, the way the target sleeps. Time
+* spent executing a handler is measured on the host clock, scaled by
+* set_cpu_scale(), and charged to the simulated time base as well.
+*******************************************************************************
+*/
+
+#ifndef __HOST_EVENT_QUEUE_H__
+#define __HOST_EVENT_QUEUE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <functional>
+#include <map>
+
+/* Class Declaration ---------------------------------------------------------*/
+
+template <typename F> class Callback;
+
+template <typename R, typename... A>
+class Callback<R(A...)>
+{
+public:
+	Callback() {}
+	Callback(R (*function)(A...)) : _function(function) {}
+	template <typename T, typename M>
+	Callback(T *obj, M method) : _function([obj, method](A... args) { return (obj->*method)(args...); }) {}
+
+	R operator()(A... args) const
+	{
+		return _function(args...);
+	}
+
+	R call(A... args) const
+	{
+		return _function(args...);
+	}
+
+private:
+	std::function<R(A...)> _function;
+};
+
+template <typename R, typename... A>
+Callback<R(A...)> callback(R (*function)(A...))
+{
+	return Callback<R(A...)>(function);
+}
+
+template <typename T, typename R, typename... A>
+Callback<R(A...)> callback(T *obj, R (T::*method)(A...))
+{
+	return Callback<R(A...)>(obj, method);
+}
+
+class HostClock
+{
+public:
+	static uint64_t &base_us()
+	{
+		static uint64_t base = 0;
+		return base;
+	}
+
+	static double &cpu_scale()
+	{
+		static double scale = 1.0;
+		return scale;
+	}
+
+	static std::chrono::steady_clock::time_point *&handler_start()
+	{
+		static std::chrono::steady_clock::time_point *start = NULL;
+		return start;
+	}
+
+	/* Simulated time, including the handler running right now */
+	static uint64_t now_us()
+	{
+		uint64_t now = base_us();
+
+		if (handler_start()) {
+			now += elapsed_us(*handler_start());
+		}
+		return now;
+	}
+
+	static uint64_t elapsed_us(std::chrono::steady_clock::time_point start)
+	{
+		double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		return (uint64_t)(us * cpu_scale());
+	}
+};
+
+inline uint32_t us_ticker_read()
+{
+	return (uint32_t)HostClock::now_us();
+}
+
+class EventQueue
+{
+public:
+	typedef void (*idle_t)(void *context, uint32_t us);
+
+	EventQueue(unsigned size = 0, unsigned char *buffer = NULL) :
+		_idle(NULL), _idle_context(NULL), _next_id(1), _break(false)
+	{
+		(void)size;
+		(void)buffer;
+	}
+
+	/* Called to let the simulated time run, while idle or after a handler */
+	void set_idle(idle_t idle, void *context)
+	{
+		_idle = idle;
+		_idle_context = context;
+	}
+
+	void set_cpu_scale(double scale)
+	{
+		HostClock::cpu_scale() = scale;
+	}
+
+	template <typename F>
+	int call(F f)
+	{
+		return post(0, 0, std::function<void()>(f));
+	}
+
+	template <typename T, typename M, typename... A>
+	int call(T *obj, M method, A... args)
+	{
+		return post(0, 0, [=]() { (obj->*method)(args...); });
+	}
+
+	template <typename F>
+	int call_in(int ms, F f)
+	{
+		return post(ms, 0, std::function<void()>(f));
+	}
+
+	template <typename T, typename M, typename... A>
+	int call_in(int ms, T *obj, M method, A... args)
+	{
+		return post(ms, 0, [=]() { (obj->*method)(args...); });
+	}
+
+	template <typename F>
+	int call_every(int ms, F f)
+	{
+		return post(ms, ms, std::function<void()>(f));
+	}
+
+	template <typename T, typename M, typename... A>
+	int call_every(int ms, T *obj, M method, A... args)
+	{
+		return post(ms, ms, [=]() { (obj->*method)(args...); });
+	}
+
+	void cancel(int id)
+	{
+		for (std::multimap<uint64_t, Event>::iterator it = _events.begin(); it != _events.end(); ++it) {
+			if (it->second.id == id) {
+				_events.erase(it);
+				return;
+			}
+		}
+	}
+
+	/**
+	 * @brief  Run the events due in the next ms milliseconds of simulated time
+	 *
+	 * @param  ms the time to dispatch for, negative to dispatch forever
+	 * @retval None
+	 */
+	void dispatch(int ms = -1)
+	{
+		uint64_t deadline = HostClock::base_us() + (uint64_t)ms * 1000;
+
+		_break = false;
+		while (!_break) {
+			if (_events.empty() || (ms >= 0 && _events.begin()->first > deadline)) {
+				if (ms < 0) {
+					return;
+				}
+				advance(deadline);
+				return;
+			}
+			std::multimap<uint64_t, Event>::iterator it = _events.begin();
+			Event event = it->second;
+			_events.erase(it);
+			advance(event.due_us);
+
+			if (event.period_ms > 0) {
+				event.due_us += (uint64_t)event.period_ms * 1000;
+				_events.insert(std::make_pair(event.due_us, event));
+			}
+			run(event);
+		}
+	}
+
+	void dispatch_forever()
+	{
+		dispatch(-1);
+	}
+
+	void break_dispatch()
+	{
+		_break = true;
+	}
+
+private:
+	struct Event {
+		int id;
+		uint64_t due_us;
+		int period_ms;
+		std::function<void()> function;
+	};
+
+	int post(int delay_ms, int period_ms, std::function<void()> function)
+	{
+		Event event;
+
+		event.id = _next_id++;
+		event.due_us = HostClock::now_us() + (uint64_t)delay_ms * 1000;
+		event.period_ms = period_ms;
+		event.function = function;
+		_events.insert(std::make_pair(event.due_us, event));
+		return event.id;
+	}
+
+	void advance(uint64_t to_us)
+	{
+		uint64_t now = HostClock::base_us();
+
+		if (to_us > now) {
+			if (_idle) {
+				_idle(_idle_context, (uint32_t)(to_us - now));
+			}
+			HostClock::base_us() = to_us;
+		}
+	}
+
+	void run(const Event &event)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		uint64_t busy_us;
+
+		HostClock::handler_start() = &start;
+		event.function();
+		HostClock::handler_start() = NULL;
+
+		/* The sensor kept sampling while the handler ran */
+		busy_us = HostClock::elapsed_us(start);
+		advance(HostClock::base_us() + busy_us);
+	}
+
+	std::multimap<uint64_t, Event> _events;
+	idle_t _idle;
+	void *_idle_context;
+	int _next_id;
+	bool _break;
+};
+
+#endif
@@ -0,0 +1,246 @@
+/**
+*******************************************************************************
+* @file   main.cpp
+* @brief  Event-driven acquisition runtime on host, against the simulator
+*******************************************************************************
+* Runs the firmware EventLoop, StrumTrigger and Acquisition on a PC. The
+* LSM6DSL is replaced by LSM6DSLSimulator fed by StrumSynth, with a strum
+* every 1.5 s. The FIFO is drained every DRAIN_PERIOD_MS as on a board
+* without INT1 wired.
+*
+* Build (from this directory):
+*   g++ -std=c++11 -O2 -I. -I../../src -I../../lib/lsm6dsl -I../../lib/lsm6dsl/Sim \
+*       main.cpp ../../src/EventLoop.cpp ../../src/StrumTrigger.cpp \
+*       ../../src/RuntimeConfig.cpp ../../src/StreamWindow.cpp ../../src/OnsetAlign.cpp \
+*       ../../src/Telemetry.cpp ../../src/SyncClock.cpp ../../src/GoertzelBank.cpp \
+*       -o host_runtime
+*
+* Usage: host_runtime [-t] [seconds [cpu_scale]]
+*        host_runtime -i [cpu_scale]
+*   cpu_scale: target/host speed ratio applied to handler execution times
+*   -t: telemetry frames on stdout every TELEMETRY_PERIOD_MS, as sent by the
+*       firmware, e.g. host_runtime -t 60 | telemetry_decode.py -
+*   -i: commands read from stdin, one per line, as sent to the firmware
+*       SET K=V.. : same as the firmware, applied between windows
+*       GET       : same as the firmware
+*       RUN ms    : simulate ms milliseconds, then report the windows
+*                   captured and the strums played meanwhile
+*       QUIT
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "HostEventQueue.h"
+#include "LSM6DSLSensorT.h"
+#include "LSM6DSLSimulator.h"
+#include "StrumSynth.h"
+#include "StrumTrigger.h"
+#include "Acquisition.h"
+#include "EventLoop.h"
+#include "RuntimeConfig.h"
+#include "Telemetry.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+#define DATA_INPUT_USER 		1024
+#define AXIS_NUMBER 			3
+#define MINI 					5
+#define THRESH					1.4
+#define NOISE					0.15
+#define DRAIN_PERIOD_MS			20
+#define TELEMETRY_PERIOD_MS		1000
+
+#define ODR_HZ					3330.0f
+#define FS_G					4.0f
+#define COMMAND_LENGTH			64
+#define STRUM_PERIOD_S			1.5f
+#define SYNTH_SEED				1
+
+typedef LSM6DSLSensorT<LSM6DSLSimBus> SimSensor;
+
+/* Variables -----------------------------------------------------------------*/
+
+LSM6DSLSimulator sim;
+StrumSynth synth(SYNTH_SEED);
+LSM6DSLSimBus bus(sim);
+SimSensor lsm6dsl(bus);
+EventQueue queue;
+EventLoop loop(&queue);
+StrumTrigger trigger(MINI, THRESH, NOISE);
+float data_user[AXIS_NUMBER * DATA_INPUT_USER];
+Acquisition<SimSensor> acquisition(&lsm6dsl, &trigger, data_user, DATA_INPUT_USER);
+const RuntimeConfig default_config = { MINI, THRESH, NOISE, DATA_INPUT_USER, ODR_HZ, FS_G };
+ConfigStage config(default_config, DATA_INPUT_USER, false);
+uint32_t windows = 0;
+Telemetry telemetry;
+
+/********************************* Functions *********************************/
+
+void sim_idle(void *context, uint32_t us)
+{
+	((LSM6DSLSimulator *)context)->advance_us(us);
+}
+
+void apply_config()
+{
+	const RuntimeConfig &staged = config.staged();
+	float sensitivity = 0;
+
+	if (config.sensor_changed()) {
+		if (lsm6dsl.set_x_odr_fs(staged.odr, staged.fs) != 0) {
+			printf("SET failed\n");
+			return;
+		}
+		lsm6dsl.get_x_sensitivity(&sensitivity);
+		acquisition.set_sensitivity(sensitivity);
+		synth.set_format(staged.odr, staged.fs);
+	}
+	trigger.configure(staged.mini, staged.thresh, staged.noise);
+	acquisition.set_window_samples(staged.window);
+	config.commit();
+	printf("SET applied\n");
+}
+
+void next_window()
+{
+	if (config.pending()) {
+		apply_config();
+	}
+	acquisition.rearm();
+}
+
+void fifo_drain()
+{
+	if (acquisition.drain()) {
+		windows++;
+		telemetry.add(TELEMETRY_WINDOWS);
+		next_window();
+	}
+}
+
+/* Same frame as the firmware, the counters of the simulated target only */
+void telemetry_emit()
+{
+	uint8_t frame[Telemetry::FRAME_MAX];
+	EventLoopStats totals;
+	size_t length;
+
+	loop.get_totals(&totals);
+	telemetry.set(TELEMETRY_SAMPLES, acquisition.samples());
+	telemetry.peak(TELEMETRY_FIFO_PEAK, acquisition.take_fifo_peak());
+	telemetry.set(TELEMETRY_EVENTS, totals.events);
+	telemetry.set(TELEMETRY_BUSY_US, totals.busy_us);
+	length = telemetry.encode(frame, sizeof(frame), us_ticker_read());
+	fwrite(frame, 1, length, stdout);
+}
+
+/**
+ * @brief  Run the commands read from stdin, see the usage above
+ *
+ * @param  None
+ * @retval None
+ */
+void interactive()
+{
+	char command[COMMAND_LENGTH], line[COMMAND_LENGTH + 32];
+	uint32_t start_windows, start_strums, start_samples;
+	EventLoopStats stats;
+	size_t length;
+	int ms;
+
+	while (fgets(command, sizeof(command), stdin)) {
+		length = strcspn(command, "\r\n");
+		command[length] = '\0';
+
+		if (strncmp(command, "SET ", 4) == 0) {
+			if (!config.stage(command + 4)) {
+				printf("SET error: %s\n", config.error());
+			} else if (!config.pending()) {
+				printf("SET unchanged\n");
+			} else if (!acquisition.capturing()) {
+				next_window();
+			} else {
+				printf("SET staged\n");
+			}
+		} else if (strcmp(command, "GET") == 0) {
+			config.print(line, sizeof(line), config.active());
+			printf("GET %s\n", line);
+			if (config.pending()) {
+				config.print(line, sizeof(line), config.staged());
+				printf("GET staged %s\n", line);
+			}
+		} else if (sscanf(command, "RUN %d", &ms) == 1 && ms > 0) {
+			start_windows = windows;
+			start_strums = synth.strums();
+			start_samples = acquisition.samples();
+			loop.reset_stats();
+			queue.dispatch(ms);
+			loop.get_stats(&stats);
+			printf("RUN ms=%d windows=%lu strums=%lu samples=%lu duty=%.3f%%\n", ms,
+			       (unsigned long)(windows - start_windows), (unsigned long)(synth.strums() - start_strums),
+			       (unsigned long)(acquisition.samples() - start_samples),
+			       stats.elapsed_us ? 100.0 * stats.busy_us / stats.elapsed_us : 0.0);
+		} else if (strcmp(command, "QUIT") == 0) {
+			break;
+		} else if (length > 0) {
+			printf("ERROR unknown command\n");
+		}
+		/* Line by line answers for scripts driving a pipe */
+		fflush(stdout);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bool frames = (argc > 1 && strcmp(argv[1], "-t") == 0);
+	bool script;
+	float seconds, sensitivity = 0;
+	EventLoopStats stats;
+
+	if (frames) {
+		argc--;
+		argv++;
+	}
+	script = (argc > 1 && strcmp(argv[1], "-i") == 0);
+	seconds = (argc > 1 && !script) ? (float)atof(argv[1]) : 60.0f;
+	if (argc > 2) {
+		queue.set_cpu_scale(atof(argv[2]));
+	}
+	synth.set_interval(STRUM_PERIOD_S, STRUM_PERIOD_S);
+	synth.set_format(ODR_HZ, FS_G);
+	sim.set_source(&StrumSynth::source, &synth);
+	queue.set_idle(&sim_idle, &sim);
+
+	lsm6dsl.init();
+	lsm6dsl.set_x_odr(ODR_HZ);
+	lsm6dsl.set_x_fs(FS_G);
+	lsm6dsl.enable_x();
+	lsm6dsl.get_x_sensitivity(&sensitivity);
+	acquisition.set_sensitivity(sensitivity);
+	lsm6dsl.enable_x_fifo();
+
+	loop.post_every(DRAIN_PERIOD_MS, callback(&fifo_drain));
+	if (frames) {
+		loop.post_every(TELEMETRY_PERIOD_MS, callback(&telemetry_emit));
+	}
+	if (script) {
+		interactive();
+		return 0;
+	}
+	loop.reset_stats();
+	sim.reset_counters();
+	queue.dispatch((int)(seconds * 1000));
+
+	loop.get_stats(&stats);
+	printf("simulated %.1f s: %lu samples, %lu windows, %lu events\n",
+	       stats.elapsed_us / 1e6, (unsigned long)acquisition.samples(), (unsigned long)windows,
+	       (unsigned long)stats.events);
+	printf("busy %lu us, duty %.3f%%, %lu bus transactions, %lu bytes\n",
+	       (unsigned long)stats.busy_us, stats.elapsed_us ? 100.0 * stats.busy_us / stats.elapsed_us : 0.0,
+	       (unsigned long)sim.transactions(), (unsigned long)sim.bytes());
+	return 0;
+}
@@ -0,0 +1,154 @@
+#!/usr/bin/env python
+"""
+*******************************************************************************
+* @file   map_report.py
+* @brief  RAM and flash usage per module, from a GCC_ARM linker map
+*******************************************************************************
+* Sums the input sections of the map file by object file, then by module: the
+* object path truncated to --depth directories, or the library for archive
+* members. Flash counts code, read-only data and the initial values of .data,
+* RAM counts .data, .bss and the heap/stack reservations.
+*
+* Usage (from the project root, after "mbed compile -t GCC_ARM"):
+*   python tools/map_report/map_report.py BUILD/<TARGET>/GCC_ARM/<project>.map
+*   python tools/map_report/map_report.py --depth 3 --sort flash <map>
+*   python tools/map_report/map_report.py --ram-limit 20480 <map>
+*
+* Exits with status 1 when --ram-limit or --flash-limit is exceeded.
+*******************************************************************************
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# Input section prefixes and the memories they use
+FLASH_SECTIONS = ('.text', '.rodata', '.ARM.exidx', '.ARM.extab', '.init', '.fini',
+                  '.isr_vector', '.constdata', '.glue_7', '.vfp11_veneer', '.v4_bx')
+DATA_SECTIONS = ('.data',)
+RAM_SECTIONS = ('.bss', 'COMMON', '.heap', '.stack', '.noinit')
+
+# " .text.foo  0x08000194  0x5c  obj" or the name alone, values on the next line
+SECTION_LINE = re.compile(r'^ (\S+)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+))?$')
+VALUES_LINE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+)$')
+ARCHIVE_MEMBER = re.compile(r'^(.+\.a)\((.+)\)$')
+
+
+def memory_of(section):
+    """Return 'flash', 'data' or 'ram' for an input section name, None to skip"""
+    for prefix in FLASH_SECTIONS:
+        if section == prefix or section.startswith(prefix + '.'):
+            return 'flash'
+    for prefix in DATA_SECTIONS:
+        if section == prefix or section.startswith(prefix + '.'):
+            return 'data'
+    for prefix in RAM_SECTIONS:
+        if section == prefix or section.startswith(prefix + '.'):
+            return 'ram'
+    return None
+
+
+def module_of(obj, depth):
+    """Group an object file path into a module name"""
+    member = ARCHIVE_MEMBER.match(obj)
+    if member:
+        return os.path.basename(member.group(1))
+    path = obj.replace('\\', '/')
+    parts = [p for p in path.split('/') if p not in ('', '.')]
+    # Drop the BUILD/<target>/<toolchain> prefix of mbed-cli builds
+    if parts and parts[0] == 'BUILD':
+        parts = parts[3:]
+    if len(parts) <= 1:
+        return parts[0] if parts else obj
+    return '/'.join(parts[:min(depth, len(parts) - 1)])
+
+
+def parse_map(lines):
+    """Yield (section, size, object) for each input section of the memory map"""
+    in_map = False
+    pending = None
+
+    for line in lines:
+        line = line.rstrip('\r\n')
+        if not in_map:
+            in_map = line.startswith('Linker script and memory map')
+            continue
+        if line.startswith('/DISCARD/'):
+            break
+
+        if pending is not None:
+            values = VALUES_LINE.match(line)
+            pending_name, pending = pending, None
+            if values:
+                yield pending_name, int(values.group(2), 16), values.group(3).strip()
+                continue
+
+        match = SECTION_LINE.match(line)
+        if not match:
+            continue
+        name = match.group(1)
+        if name.startswith('*'):
+            # *fill* and linker script patterns
+            continue
+        if match.group(2) is None:
+            # Long section name, address and size follow on the next line
+            pending = name
+            continue
+        yield name, int(match.group(3), 16), match.group(4).strip()
+
+
+def report(path, depth):
+    """Return {module: [flash, ram]} in bytes"""
+    modules = {}
+    with open(path) as map_file:
+        for section, size, obj in parse_map(map_file):
+            memory = memory_of(section)
+            if memory is None or size == 0:
+                continue
+            usage = modules.setdefault(module_of(obj, depth), [0, 0])
+            if memory in ('flash', 'data'):
+                usage[0] += size
+            if memory in ('ram', 'data'):
+                usage[1] += size
+    return modules
+
+
+def main():
+    parser = argparse.ArgumentParser(description='RAM and flash usage per module from a GNU ld map file')
+    parser.add_argument('map', help='linker map file')
+    parser.add_argument('--depth', type=int, default=2, help='directory levels kept in module names (default 2)')
+    parser.add_argument('--sort', choices=('ram', 'flash', 'name'), default='ram', help='sort order (default ram)')
+    parser.add_argument('--ram-limit', type=int, help='fail when the total RAM usage exceeds this many bytes')
+    parser.add_argument('--flash-limit', type=int, help='fail when the total flash usage exceeds this many bytes')
+    args = parser.parse_args()
+
+    modules = report(args.map, args.depth)
+    if args.sort == 'name':
+        order = sorted(modules)
+    else:
+        column = 0 if args.sort == 'flash' else 1
+        order = sorted(modules, key=lambda m: (-modules[m][column], m))
+
+    width = max([len(m) for m in modules] + [len('Module')])
+    print('%-*s %10s %10s' % (width, 'Module', 'Flash', 'RAM'))
+    print('-' * (width + 22))
+    for module in order:
+        print('%-*s %10d %10d' % (width, module, modules[module][0], modules[module][1]))
+    flash = sum(usage[0] for usage in modules.values())
+    ram = sum(usage[1] for usage in modules.values())
+    print('-' * (width + 22))
+    print('%-*s %10d %10d' % (width, 'Total', flash, ram))
+
+    status = 0
+    if args.ram_limit is not None and ram > args.ram_limit:
+        sys.stderr.write('RAM usage %d exceeds the %d bytes limit\n' % (ram, args.ram_limit))
+        status = 1
+    if args.flash_limit is not None and flash > args.flash_limit:
+        sys.stderr.write('Flash usage %d exceeds the %d bytes limit\n' % (flash, args.flash_limit))
+        status = 1
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
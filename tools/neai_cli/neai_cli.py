@@ -0,0 +1,199 @@
+#!/usr/bin/env python
+"""
+*******************************************************************************
+* @file   neai_cli.py
+* @brief  Acquisition parameters changed at runtime, on the board or simulator
+*******************************************************************************
+* Sends the SET and GET commands of the firmware serial port, see
+* serial_command() in src/main.cpp, either to a board or to the host runtime
+* (tools/host_runtime, -i mode) running the same code against the simulator.
+* A sweep stages each value in turn, lets the acquisition run, then reports
+* the windows captured: the simulator also reports the strums it played.
+*
+* Usage (from the project root):
+*   python tools/neai_cli/neai_cli.py --port /dev/ttyACM0 get
+*   python tools/neai_cli/neai_cli.py --port /dev/ttyACM0 set THRESH=1.6 NOISE=0.1
+*   python tools/neai_cli/neai_cli.py --sim tools/host_runtime/host_runtime \
+*       sweep THRESH=1.1,1.2,1.4,1.8 --run-ms 10000 --with MINI=8
+*
+* The board transport needs pyserial. Board sweeps count the lines printed
+* between replies, one per window in both firmware modes.
+*******************************************************************************
+"""
+
+import argparse
+import select
+import subprocess
+import sys
+import time
+
+# First words of the replies to commands, other lines are window outputs
+REPLIES = ('SET', 'GET', 'STATS', 'FIFO', 'CAL', 'TEMP', 'SENSORS', 'SPI', 'RUN', 'ERROR', 'TELEMETRY', 'NEAI', 'POSE')
+
+# First words of lines that are neither replies nor window outputs
+NOTES = ('MARK', 'SYNC', 'GATE', 'NOTES')
+
+# First byte of the binary telemetry frames, see src/Telemetry.h
+TELEMETRY_SYNC = 0xA5
+
+
+class SimTransport(object):
+    """host_runtime -i through a pipe, simulated time only runs on RUN"""
+
+    def __init__(self, path):
+        self.process = subprocess.Popen([path, '-i'], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                        universal_newlines=True)
+
+    def command(self, line, expected=1):
+        self.process.stdin.write(line + '\n')
+        self.process.stdin.flush()
+        return [self.process.stdout.readline().rstrip('\n') for _ in range(expected)]
+
+    def readline(self, timeout):
+        """Optional reply line, None if nothing comes within timeout"""
+        ready, _, _ = select.select([self.process.stdout], [], [], timeout)
+        return self.process.stdout.readline().rstrip('\n') if ready else None
+
+    def run(self, ms):
+        """Return (windows, strums) over ms of simulated time"""
+        fields = dict(item.split('=', 1) for item in self.command('RUN %d' % ms)[0].split()[1:])
+        return int(fields['windows']), int(fields['strums'])
+
+    def close(self):
+        self.process.stdin.write('QUIT\n')
+        self.process.stdin.close()
+        self.process.wait()
+
+
+class SerialTransport(object):
+    """Board serial port, the acquisition runs in real time"""
+
+    def __init__(self, port, baud):
+        import serial
+        self.port = serial.Serial(port, baud, timeout=0.1)
+        self.windows = 0
+
+    def readline(self, timeout):
+        """Next reply line, window outputs are counted and skipped"""
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            line = self.text_line()
+            if not line:
+                continue
+            if line.split()[0] in REPLIES:
+                return line
+            if line.split()[0] not in NOTES:
+                self.windows += 1
+        return None
+
+    def text_line(self):
+        """Next line, or what came before the timeout, telemetry frames left out"""
+        line = bytearray()
+        while True:
+            byte = bytearray(self.port.read(1))
+            if not byte or byte == b'\n':
+                return line.decode('ascii', 'replace').strip()
+            if byte[0] == TELEMETRY_SYNC:
+                # Version, sequence and payload length, then payload and CRC
+                header = bytearray(self.port.read(3))
+                if len(header) == 3:
+                    self.port.read(header[2] + 2)
+                continue
+            line += byte
+
+    def command(self, line, expected=1):
+        self.port.write((line + '\n').encode('ascii'))
+        replies = []
+        for _ in range(expected):
+            reply = self.readline(2.0)
+            if reply is None:
+                break
+            replies.append(reply)
+        return replies
+
+    def run(self, ms):
+        """Return (windows, None) over ms of real time"""
+        self.windows = 0
+        self.readline(ms / 1000.0)
+        return self.windows, None
+
+    def close(self):
+        self.port.close()
+
+
+def set_values(transport, assignments):
+    """Stage assignments, return the reply, 'SET applied' once active"""
+    reply = transport.command('SET ' + ' '.join(assignments))
+    return reply[0] if reply else 'SET no reply'
+
+
+def get_values(transport):
+    replies = transport.command('GET')
+    # A second line follows when a configuration is staged
+    staged = transport.readline(0.2)
+    if staged is not None:
+        replies.append(staged)
+    return replies
+
+
+def sweep(transport, key, values, fixed, run_ms, settle_ms):
+    print('%-10s %8s %8s' % (key, 'windows', 'strums'))
+    status = 0
+    for value in values:
+        reply = set_values(transport, fixed + ['%s=%s' % (key, value)])
+        if not reply.startswith('SET applied') and not reply.startswith('SET unchanged') \
+                and not reply.startswith('SET staged'):
+            sys.stderr.write('%s=%s: %s\n' % (key, value, reply))
+            status = 1
+            continue
+        # The first window may still use the previous values when staged
+        if settle_ms:
+            transport.run(settle_ms)
+        windows, strums = transport.run(run_ms)
+        print('%-10s %8d %8s' % (value, windows, '-' if strums is None else strums))
+    return status
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Change the acquisition parameters at runtime')
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument('--port', help='board serial port')
+    target.add_argument('--sim', help='host_runtime executable')
+    parser.add_argument('--baud', type=int, default=115200, help='serial baud rate (default 115200)')
+    commands = parser.add_subparsers(dest='command')
+    commands.add_parser('get', help='print the active configuration')
+    set_parser = commands.add_parser('set', help='stage KEY=VALUE assignments')
+    set_parser.add_argument('assignments', nargs='+')
+    sweep_parser = commands.add_parser('sweep', help='run with each value of KEY=V1,V2,..')
+    sweep_parser.add_argument('values', help='KEY=V1,V2,..')
+    sweep_parser.add_argument('--with', dest='fixed', action='append', default=[],
+                              help='KEY=VALUE set along with each value')
+    sweep_parser.add_argument('--run-ms', type=int, default=10000, help='run time per value (default 10000)')
+    sweep_parser.add_argument('--settle-ms', type=int, default=2000,
+                              help='run time before counting, per value (default 2000)')
+    args = parser.parse_args()
+    if args.command is None:
+        parser.error('a command is required')
+
+    transport = SimTransport(args.sim) if args.sim else SerialTransport(args.port, args.baud)
+    status = 0
+    try:
+        if args.command == 'get':
+            for line in get_values(transport):
+                print(line)
+        elif args.command == 'set':
+            reply = set_values(transport, args.assignments)
+            print(reply)
+            status = 0 if 'error' not in reply else 1
+        else:
+            key, _, values = args.values.partition('=')
+            if not values:
+                parser.error('sweep values expected as KEY=V1,V2,..')
+            status = sweep(transport, key, values.split(','), args.fixed, args.run_ms, args.settle_ms)
+    finally:
+        transport.close()
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,206 @@
+/**
+*******************************************************************************
+* @file   note_check.cpp
+* @brief  Notes of each window from the Goertzel bank, against the simulator
+*******************************************************************************
+* First, the amplitudes of the bank are compared with a DFT in double
+* precision at the frequency of each note, over windows taken at random
+* offsets within captures of StrumSynth strums, as the acquisition takes the
+* aligned window within a longer capture.
+*
+* Then each chord of StrumSynth is played in turn through the firmware
+* Acquisition on LSM6DSLSensorT over the simulated bus, with the strum
+* trigger, the alignment and the bank on z as in main.cpp with NOTE_BANK.
+* The notes that sounded in each window, see GoertzelBank::sounded(), are
+* compared with those of the chord: found when all of them sounded, with
+* the notes that sounded beyond them counted as extra.
+*
+* The check fails, exit status 1, when the bank is off the DFT by more than
+* 1e-4 of the strongest note, or finds less than 90% of the chords.
+*
+* Build (from this directory):
+*   g++ -std=c++11 -O2 -I../../src -I../../lib/lsm6dsl -I../../lib/lsm6dsl/Sim \
+*       note_check.cpp ../../src/StrumTrigger.cpp ../../src/StreamWindow.cpp \
+*       ../../src/OnsetAlign.cpp ../../src/SyncClock.cpp ../../src/GoertzelBank.cpp \
+*       -o note_check
+*
+* Usage: note_check [seconds] [ratio] [floor]
+*   seconds: simulated duration per chord, 30 by default
+*   ratio, floor: of GoertzelBank::sounded(), 0.25 and 0.002 g by default,
+*   NOTE_RATIO and NOTE_FLOOR of main.cpp
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "LSM6DSLSensorT.h"
+#include "LSM6DSLSimulator.h"
+#include "StrumSynth.h"
+#include "StrumTrigger.h"
+#include "OnsetAlign.h"
+#include "GoertzelBank.h"
+#include "Acquisition.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define WINDOW					1024
+#define ODR_HZ					3330.0f
+#define FS_G					4.0f
+#define DRAIN_PERIOD_MS			20
+#define MINI					5
+#define THRESH					1.4f
+#define NOISE					0.15f
+#define ALIGN_PRE				24
+#define ALIGN_SEARCH			64
+#define FRETS					12
+#define AXIS					2
+#define ACCURACY_WINDOWS		50
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef LSM6DSLSensorT<LSM6DSLSimBus> SimSensor;
+
+/********************************* Functions *********************************/
+
+/* Largest error of the bank against a DFT, relative to the strongest note */
+static double accuracy(uint32_t seed)
+{
+	GoertzelBank bank(ODR_HZ, FRETS);
+	StrumSynth synth(seed);
+	std::vector<float> capture(3 * (WINDOW + ALIGN_SEARCH + 1));
+	uint16_t samples = (uint16_t)(capture.size() / 3), start;
+	double worst = 0.0;
+
+	for (int w = 0; w < ACCURACY_WINDOWS; w++) {
+		double dft[GOERTZEL_NOTES_MAX], strongest = 0.0;
+
+		while (!synth.next(&capture[0])) {
+		}
+		bank.reset();
+		bank.push(capture[AXIS]);
+		for (uint16_t n = 1; n < samples; n++) {
+			synth.next(&capture[3 * n]);
+			bank.push(capture[3 * n + AXIS]);
+		}
+		start = (uint16_t)(rand() % (samples - WINDOW + 1));
+		bank.window(&capture[AXIS], 3, start, WINDOW);
+
+		for (uint8_t k = 0; k < bank.notes(); k++) {
+			double w_k = 2.0 * M_PI * 440.0 * pow(2.0, (bank.note(k) - 69) / 12.0) / ODR_HZ, re = 0.0, im = 0.0;
+
+			for (uint16_t n = 0; n < WINDOW; n++) {
+				re += capture[3 * (start + n) + AXIS] * cos(w_k * n);
+				im -= capture[3 * (start + n) + AXIS] * sin(w_k * n);
+			}
+			dft[k] = 2.0 * sqrt(re * re + im * im) / WINDOW;
+			strongest = (dft[k] > strongest) ? dft[k] : strongest;
+		}
+		for (uint8_t k = 0; k < bank.notes(); k++) {
+			double error = fabs(bank.amplitudes()[k] - dft[k]) / strongest;
+
+			worst = (error > worst) ? error : worst;
+		}
+	}
+
+	return worst;
+}
+
+/* Notes of a chord, bits of GoertzelBank::sounded() */
+static uint32_t chord_notes(uint8_t chord)
+{
+	const int8_t *frets = StrumSynth::chord_frets(chord);
+	uint32_t notes = 0;
+
+	for (uint8_t s = 0; s < StrumSynth::STRINGS; s++) {
+		notes |= (uint32_t)1 << (GoertzelBank::open_string(s) + frets[s] - GOERTZEL_LOWEST);
+	}
+	return notes;
+}
+
+/* Names separated by commas, - for none */
+static void print_notes(const GoertzelBank &bank, uint32_t notes)
+{
+	const char *separator = "";
+	char name[5];
+
+	for (uint8_t k = 0; k < bank.notes(); k++) {
+		if (notes & ((uint32_t)1 << k)) {
+			GoertzelBank::name(bank.note(k), name);
+			printf("%s%s", separator, name);
+			separator = ",";
+		}
+	}
+	if (!notes) {
+		printf("-");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = (argc > 1) ? atof(argv[1]) : 30.0;
+	float ratio = (argc > 2) ? (float)atof(argv[2]) : 0.25f;
+	float floor_g = (argc > 3) ? (float)atof(argv[3]) : 0.002f;
+	double worst = accuracy(1);
+	unsigned windows = 0, found = 0, extra = 0;
+
+	printf("accuracy windows=%d worst_error=%.2e\n", ACCURACY_WINDOWS, worst);
+
+	for (uint8_t chord = 0; chord < StrumSynth::CHORDS; chord++) {
+		LSM6DSLSimulator sim;
+		LSM6DSLSimBus bus(sim);
+		SimSensor lsm6dsl(bus);
+		StrumSynth synth(chord + 1);
+		StrumTrigger trigger(MINI, THRESH, NOISE);
+		OnsetAligner aligner(ALIGN_PRE, ALIGN_SEARCH);
+		GoertzelBank bank(ODR_HZ, FRETS);
+		std::vector<float> window(3 * (WINDOW + ALIGN_SEARCH + 1));
+		Acquisition<SimSensor> acquisition(&lsm6dsl, &trigger, window.data(), (uint16_t)(WINDOW + ALIGN_SEARCH + 1));
+		uint32_t expected = chord_notes(chord), sounded = 0;
+		unsigned chord_windows = 0, chord_found = 0, chord_extra = 0;
+		float sensitivity = 0;
+
+		synth.set_chord((int8_t)chord);
+		sim.set_source(&StrumSynth::source, &synth);
+		lsm6dsl.init();
+		lsm6dsl.set_x_odr(ODR_HZ);
+		lsm6dsl.set_x_fs(FS_G);
+		lsm6dsl.enable_x();
+		lsm6dsl.get_x_sensitivity(&sensitivity);
+		lsm6dsl.enable_x_fifo();
+		acquisition.set_sensitivity(sensitivity);
+		acquisition.set_window_samples(WINDOW);
+		acquisition.set_aligner(&aligner);
+		acquisition.set_bank(&bank, AXIS);
+
+		while (sim.now_us() < seconds * 1e6) {
+			bus.delay_us(DRAIN_PERIOD_MS * 1000);
+			if (!acquisition.drain()) {
+				continue;
+			}
+			sounded = bank.sounded(ratio, floor_g);
+			chord_windows++;
+			chord_found += ((sounded & expected) == expected);
+			chord_extra += (sounded & ~expected) != 0;
+			acquisition.rearm();
+		}
+		printf("chord=%u notes=", (unsigned)chord);
+		print_notes(bank, expected);
+		printf(" windows=%u found=%u extra=%u last=", chord_windows, chord_found, chord_extra);
+		print_notes(bank, sounded);
+		printf("\n");
+		windows += chord_windows;
+		found += chord_found;
+		extra += chord_extra;
+	}
+
+	printf("windows=%u found=%u extra=%u\n", windows, found, extra);
+	if (worst > 1e-4 || windows == 0 || found < 0.9 * windows) {
+		printf("FAIL\n");
+		return 1;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,170 @@
+/**
+*******************************************************************************
+* @file   strum_synth.cpp
+* @brief  Synthetic captures of strums, for trigger_sweep and load tests
+*******************************************************************************
+* Writes StrumSynth samples as a trigger_sweep capture: raw little-endian
+* float x, y, z triplets in g, quantized and clipped as the sensor output at
+* the given full scale, and the .labels file of strum onsets. The same seed
+* and options always produce the same files.
+*
+* Build (from this directory):
+*   g++ -std=c++11 -O2 -I../../lib/lsm6dsl/Sim strum_synth.cpp -o strum_synth
+*
+* Usage: strum_synth [options] capture
+*   --strums N        stop after N strums        (default 100)
+*   --seconds S       stop after S seconds, whichever comes first
+*   --seed N          random sequence            (default 1)
+*   --odr HZ          sample rate                (default 3330)
+*   --fs G            full scale, 2 4 8 or 16    (default 4)
+*   --interval A:B    seconds between strums     (default 1:2.5)
+*   --velocity A:B    string amplitude in g      (default 0.1:0.5)
+*   --pitch DEG, --roll DEG  orientation         (default 20, 10)
+*   --noise UG        noise density, ug/sqrt(Hz) (default 130)
+*   --chord N         chord index only, 0 to 7   (default random)
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "StrumSynth.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define BLOCK_SAMPLES			4096
+
+/********************************* Functions *********************************/
+
+bool parse_pair(const char *text, float *first, float *second)
+{
+	char *end;
+
+	*first = strtof(text, &end);
+	if (*end != ':') {
+		return false;
+	}
+	*second = strtof(end + 1, &end);
+	return *end == '\0';
+}
+
+void usage(void)
+{
+	fprintf(stderr, "usage: strum_synth [--strums N] [--seconds S] [--seed N] [--odr HZ] [--fs G]\n"
+	        "                   [--interval A:B] [--velocity A:B] [--pitch DEG] [--roll DEG]\n"
+	        "                   [--noise UG] [--chord N] capture\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	static float block[3 * BLOCK_SAMPLES];
+	const char *path = NULL;
+	char labels_path[4096];
+	uint32_t strums = 100, seed = 1;
+	int chord = -1;
+	float seconds = 0.0f, odr = 3330.0f, fs = 4.0f, pitch = 20.0f, roll = 10.0f, noise = 130.0f;
+	float interval[2] = { 1.0f, 2.5f }, velocity[2] = { 0.1f, 0.5f };
+	float scale;
+	uint64_t limit, written = 0;
+	int16_t raw[3];
+	FILE *capture, *labels;
+	size_t n;
+
+	for (int i = 1; i < argc; i++) {
+		const char *option = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (option[0] != '-') {
+			path = option;
+			continue;
+		}
+		if (!value) {
+			usage();
+		}
+		i++;
+		if (strcmp(option, "--strums") == 0) {
+			strums = (uint32_t)strtoul(value, NULL, 0);
+		} else if (strcmp(option, "--seconds") == 0) {
+			seconds = (float)atof(value);
+		} else if (strcmp(option, "--seed") == 0) {
+			seed = (uint32_t)strtoul(value, NULL, 0);
+		} else if (strcmp(option, "--odr") == 0) {
+			odr = (float)atof(value);
+		} else if (strcmp(option, "--fs") == 0) {
+			fs = (float)atof(value);
+		} else if (strcmp(option, "--interval") == 0) {
+			if (!parse_pair(value, &interval[0], &interval[1])) {
+				usage();
+			}
+		} else if (strcmp(option, "--velocity") == 0) {
+			if (!parse_pair(value, &velocity[0], &velocity[1])) {
+				usage();
+			}
+		} else if (strcmp(option, "--pitch") == 0) {
+			pitch = (float)atof(value);
+		} else if (strcmp(option, "--roll") == 0) {
+			roll = (float)atof(value);
+		} else if (strcmp(option, "--noise") == 0) {
+			noise = (float)atof(value);
+		} else if (strcmp(option, "--chord") == 0) {
+			chord = atoi(value);
+		} else {
+			usage();
+		}
+	}
+	if (!path || odr <= 0.0f || (fs != 2.0f && fs != 4.0f && fs != 8.0f && fs != 16.0f)) {
+		usage();
+	}
+
+	StrumSynth synth(seed);
+
+	synth.set_interval(interval[0], interval[1]);
+	synth.set_velocity(velocity[0], velocity[1]);
+	synth.set_orientation(pitch, roll);
+	synth.set_noise_density(noise);
+	synth.set_chord((int8_t)chord);
+	synth.set_format(odr, fs);
+	/* Back to g from the raw output, as Acquisition does */
+	scale = 0.061f * (fs / 2.0f) / 1000.0f;
+	limit = (seconds > 0.0f) ? (uint64_t)(seconds * odr) : UINT64_MAX;
+
+	snprintf(labels_path, sizeof(labels_path), "%s.labels", path);
+	capture = fopen(path, "wb");
+	labels = fopen(labels_path, "w");
+	if (!capture || !labels) {
+		fprintf(stderr, "%s: cannot write\n", capture ? labels_path : path);
+		return 1;
+	}
+
+	/* The last strum is written with its decay, up to the next onset */
+	for (;;) {
+		for (n = 0; n < BLOCK_SAMPLES && written + n < limit; n++) {
+			if (synth.next_raw(raw)) {
+				if (synth.strums() > strums) {
+					break;
+				}
+				fprintf(labels, "%llu\n", (unsigned long long)(written + n));
+			}
+			for (uint8_t i = 0; i < 3; i++) {
+				block[3 * n + i] = raw[i] * scale;
+			}
+		}
+		if (fwrite(block, 3 * sizeof(float), n, capture) != n) {
+			fprintf(stderr, "%s: write error\n", path);
+			return 1;
+		}
+		written += n;
+		if (n < BLOCK_SAMPLES) {
+			break;
+		}
+	}
+	fclose(capture);
+	fclose(labels);
+
+	printf("%s: %llu samples, %lu strums, %.1f s at %.0f Hz\n", path, (unsigned long long)written,
+	       (unsigned long)(synth.strums() > strums ? strums : synth.strums()), written / odr, odr);
+	return 0;
+}
@@ -0,0 +1,199 @@
+/**
+*******************************************************************************
+* @file   sync_check.cpp
+* @brief  Window times against a shared sync pulse, against the simulator
+*******************************************************************************
+* Runs the firmware Acquisition and SyncClock on LSM6DSLSensorT over the
+* simulated bus for two boards whose sensor clocks drift apart, each started
+* at its own time, as main.cpp with SYNC_EDGE: the pulse is stamped through
+* DEN on the x axis, active high, and the timestamp counter runs at 25 us.
+* Strums come from StrumSynth, windows are aligned on the attack peak and the
+* FIFO is reset between them.
+*
+* The y axis carries the number of each sample produced by the sensor
+* instead of the strums, one LSB per sample, so that the first sample of a
+* window, resampled by the alignment, is known to the fraction. Its true
+* time is compared with the one given by window_time(), counted from the
+* first sync edge seen by the board: both must match within a sample period,
+* the stamp placing each edge between two samples, and the edges must be
+* numbered the same way all along. The drift measured must match the clock
+* offset of the board.
+*
+* Build (from this directory):
+*   g++ -std=c++11 -O2 -I../../src -I../../lib/lsm6dsl -I../../lib/lsm6dsl/Sim \
+*       sync_check.cpp ../../src/StrumTrigger.cpp ../../src/StreamWindow.cpp \
+*       ../../src/OnsetAlign.cpp ../../src/SyncClock.cpp ../../src/GoertzelBank.cpp \
+*       -o sync_check
+*
+* Usage: sync_check [seconds] [ppm_a] [ppm_b]
+*   seconds: simulated duration of each board, 120 by default
+*   ppm_a, ppm_b: sensor clock offsets, 1500 and -2500 by default
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "LSM6DSLSensorT.h"
+#include "LSM6DSLSimulator.h"
+#include "StrumSynth.h"
+#include "StrumTrigger.h"
+#include "OnsetAlign.h"
+#include "SyncClock.h"
+#include "Acquisition.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define WINDOW					1024
+#define ODR_HZ					3330.0f
+#define FS_G					4.0f
+#define DRAIN_PERIOD_MS			20
+#define MINI					5
+#define THRESH					1.4f
+#define NOISE					0.15f
+#define ALIGN_PRE				24
+#define ALIGN_SEARCH			64
+#define SYNC_PERIOD_US			1000000
+#define SYNC_WIDTH_US			10000	/* Pulse width */
+#define SYNC_PHASE_US			370000	/* First edge, from the start of the sync source */
+#define COUNT_BASE				4000	/* y of sample 0, above the noise of the trigger */
+#define COUNT_WRAP				16384
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef LSM6DSLSensorT<LSM6DSLSimBus> SimSensor;
+
+typedef struct {
+	StrumSynth synth;
+	LSM6DSLSimulator *sim;
+	std::vector<double> produced;	/* True time of each sample */
+} Board;
+
+typedef struct {
+	unsigned windows;
+	unsigned timed;
+	double max_error_us;
+	double sum_error_us;
+	bool numbering;					/* Same first edge for all the windows */
+	float drift_ppm;
+} Result;
+
+/********************************* Functions *********************************/
+
+/* LSM6DSLSimulator source: strums on x and z, sample count on y, sync pulse on DEN */
+void produce(void *context, uint32_t index, int16_t *xl, int16_t *g)
+{
+	Board *board = (Board *)context;
+	double now = board->sim->now_us();
+
+	board->synth.next_raw(xl);
+	xl[1] = (int16_t)(COUNT_BASE + index % COUNT_WRAP);
+	board->produced.push_back(now);
+	board->sim->set_den(now >= SYNC_PHASE_US && fmod(now - SYNC_PHASE_US, SYNC_PERIOD_US) < SYNC_WIDTH_US);
+	g[0] = g[1] = g[2] = 0;
+}
+
+/* True time of a fractional sample number */
+static double true_time(const Board &board, double sample)
+{
+	size_t n = (size_t)sample;
+
+	if (n + 1 >= board.produced.size()) {
+		return board.produced.back();
+	}
+	return board.produced[n] + (sample - n) * (board.produced[n + 1] - board.produced[n]);
+}
+
+Result run(double ppm, double start_us, double seconds, uint32_t seed)
+{
+	LSM6DSLSimulator sim;
+	LSM6DSLSimBus bus(sim);
+	SimSensor lsm6dsl(bus);
+	Board board;
+	StrumTrigger trigger(MINI, THRESH, NOISE);
+	OnsetAligner aligner(ALIGN_PRE, ALIGN_SEARCH);
+	SyncClock sync(ODR_HZ, SYNC_PERIOD_US);
+	std::vector<float> window(3 * (WINDOW + ALIGN_SEARCH + 1));
+	Acquisition<SimSensor> acquisition(&lsm6dsl, &trigger, window.data(), (uint16_t)(WINDOW + ALIGN_SEARCH + 1));
+	Result result = { 0, 0, 0.0, 0.0, true, 0.0f };
+	float sensitivity = 0;
+	long first_edge = -1;
+	SyncTime_t time;
+
+	board.synth.reset(seed);
+	board.sim = &sim;
+	sim.set_clock_ppm(ppm);
+	sim.set_source(&produce, &board);
+	sim.advance_us(start_us);
+
+	lsm6dsl.init();
+	lsm6dsl.set_x_odr(ODR_HZ);
+	lsm6dsl.set_x_fs(FS_G);
+	lsm6dsl.enable_x();
+	lsm6dsl.get_x_sensitivity(&sensitivity);
+	lsm6dsl.enable_den_stamping(LSM6DSL_ACC_GYRO_DEN_X, LSM6DSL_ACC_GYRO_DEN_HIGH);
+	lsm6dsl.enable_timestamp();
+	lsm6dsl.enable_x_fifo();
+	acquisition.set_sensitivity(sensitivity);
+	acquisition.set_window_samples(WINDOW);
+	acquisition.set_aligner(&aligner);
+	acquisition.set_marker(0);
+	acquisition.set_sync(&sync);
+
+	while (sim.now_us() < start_us + seconds * 1e6) {
+		bus.delay_us(DRAIN_PERIOD_MS * 1000);
+		if (!acquisition.drain()) {
+			continue;
+		}
+		result.windows++;
+		if (acquisition.window_time(&time)) {
+			/* Sample number of the window start, the count wrapping */
+			double count = acquisition.window()[1] * 1000 / sensitivity - COUNT_BASE;
+			double last = (double)board.produced.size() - 1;
+			double sample = count + COUNT_WRAP * floor((last - count) / COUNT_WRAP);
+			double since_edge = true_time(board, sample) - SYNC_PHASE_US;
+			double reference = (double)time.edge * SYNC_PERIOD_US + time.offset_us;
+			long edge = lround((since_edge - reference) / SYNC_PERIOD_US);
+			double error = fabs(since_edge - reference - (double)edge * SYNC_PERIOD_US);
+
+			if (first_edge < 0) {
+				first_edge = edge;
+			}
+			result.numbering = result.numbering && (edge == first_edge);
+			result.timed++;
+			result.sum_error_us += error;
+			if (error > result.max_error_us) {
+				result.max_error_us = error;
+			}
+			result.drift_ppm = time.drift_ppm;
+		}
+		acquisition.rearm();
+	}
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = (argc > 1) ? atof(argv[1]) : 120.0;
+	double ppm[2] = { (argc > 2) ? atof(argv[2]) : 1500.0, (argc > 3) ? atof(argv[3]) : -2500.0 };
+	double start_us[2] = { 0.0, 2345678.0 };
+	double period_us = 1e6 / ODR_HZ;
+	bool pass = true;
+
+	for (int b = 0; b < 2; b++) {
+		Result result = run(ppm[b], start_us[b], seconds, (uint32_t)(b + 1));
+
+		printf("board=%c clock_ppm=%+.0f windows=%u timed=%u drift_ppm=%+.1f mean_error_us=%.1f max_error_us=%.1f numbering=%s\n",
+		       'a' + b, ppm[b], result.windows, result.timed, result.drift_ppm,
+		       result.timed ? result.sum_error_us / result.timed : 0.0, result.max_error_us, result.numbering ? "ok" : "broken");
+		/* All windows timed but those before the second edge */
+		pass = pass && result.timed + 2 >= result.windows && result.timed > 0 && result.numbering
+		       && result.max_error_us < period_us && fabs(result.drift_ppm - ppm[b]) < 50.0;
+	}
+	printf("%s\n", pass ? "PASS" : "FAIL");
+
+	return pass ? 0 : 1;
+}
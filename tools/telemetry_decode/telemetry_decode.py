@@ -0,0 +1,216 @@
+#!/usr/bin/env python
+"""
+*******************************************************************************
+* @file   telemetry_decode.py
+* @brief  Telemetry frames of the serial output turned into time series
+*******************************************************************************
+* Splits the serial output of the firmware, or of host_runtime -t, into its
+* text lines and the binary telemetry frames interleaved with them, see
+* src/Telemetry.h for the frame layout. Frames become CSV rows: the time
+* since the first frame, then one column per slot. Counters give their
+* increase over the frame period, or their rate per second with --rates,
+* gauges and peaks their value. The busy time also gives the duty cycle.
+*
+* Usage (from the project root):
+*   python tools/telemetry_decode/telemetry_decode.py --port /dev/ttyACM0 -o field.csv
+*   python tools/telemetry_decode/telemetry_decode.py capture.bin --rates
+*   tools/host_runtime/host_runtime -t 60 | python tools/telemetry_decode/telemetry_decode.py -
+*
+* Text lines go to stderr, or to --text. Frames failing their CRC are
+* counted and their bytes treated as text; sequence gaps are reported as
+* lost frames, the counts of a lost frame are missing from the series. The
+* serial transport needs pyserial.
+*******************************************************************************
+"""
+
+import argparse
+import sys
+
+SYNC = 0xA5
+VERSION = 1
+
+# TelemetryId_t order, (name, kind)
+SLOTS = (
+    ('samples', 'counter'),
+    ('windows', 'counter'),
+    ('lossy_windows', 'counter'),
+    ('lost_samples', 'counter'),
+    ('fifo_overruns', 'counter'),
+    ('fifo_peak', 'peak'),
+    ('capture_peak_us', 'peak'),
+    ('detections', 'counter'),
+    ('detect_us', 'counter'),
+    ('detect_peak_us', 'peak'),
+    ('similarity', 'gauge'),
+    ('events', 'counter'),
+    ('busy_us', 'counter'),
+    ('rx_bytes', 'counter'),
+    ('rx_dropped', 'counter'),
+)
+
+
+def crc16(data):
+    """CRC-16/CCITT, initial value 0xFFFF, as Telemetry.cpp"""
+    crc = 0xFFFF
+    for byte in bytearray(data):
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def varints(payload):
+    """Unsigned LEB128 values of a payload, None if one is cut"""
+    values = []
+    value = shift = 0
+    for byte in bytearray(payload):
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            values.append(value)
+            value = shift = 0
+    return values if shift == 0 else None
+
+
+def printable(data):
+    """Text of a line, without the bytes of a broken frame"""
+    return ''.join(chr(b) for b in bytearray(data) if 32 <= b < 127 or b == 9)
+
+
+class Splitter(object):
+    """Bytes in, text lines and frames out, as (kind, value) tuples"""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.bad_frames = 0
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        out = []
+        while self.buffer:
+            sync = self.buffer.find(bytearray([SYNC]))
+            newline = self.buffer.find(b'\n')
+            if newline >= 0 and (sync < 0 or newline < sync):
+                out.append(('text', printable(self.buffer[:newline])))
+                del self.buffer[:newline + 1]
+                continue
+            if sync < 0:
+                break
+            if sync > 0:
+                # Text before the frame, its line goes on after it
+                out.append(('partial', printable(self.buffer[:sync])))
+                del self.buffer[:sync]
+            if len(self.buffer) < 4:
+                break
+            length = 4 + self.buffer[3] + 2
+            if len(self.buffer) < length:
+                break
+            frame = self.buffer[:length]
+            crc = frame[-2] | (frame[-1] << 8)
+            values = varints(frame[4:-2]) if crc16(frame[1:-2]) == crc else None
+            if frame[1] != VERSION or values is None:
+                # Not a frame after all, drop the sync byte only
+                self.bad_frames += 1
+                del self.buffer[:1]
+                continue
+            out.append(('frame', (frame[2], values)))
+            del self.buffer[:length]
+        return out
+
+
+class Series(object):
+    """Frames to CSV rows"""
+
+    def __init__(self, output, rates):
+        self.output = output
+        self.rates = rates
+        self.time_ms = 0
+        self.sequence = None
+        self.lost_frames = 0
+        self.frames = 0
+        names = [name for name, _ in SLOTS]
+        self.output.write(','.join(['time_s'] + names + ['duty_percent']) + '\n')
+
+    def add(self, sequence, values):
+        lost = (sequence - self.sequence - 1) & 0xFF if self.sequence is not None else 0
+        self.lost_frames += lost
+        self.sequence = sequence
+        self.frames += 1
+
+        elapsed_ms, values = values[0], values[1:]
+        # Slots added by a later firmware are ignored, missing ones left empty
+        values = values[:len(SLOTS)] + [None] * (len(SLOTS) - len(values))
+        # The first frame covers the time since boot, lost ones about as
+        # long as this one
+        self.time_ms += elapsed_ms * (1 + lost) if self.frames > 1 else 0
+        row = ['%.3f' % (self.time_ms / 1000.0)]
+        for (name, kind), value in zip(SLOTS, values):
+            if value is None:
+                row.append('')
+            elif kind == 'counter' and self.rates:
+                row.append('%.1f' % (value * 1000.0 / elapsed_ms) if elapsed_ms else '')
+            else:
+                row.append('%d' % value)
+        busy = values[[name for name, _ in SLOTS].index('busy_us')]
+        row.append('%.3f' % (busy / (10.0 * elapsed_ms)) if busy is not None and elapsed_ms else '')
+        self.output.write(','.join(row) + '\n')
+        self.output.flush()
+
+
+def chunks(args):
+    """Bytes from the port, a file or stdin"""
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.5)
+        while True:
+            data = port.read(256)
+            if data:
+                yield data
+    else:
+        source = sys.stdin if args.input == '-' else open(args.input, 'rb')
+        source = getattr(source, 'buffer', source)
+        while True:
+            data = source.read(4096)
+            if not data:
+                break
+            yield data
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode the telemetry frames of the firmware serial output')
+    parser.add_argument('input', nargs='?', default='-', help='recorded output, - for stdin (default)')
+    parser.add_argument('--port', help='serial port of the board, instead of input')
+    parser.add_argument('--baud', type=int, default=115200, help='serial port speed (default 115200)')
+    parser.add_argument('-o', '--output', help='CSV file, stdout by default')
+    parser.add_argument('--text', help='file for the text lines, stderr by default')
+    parser.add_argument('--rates', action='store_true', help='counters per second instead of per frame')
+    args = parser.parse_args()
+
+    output = open(args.output, 'w') if args.output else sys.stdout
+    text = open(args.text, 'w') if args.text else sys.stderr
+    splitter = Splitter()
+    series = Series(output, args.rates)
+    line = ''
+
+    try:
+        for data in chunks(args):
+            for kind, value in splitter.feed(data):
+                if kind == 'frame':
+                    series.add(*value)
+                elif kind == 'partial':
+                    line += value
+                else:
+                    text.write(line + value + '\n')
+                    line = ''
+    except KeyboardInterrupt:
+        pass
+    if line:
+        text.write(line + '\n')
+
+    sys.stderr.write('%d frames, %d lost, %d bad\n' % (series.frames, series.lost_frames, splitter.bad_frames))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
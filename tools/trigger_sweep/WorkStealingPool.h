@@ -0,0 +1,133 @@
+/**
+*******************************************************************************
+* @file   WorkStealingPool.h
+* @brief  Fixed set of independent tasks run on all cores
+*******************************************************************************
+* Tasks are numbered 0..count-1 and dealt in contiguous runs to one queue
+* per worker. A worker takes its own tasks from the back of its queue and,
+* once it is empty, steals from the front of the others, so that long tasks
+* landing on the same worker do not leave the other cores idle. Tasks do not
+* create tasks: a worker finding every queue empty is done.
+*******************************************************************************
+*/
+
+#ifndef __WORK_STEALING_POOL_H__
+#define __WORK_STEALING_POOL_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Class Declaration ---------------------------------------------------------*/
+
+class WorkStealingPool
+{
+public:
+	explicit WorkStealingPool(unsigned workers) :
+		_queues(workers ? workers : 1)
+	{
+	}
+
+	unsigned workers() const
+	{
+		return (unsigned)_queues.size();
+	}
+
+	/**
+	 * @brief  Run task(0) to task(count - 1), returning once all are done
+	 *
+	 * @param  count number of tasks
+	 * @param  task called concurrently from the workers
+	 * @retval None
+	 */
+	void run(size_t count, const std::function<void(size_t)> &task)
+	{
+		size_t workers = _queues.size();
+		std::vector<std::thread> threads;
+
+		for (size_t w = 0; w < workers; w++) {
+			for (size_t t = count * w / workers; t < count * (w + 1) / workers; t++) {
+				_queues[w].tasks.push_back(t);
+			}
+		}
+		for (size_t w = 1; w < workers; w++) {
+			threads.push_back(std::thread(&WorkStealingPool::work, this, w, std::cref(task)));
+		}
+		work(0, task);
+		for (size_t w = 0; w < threads.size(); w++) {
+			threads[w].join();
+		}
+	}
+
+	/* Tasks taken from another worker queue during the last run() */
+	size_t steals() const
+	{
+		size_t steals = 0;
+
+		for (size_t w = 0; w < _queues.size(); w++) {
+			steals += _queues[w].steals;
+		}
+		return steals;
+	}
+
+private:
+	struct Queue {
+		Queue() : steals(0) {}
+
+		std::mutex lock;
+		std::deque<size_t> tasks;
+		size_t steals;
+	};
+
+	void work(size_t self, const std::function<void(size_t)> &task)
+	{
+		size_t next;
+
+		_queues[self].steals = 0;
+		for (;;) {
+			if (pop(self, &next)) {
+				task(next);
+			} else if (steal(self, &next)) {
+				_queues[self].steals++;
+				task(next);
+			} else {
+				return;
+			}
+		}
+	}
+
+	bool pop(size_t self, size_t *next)
+	{
+		std::lock_guard<std::mutex> guard(_queues[self].lock);
+
+		if (_queues[self].tasks.empty()) {
+			return false;
+		}
+		*next = _queues[self].tasks.back();
+		_queues[self].tasks.pop_back();
+		return true;
+	}
+
+	bool steal(size_t self, size_t *next)
+	{
+		for (size_t i = 1; i < _queues.size(); i++) {
+			Queue &victim = _queues[(self + i) % _queues.size()];
+			std::lock_guard<std::mutex> guard(victim.lock);
+
+			if (!victim.tasks.empty()) {
+				*next = victim.tasks.front();
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::vector<Queue> _queues;
+};
+
+#endif
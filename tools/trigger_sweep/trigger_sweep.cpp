@@ -0,0 +1,407 @@
+/**
+*******************************************************************************
+* @file   trigger_sweep.cpp
+* @brief  StrumTrigger parameter search on recorded captures, on all cores
+*******************************************************************************
+* Replays continuous captures through the firmware StrumTrigger for every
+* parameter set of a grid, or of a random search, and scores the detections
+* against the labelled strums. Detection follows Acquisition: once a strum
+* is detected, the window samples are captured without looking for strums,
+* then the trigger starts over.
+*
+* A capture is a raw file of little-endian float x, y, z triplets in g, at
+* --odr Hz. Its labels file (capture path + ".labels") holds the sample
+* index of each strum onset, one per line. Captures are memory mapped once
+* and shared read-only by the workers; each (parameter set, capture) pair is
+* a task of a work-stealing pool.
+*
+* A detection within --tolerance-ms of an unmatched onset is a hit. Ranked
+* by F1 score, the best parameter sets are printed with their precision and
+* recall, followed by the overall throughput.
+*
+* Build (from this directory, Linux):
+*   g++ -std=c++11 -O2 -pthread -I. -I../../src trigger_sweep.cpp \
+*       ../../src/StrumTrigger.cpp -o trigger_sweep
+*
+* Usage: trigger_sweep [options] capture...
+*   --mini LIST     mini-buffer lengths          (default 3:9:1)
+*   --thresh LIST   ratios                       (default 1.1:2.0:0.1)
+*   --noise LIST    noise floors in g            (default 0.05:0.3:0.05)
+*     LIST is v1,v2,.. or min:max:step; a random search draws in min:max
+*   --random N      N random parameter sets instead of the grid
+*   --seed S        random search seed           (default 1)
+*   --window N      window samples               (default 1024)
+*   --gap N         samples lost after a window  (default 0)
+*   --odr HZ        capture sample rate          (default 3330)
+*   --tolerance-ms  onset to detection tolerance (default 50)
+*   --threads N     workers                      (default all cores)
+*   --top N         parameter sets printed       (default 20)
+*******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "StrumTrigger.h"
+#include "WorkStealingPool.h"
+
+/* Typedefs ------------------------------------------------------------------*/
+
+typedef struct {
+	const char *path;
+	const float *xyz;			/* Mapped samples, read-only */
+	size_t samples;
+	size_t bytes;
+	std::vector<uint32_t> onsets;
+} Capture;
+
+typedef struct {
+	uint16_t mini;
+	float thresh;
+	float noise;
+} TriggerParams;
+
+typedef struct {
+	uint32_t detections;
+	uint32_t hits;
+	uint32_t onsets;
+	uint64_t samples;			/* Pushed to the trigger, windows excluded */
+} Score;
+
+typedef struct {
+	float first;
+	float last;
+	float step;
+	std::vector<float> values;	/* Explicit list, ranges leave it empty */
+} ParamRange;
+
+typedef struct {
+	uint16_t window;
+	uint32_t gap;
+	uint32_t tolerance;			/* In samples */
+} ReplayConfig;
+
+/********************************* Functions *********************************/
+
+/**
+ * @brief  Map a capture and load its labels
+ *
+ * @param  capture path set, the rest filled
+ * @retval false on error, reported on stderr
+ */
+bool open_capture(Capture *capture)
+{
+	struct stat st;
+	char labels[4096];
+	unsigned long onset;
+	FILE *file;
+	void *data;
+	int fd;
+
+	fd = open(capture->path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)(3 * sizeof(float))) {
+		fprintf(stderr, "%s: cannot read, or shorter than a sample\n", capture->path);
+		if (fd >= 0) {
+			close(fd);
+		}
+		return false;
+	}
+	capture->bytes = (size_t)st.st_size;
+	capture->samples = capture->bytes / (3 * sizeof(float));
+	data = mmap(NULL, capture->bytes, PROT_READ, MAP_SHARED, fd, 0);
+	/* The mapping keeps the file referenced */
+	close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "%s: mmap failed\n", capture->path);
+		return false;
+	}
+	/* Read once from start to end by every task */
+	madvise(data, capture->bytes, MADV_SEQUENTIAL | MADV_WILLNEED);
+	capture->xyz = (const float *)data;
+
+	snprintf(labels, sizeof(labels), "%s.labels", capture->path);
+	file = fopen(labels, "r");
+	if (!file) {
+		fprintf(stderr, "%s: missing\n", labels);
+		return false;
+	}
+	while (fscanf(file, "%lu", &onset) == 1) {
+		capture->onsets.push_back((uint32_t)onset);
+	}
+	fclose(file);
+	std::sort(capture->onsets.begin(), capture->onsets.end());
+
+	return true;
+}
+
+/**
+ * @brief  Replay a capture through StrumTrigger, as Acquisition does
+ *
+ * @param  params trigger parameters
+ * @param  capture samples and labels
+ * @param  config window, gap and tolerance
+ * @retval detections and hits
+ */
+Score replay(const TriggerParams &params, const Capture &capture, const ReplayConfig &config)
+{
+	StrumTrigger trigger(params.mini, params.thresh, params.noise);
+	Score score = { 0, 0, (uint32_t)capture.onsets.size(), 0 };
+	size_t next = 0, i = 0;
+
+	while (i < capture.samples) {
+		score.samples++;
+		if (!trigger.push(&capture.xyz[3 * i])) {
+			i++;
+			continue;
+		}
+		score.detections++;
+		/* Onsets left behind were missed */
+		while (next < capture.onsets.size() && capture.onsets[next] + config.tolerance < i) {
+			next++;
+		}
+		if (next < capture.onsets.size() && capture.onsets[next] <= i + config.tolerance) {
+			score.hits++;
+			next++;
+		}
+		/* Window captured, then the trigger starts over */
+		i += 1 + config.window + config.gap;
+		trigger.reset();
+	}
+
+	return score;
+}
+
+/**
+ * @brief  Parse v1,v2,.. or min:max[:step]
+ *
+ * @param  text option value
+ * @param  range parsed values
+ * @retval false on a syntax error
+ */
+bool parse_range(const char *text, ParamRange *range)
+{
+	char *end;
+
+	range->values.clear();
+	range->step = 0.0f;
+	if (strchr(text, ':')) {
+		range->first = strtof(text, &end);
+		if (*end != ':') {
+			return false;
+		}
+		range->last = strtof(end + 1, &end);
+		if (*end == ':') {
+			range->step = strtof(end + 1, &end);
+		}
+		return *end == '\0' && range->last >= range->first && range->step >= 0.0f;
+	}
+	while (*text) {
+		range->values.push_back(strtof(text, &end));
+		if (end == text || (*end != ',' && *end != '\0')) {
+			return false;
+		}
+		text = (*end == ',') ? end + 1 : end;
+	}
+	return !range->values.empty();
+}
+
+/* Grid values of a range, the first value only when no step is given */
+std::vector<float> grid_values(const ParamRange &range)
+{
+	std::vector<float> values = range.values;
+
+	if (values.empty()) {
+		for (int i = 0; range.first + i * range.step <= range.last + range.step * 1e-3f; i++) {
+			values.push_back(range.first + i * range.step);
+			if (range.step == 0.0f) {
+				break;
+			}
+		}
+	}
+	return values;
+}
+
+/* Uniform draw in a range, or among the listed values */
+float random_value(const ParamRange &range, uint32_t *seed)
+{
+	float unit;
+
+	*seed = *seed * 1664525u + 1013904223u;
+	unit = (float)(*seed >> 8) / (float)(1u << 24);
+	if (!range.values.empty()) {
+		return range.values[(size_t)(unit * range.values.size())];
+	}
+	return range.first + unit * (range.last - range.first);
+}
+
+void usage(void)
+{
+	fprintf(stderr, "usage: trigger_sweep [--mini LIST] [--thresh LIST] [--noise LIST] [--random N [--seed S]]\n"
+	        "                     [--window N] [--gap N] [--odr HZ] [--tolerance-ms MS] [--threads N]\n"
+	        "                     [--top N] capture...\n"
+	        "  LIST: v1,v2,.. or min:max:step\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	ParamRange mini = { 3.0f, 9.0f, 1.0f, std::vector<float>() };
+	ParamRange thresh = { 1.1f, 2.0f, 0.1f, std::vector<float>() };
+	ParamRange noise = { 0.05f, 0.3f, 0.05f, std::vector<float>() };
+	ReplayConfig config = { 1024, 0, 0 };
+	unsigned threads = std::thread::hardware_concurrency();
+	unsigned random = 0, top = 20;
+	uint32_t seed = 1;
+	float odr = 3330.0f, tolerance_ms = 50.0f;
+	std::vector<Capture> captures;
+	std::vector<TriggerParams> sets;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		const char *option = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (option[0] != '-') {
+			captures.push_back(Capture());
+			captures.back().path = option;
+			continue;
+		}
+		if (!value) {
+			usage();
+		}
+		i++;
+		if (strcmp(option, "--mini") == 0) {
+			if (!parse_range(value, &mini)) {
+				usage();
+			}
+		} else if (strcmp(option, "--thresh") == 0) {
+			if (!parse_range(value, &thresh)) {
+				usage();
+			}
+		} else if (strcmp(option, "--noise") == 0) {
+			if (!parse_range(value, &noise)) {
+				usage();
+			}
+		} else if (strcmp(option, "--random") == 0) {
+			random = (unsigned)atoi(value);
+		} else if (strcmp(option, "--seed") == 0) {
+			seed = (uint32_t)strtoul(value, NULL, 0);
+		} else if (strcmp(option, "--window") == 0) {
+			config.window = (uint16_t)atoi(value);
+		} else if (strcmp(option, "--gap") == 0) {
+			config.gap = (uint32_t)atoi(value);
+		} else if (strcmp(option, "--odr") == 0) {
+			odr = (float)atof(value);
+		} else if (strcmp(option, "--tolerance-ms") == 0) {
+			tolerance_ms = (float)atof(value);
+		} else if (strcmp(option, "--threads") == 0) {
+			threads = (unsigned)atoi(value);
+		} else if (strcmp(option, "--top") == 0) {
+			top = (unsigned)atoi(value);
+		} else {
+			usage();
+		}
+	}
+	if (captures.empty() || odr <= 0.0f) {
+		usage();
+	}
+	config.tolerance = (uint32_t)(tolerance_ms * odr / 1000.0f);
+
+	for (size_t c = 0; c < captures.size(); c++) {
+		if (!open_capture(&captures[c])) {
+			return 1;
+		}
+	}
+
+	if (random) {
+		for (unsigned r = 0; r < random; r++) {
+			TriggerParams params;
+
+			params.mini = (uint16_t)(random_value(mini, &seed) + 0.5f);
+			params.thresh = random_value(thresh, &seed);
+			params.noise = random_value(noise, &seed);
+			sets.push_back(params);
+		}
+	} else {
+		std::vector<float> minis = grid_values(mini), threshs = grid_values(thresh), noises = grid_values(noise);
+
+		for (size_t m = 0; m < minis.size(); m++) {
+			for (size_t t = 0; t < threshs.size(); t++) {
+				for (size_t n = 0; n < noises.size(); n++) {
+					TriggerParams params = { (uint16_t)(minis[m] + 0.5f), threshs[t], noises[n] };
+
+					sets.push_back(params);
+				}
+			}
+		}
+	}
+	for (size_t s = 0; s < sets.size(); s++) {
+		if (sets[s].mini == 0) {
+			fprintf(stderr, "MINI must be at least 1\n");
+			return 2;
+		}
+	}
+
+	/* One task per parameter set and capture, scores reduced afterwards */
+	WorkStealingPool pool(threads);
+	std::vector<Score> task_scores(sets.size() * captures.size());
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	pool.run(task_scores.size(), [&](size_t task) {
+		task_scores[task] = replay(sets[task / captures.size()], captures[task % captures.size()], config);
+	});
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::vector<Score> scores(sets.size());
+	std::vector<size_t> order(sets.size());
+	std::vector<double> f1(sets.size());
+	uint64_t samples = 0;
+
+	for (size_t s = 0; s < sets.size(); s++) {
+		Score total = { 0, 0, 0, 0 };
+
+		for (size_t c = 0; c < captures.size(); c++) {
+			const Score &score = task_scores[s * captures.size() + c];
+
+			total.detections += score.detections;
+			total.hits += score.hits;
+			total.onsets += score.onsets;
+			total.samples += score.samples;
+		}
+		scores[s] = total;
+		samples += total.samples;
+		f1[s] = (total.detections + total.onsets) ? 2.0 * total.hits / (total.detections + total.onsets) : 0.0;
+		order[s] = s;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return f1[a] > f1[b]; });
+
+	printf("%5s %7s %7s %10s %6s %7s %9s %6s %6s\n",
+	       "MINI", "THRESH", "NOISE", "detections", "hits", "onsets", "precision", "recall", "F1");
+	for (size_t r = 0; r < order.size() && r < top; r++) {
+		const TriggerParams &params = sets[order[r]];
+		const Score &score = scores[order[r]];
+
+		printf("%5u %7.3f %7.3f %10lu %6lu %7lu %9.3f %6.3f %6.3f\n",
+		       (unsigned)params.mini, params.thresh, params.noise, (unsigned long)score.detections,
+		       (unsigned long)score.hits, (unsigned long)score.onsets,
+		       score.detections ? (double)score.hits / score.detections : 0.0,
+		       score.onsets ? (double)score.hits / score.onsets : 0.0, f1[order[r]]);
+	}
+	printf("%lu parameter sets x %lu captures, %llu samples in %.3f s: %.3g samples/s on %u workers, %lu steals\n",
+	       (unsigned long)sets.size(), (unsigned long)captures.size(), (unsigned long long)samples, seconds,
+	       seconds > 0.0 ? samples / seconds : 0.0, pool.workers(), (unsigned long)pool.steals());
+
+	for (size_t c = 0; c < captures.size(); c++) {
+		munmap((void *)captures[c].xyz, captures[c].bytes);
+	}
+	return 0;
+}